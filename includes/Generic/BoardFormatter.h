@@ -0,0 +1,234 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstdio>
+#include <cstddef>
+
+namespace wubinboardgames
+{
+  /* Text formats of the cells of a board, all read back by BoardTextReader.
+       grid:     the .board format of operator<<, right aligned in columns of two with
+                 a space between boxes and an empty line between rows of boxes.
+       one_line: one character per cell, '.' for a vacant cell, 1 to 9 then A, B...
+                 for every type of cell, and a line break.
+       csv:      the values separated by commas, 0 for a vacant cell, and a line break.
+     Inactive cells (of samurai boards) are blank in the grid, and left out of the
+     other formats.
+  */
+  enum class BoardFormat
+  {
+    grid,
+    one_line,
+    csv
+  };
+
+  // the longest text of a value: one character for char cells, the digits of the type otherwise.
+  template<typename Board>
+  constexpr std::size_t MaxCellTextLength()
+  {
+    return (1 == sizeof(typename Board::Cell::ValueType)) ?
+        1 : static_cast<std::size_t>(std::numeric_limits<typename Board::Cell::ValueType>::digits10) + 2;
+  }
+
+  // room FormatBoard needs for any board of type Board, line breaks included.
+  template<typename Board>
+  constexpr std::size_t MaxFormattedLength(BoardFormat format)
+  {
+    return (BoardFormat::grid == format) ?
+        Board::width * (Board::width * (MaxCellTextLength<Board>() + 3) + Board::width / Board::box_width + 2) +
+            Board::width / Board::box_height + 1 :
+        ((BoardFormat::one_line == format) ? Board::width * Board::width + 1 :
+                                             Board::width * Board::width * (MaxCellTextLength<Board>() + 1) + 1);
+  }
+
+  // the decimal digits of value at out. Returns the end of the text.
+  inline char * WriteDecimal(unsigned long long value, char * out)
+  {
+    char digits[std::numeric_limits<unsigned long long>::digits10 + 1];
+    unsigned int length = 0;
+    do
+    {
+      digits[length++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while(value);
+    while(length)
+      *out++ = digits[--length];
+    return out;
+  }
+
+  /* Lay out width x width fields the way .board files do. Every field is right aligned
+     on two characters and followed by a space, with one more space after every
+     box_width columns and an empty line after every box_height rows. Trailing spaces
+     are dropped. write_field(index, out) writes the field of a cell at out, at most
+     MaxCellTextLength characters, and returns its end.
+  */
+  template<typename WriteField>
+  char * WriteBoardGrid(char * out, unsigned int width, unsigned int box_height, unsigned int box_width,
+                        WriteField write_field)
+  {
+    for(unsigned int row = 0; row < width; ++row)
+    {
+      char * const row_begin = out;
+      for(unsigned int col = 0; col < width; ++col)
+      {
+        char field[std::numeric_limits<unsigned long long>::digits10 + 2];
+        const char * const field_end = write_field(row * width + col, field);
+        for(const char * pad = field_end; pad < field + 2; ++pad)
+          *out++ = ' ';
+        for(const char * c = field; c != field_end; ++c)
+          *out++ = *c;
+        *out++ = ' ';
+        if((col + 1) % box_width == 0)
+          *out++ = ' ';
+      }
+      while(out != row_begin && ' ' == out[-1])
+        --out;
+      *out++ = '\n';
+      if((row + 1) % box_height == 0)
+        *out++ = '\n';
+    }
+    return out;
+  }
+
+  /* Write the cells of board in format into buffer, without allocating. Returns the
+     length of the text, or 0 (nothing written) if capacity is below
+     MaxFormattedLength<Board>(format).
+  */
+  template<typename Board>
+  std::size_t FormatBoard(const Board & board, BoardFormat format, char * buffer, std::size_t capacity)
+  {
+    typedef typename Board::Cell Cell;
+    typedef typename Cell::ValueType ValueType;
+    constexpr unsigned int width = Board::width;
+    constexpr bool is_char_cell = 1 == sizeof(ValueType);
+    if(capacity < MaxFormattedLength<Board>(format))
+      return 0;
+
+    const auto & layout = board.layout();
+    auto write_value = [&board](unsigned int index, char * out)
+    {
+      const Cell & cell = board[index / width][index % width];
+      if(cell.isVacant())
+      {
+        *out++ = '0';
+        return out;
+      }
+      if(is_char_cell)
+      {
+        *out++ = static_cast<char>(static_cast<ValueType>(cell));
+        return out;
+      }
+      // vacant cells are the only ones below minimum_value, so the value is not negative.
+      return WriteDecimal(static_cast<unsigned long long>(static_cast<ValueType>(cell)), out);
+    };
+
+    char * out = buffer;
+    if(BoardFormat::grid == format)
+    {
+      out = WriteBoardGrid(out, width, Board::box_height, Board::box_width,
+                           [&layout, &write_value](unsigned int index, char * field)
+                           {
+                             return layout.isActive(index) ? write_value(index, field) : field;
+                           });
+      return static_cast<std::size_t>(out - buffer);
+    }
+
+    for(unsigned int index = 0; index < width * width; ++index)
+    {
+      if(!layout.isActive(index))
+        continue;
+      const Cell & cell = board[index / width][index % width];
+      if(BoardFormat::csv == format)
+      {
+        out = write_value(index, out);
+        *out++ = ',';
+      }
+      else if(cell.isVacant())
+        *out++ = '.';
+      else
+      {
+        const unsigned int digit = static_cast<unsigned int>(static_cast<ValueType>(cell) - Cell::minimum_value) + 1;
+        *out++ = static_cast<char>(digit < 10 ? '0' + digit : 'A' + (digit - 10));
+      }
+    }
+    if(BoardFormat::csv == format && out != buffer)
+      --out;
+    *out++ = '\n';
+    return static_cast<std::size_t>(out - buffer);
+  }
+
+  /* BoardBatchWriter gathers the text of many boards in one buffer, so they reach a
+     file with a single write. The buffer only grows when the next board may not fit:
+     reserve enough room up front and adding boards allocates nothing.
+  */
+  class BoardBatchWriter
+  {
+  public:
+    explicit BoardBatchWriter(std::size_t capacity = 1 << 16);
+
+    template<typename Board>
+    void add(const Board & board, BoardFormat format);
+
+    const char * data() const;
+    std::size_t size() const;
+    void clear();
+
+    /* Write everything gathered to file with one fwrite, then clear. Nothing is
+       cleared if the write fails.
+    */
+    bool flush(std::FILE * file);
+    // the same into a new file at path, unbuffered so that it takes a single write.
+    bool writeToFile(const std::string & path);
+
+  private:
+    std::vector<char> text;
+    std::size_t used = 0;
+  };
+
+  inline BoardBatchWriter::BoardBatchWriter(std::size_t capacity) : text(capacity) {}
+
+  template<typename Board>
+  void BoardBatchWriter::add(const Board & board, BoardFormat format)
+  {
+    const std::size_t room = MaxFormattedLength<Board>(format);
+    if(text.size() - used < room)
+      text.resize(std::max(2 * text.size(), used + room));
+    used += FormatBoard(board, format, text.data() + used, text.size() - used);
+  }
+
+  inline const char * BoardBatchWriter::data() const
+  {
+    return text.data();
+  }
+
+  inline std::size_t BoardBatchWriter::size() const
+  {
+    return used;
+  }
+
+  inline void BoardBatchWriter::clear()
+  {
+    used = 0;
+  }
+
+  inline bool BoardBatchWriter::flush(std::FILE * file)
+  {
+    if(used && std::fwrite(text.data(), 1, used, file) != used)
+      return false;
+    used = 0;
+    return 0 == std::fflush(file);
+  }
+
+  inline bool BoardBatchWriter::writeToFile(const std::string & path)
+  {
+    std::FILE * file = std::fopen(path.c_str(), "wb");
+    if(!file)
+      return false;
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    const bool is_written = flush(file);
+    return (0 == std::fclose(file)) && is_written;
+  }
+}
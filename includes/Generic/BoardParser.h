@@ -0,0 +1,348 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+
+namespace wubinboardgames
+{
+  /* BoardTextReader parses board files straight from a char buffer, without streams
+     or locales. Cells come in either of two formats:
+
+       - the .board format written by operator<<: cells separated by whitespace
+         (or commas, as in csv), 0 for a vacant cell. Boards up to 9 wide may also pack the cells of a row
+         (or of the whole board) without separators.
+       - the one-line format: every cell is one character, '.' or '0' for a vacant
+         cell, the whole board on a single line.
+
+     Cells are numbers or letters. A board with no digit other than 0 is alphabetic:
+     'a' is 1, 'b' is 2 and so on. Otherwise letters carry on after 9, 'a' being 10, as
+     in 16x16 boards written 1-9 then A-G. So do the letters of boards wider than 9
+     written one character per cell. Letters are not case sensitive.
+     The first error is kept with its line and column (both start at 1).
+  */
+  class BoardTextReader
+  {
+  public:
+    BoardTextReader(const char * begin, const char * end);
+    explicit BoardTextReader(const std::string & text);
+
+    /* Read count cells whose values go from 1 to max_digit (at most 36) into
+       digits, 0 for a vacant cell. Nothing is consumed on failure.
+    */
+    bool readCells(unsigned int max_digit, uint8_t * digits, unsigned int count);
+    // read a number from 0 to maximum, as the cages of killer boards.
+    bool readNumber(unsigned int & number, unsigned int maximum);
+
+    // true if only whitespace (and commas) is left.
+    bool atEnd();
+    // fail unless only whitespace is left.
+    bool expectEnd();
+    // record an error at the current position, for the checks of the callers. Returns false.
+    bool fail(const std::string & what);
+
+    bool failed() const;
+    // true if the failure was the text ending before all the cells or numbers were read.
+    bool isTruncated() const;
+    // "line L, column C: what went wrong", empty if nothing failed.
+    const std::string & error() const;
+    unsigned int errorLine() const;
+    unsigned int errorColumn() const;
+
+  private:
+    bool failAt(const char * position, const std::string & what);
+    void skipSpaces();
+
+    static bool isSpace(char c);
+    static bool isDigit(char c);
+    static constexpr unsigned int number_of_letters = 26;
+    // index of a letter from 0 for 'a' or 'A', number_of_letters for other characters.
+    static unsigned int letterIndex(char c);
+
+    const char * text_begin;
+    const char * current;
+    const char * text_end;
+    std::string error_message;
+    unsigned int error_line = 0;
+    unsigned int error_column = 0;
+    bool is_truncated = false;
+  };
+
+  inline BoardTextReader::BoardTextReader(const char * begin, const char * end)
+    : text_begin(begin), current(begin), text_end(end) {}
+
+  inline BoardTextReader::BoardTextReader(const std::string & text)
+    : BoardTextReader(text.data(), text.data() + text.size()) {}
+
+  // spaces, tabs, line breaks, the other control characters, and the commas of csv.
+  inline bool BoardTextReader::isSpace(char c)
+  {
+    return static_cast<unsigned char>(c) <= ' ' || ',' == c;
+  }
+
+  inline bool BoardTextReader::isDigit(char c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  inline unsigned int BoardTextReader::letterIndex(char c)
+  {
+    if(c >= 'a' && c <= 'z')
+      return static_cast<unsigned int>(c - 'a');
+    if(c >= 'A' && c <= 'Z')
+      return static_cast<unsigned int>(c - 'A');
+    return number_of_letters;
+  }
+
+  inline void BoardTextReader::skipSpaces()
+  {
+    while(current != text_end && isSpace(*current))
+      ++current;
+  }
+
+  inline bool BoardTextReader::failAt(const char * position, const std::string & what)
+  {
+    if(failed())
+      return false;
+    error_line = 1;
+    const char * line_begin = text_begin;
+    for(const char * c = text_begin; c != position; ++c)
+    {
+      if('\n' == *c)
+      {
+        ++error_line;
+        line_begin = c + 1;
+      }
+    }
+    error_column = static_cast<unsigned int>(position - line_begin) + 1;
+    error_message = "line " + std::to_string(error_line) + ", column " + std::to_string(error_column) + ": " + what;
+    return false;
+  }
+
+  inline bool BoardTextReader::fail(const std::string & what)
+  {
+    skipSpaces();
+    return failAt(current, what);
+  }
+
+  inline bool BoardTextReader::readCells(unsigned int max_digit, uint8_t * digits, unsigned int count)
+  {
+    constexpr uint8_t letter_flag = 0x80;
+    skipSpaces();
+    // locals, as stores to digits may alias the members.
+    const char * position = current;
+    const char * const end = text_end;
+    // wide boards have numbers of two digits, unless a run of count characters holds the board.
+    bool is_packed = max_digit <= 9;
+    if(!is_packed)
+    {
+      const char * run_end = position;
+      while(run_end != end && !isSpace(*run_end))
+        ++run_end;
+      is_packed = static_cast<unsigned int>(run_end - position) == count;
+    }
+
+    bool has_digits = false;
+    unsigned int max_letter = 0;
+    const char * max_letter_position = nullptr;
+    unsigned int index = 0;
+    while(index < count && position != end)
+    {
+      const char c = *position;
+      const unsigned int digit = static_cast<unsigned int>(static_cast<unsigned char>(c)) - '0';
+      if(digit < 10)
+      {
+        const char * number_begin = position++;
+        unsigned int number = digit;
+        while(!is_packed && position != end && isDigit(*position) && number <= max_digit)
+          number = number * 10 + static_cast<unsigned int>(*position++ - '0');
+        if(number > max_digit)
+          return failAt(number_begin, "cell value out of range 0 to " + std::to_string(max_digit));
+        has_digits = has_digits || number > 0;
+        digits[index++] = static_cast<uint8_t>(number);
+      }
+      else if(isSpace(c))
+      {
+        ++position;
+        continue;
+      }
+      else if('.' == c)
+      {
+        digits[index++] = 0;
+        ++position;
+      }
+      else if(letterIndex(c) < number_of_letters)
+      {
+        if(!max_letter_position || letterIndex(c) > max_letter)
+        {
+          max_letter = letterIndex(c);
+          max_letter_position = position;
+        }
+        digits[index++] = static_cast<uint8_t>(letter_flag | letterIndex(c));
+        ++position;
+      }
+      else
+        return failAt(position, std::string("unexpected character '") + c + "'");
+      if(!is_packed && position != end && !isSpace(*position))
+        return failAt(position, std::string("expected a separator, found '") + *position + "'");
+    }
+    if(index < count)
+    {
+      is_truncated = !failed();
+      return failAt(position, "expected " + std::to_string(count) + " cells, found " + std::to_string(index));
+    }
+
+    if(max_letter_position)
+    {
+      const unsigned int letter_base = (has_digits || (is_packed && max_digit > 9)) ? 10 : 1;
+      if(letter_base + max_letter > max_digit)
+        return failAt(max_letter_position, "cell value out of range 0 to " + std::to_string(max_digit));
+      for(unsigned int cell = 0; cell < count; ++cell)
+      {
+        if(digits[cell] & letter_flag)
+          digits[cell] = static_cast<uint8_t>(letter_base + (digits[cell] & ~letter_flag));
+      }
+    }
+    current = position;
+    return true;
+  }
+
+  inline bool BoardTextReader::readNumber(unsigned int & number, unsigned int maximum)
+  {
+    skipSpaces();
+    if(current == text_end)
+    {
+      is_truncated = !failed();
+      return failAt(current, "expected a number, found the end of the text");
+    }
+    if(!isDigit(*current))
+      return failAt(current, std::string("expected a number, found '") + *current + "'");
+    const char * number_begin = current;
+    unsigned long long value = 0;
+    while(current != text_end && isDigit(*current) && value <= maximum)
+      value = value * 10 + static_cast<unsigned int>(*current++ - '0');
+    if(value > maximum)
+      return failAt(number_begin, "number out of range 0 to " + std::to_string(maximum));
+    if(current != text_end && !isSpace(*current))
+      return failAt(current, std::string("expected a separator, found '") + *current + "'");
+    number = static_cast<unsigned int>(value);
+    return true;
+  }
+
+  inline bool BoardTextReader::atEnd()
+  {
+    skipSpaces();
+    return current == text_end;
+  }
+
+  inline bool BoardTextReader::expectEnd()
+  {
+    return atEnd() || failAt(current, "unexpected text after the board");
+  }
+
+  inline bool BoardTextReader::failed() const
+  {
+    return !error_message.empty();
+  }
+
+  inline bool BoardTextReader::isTruncated() const
+  {
+    return is_truncated;
+  }
+
+  inline const std::string & BoardTextReader::error() const
+  {
+    return error_message;
+  }
+
+  inline unsigned int BoardTextReader::errorLine() const
+  {
+    return error_line;
+  }
+
+  inline unsigned int BoardTextReader::errorColumn() const
+  {
+    return error_column;
+  }
+
+  // the whole content of a file. stdio, as opening an fstream costs more than reading a board.
+  inline bool ReadTextFile(const std::string & path, std::string & text)
+  {
+    std::FILE * file = std::fopen(path.c_str(), "rb");
+    if(!file)
+      return false;
+    text.clear();
+    char buffer[4096];
+    std::size_t length = 0;
+    while((length = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+      text.append(buffer, length);
+    const bool is_read = !std::ferror(file);
+    std::fclose(file);
+    return is_read;
+  }
+
+  /* Parse a whole text as one board of type Board, through Board::parse(). Nothing
+     but whitespace may follow the board. On failure the board is unchanged and error,
+     if given, tells where the text went wrong.
+  */
+  template<typename Board>
+  bool ParseBoardText(const char * begin, const char * end, Board & board, std::string * error = nullptr)
+  {
+    BoardTextReader reader(begin, end);
+    // parse() writes as it goes, and the end is only checked after it.
+    Board parsed_board{board};
+    if(parsed_board.parse(reader) && reader.expectEnd())
+    {
+      board = parsed_board;
+      return true;
+    }
+    if(error)
+      *error = reader.error();
+    return false;
+  }
+
+  template<typename Board>
+  bool LoadBoardFile(const std::string & path, Board & board, std::string * error = nullptr)
+  {
+    std::string text;
+    if(!ReadTextFile(path, text))
+    {
+      if(error)
+        *error = "cannot read " + path;
+      return false;
+    }
+    if(ParseBoardText(text.data(), text.data() + text.size(), board, error))
+      return true;
+    if(error)
+      *error = path + ": " + *error;
+    return false;
+  }
+
+  /* operator>> of boards. Lines are read until they hold a whole board, so boards
+     written one after another to a stream are read back one by one. Nothing but
+     whitespace may follow a board on its last line. failbit is set if the lines read
+     are not a board, and the board is then unchanged.
+  */
+  template<typename Board>
+  std::istream & ReadBoard(std::istream & is, Board & board)
+  {
+    std::string text, line;
+    while(std::getline(is, line))
+    {
+      text += line;
+      text += '\n';
+      BoardTextReader reader(text);
+      Board parsed_board{board};
+      if(parsed_board.parse(reader) && reader.expectEnd())
+      {
+        board = parsed_board;
+        return is;
+      }
+      if(!reader.isTruncated())
+        break;
+    }
+    is.setstate(std::istream::failbit);
+    return is;
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+namespace wubinboardgames
+{
+  // how often a DeadlineFlag polls the flag it follows.
+  constexpr std::chrono::milliseconds DEADLINE_POLL_INTERVAL{10};
+
+  /* DeadlineFlag turns a deadline into the std::atomic<bool> the long running loops of
+     the engine give up on: a thread of its own sets flag() at deadline, or as soon as
+     the followed flag, if any, is set. A flag already due is set on construction. The
+     thread is stopped and joined on destruction.
+  */
+  class DeadlineFlag
+  {
+  public:
+    explicit DeadlineFlag(std::chrono::steady_clock::time_point deadline,
+                          const std::atomic<bool> * followed = nullptr);
+    ~DeadlineFlag();
+    DeadlineFlag(const DeadlineFlag &) = delete;
+    DeadlineFlag & operator=(const DeadlineFlag &) = delete;
+
+    const std::atomic<bool> * flag() const;
+
+  private:
+    void run(std::chrono::steady_clock::time_point deadline, const std::atomic<bool> * followed);
+
+    std::atomic<bool> is_set{false};
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool is_stopping = false;
+    std::thread timer;
+  };
+
+  inline DeadlineFlag::DeadlineFlag(std::chrono::steady_clock::time_point deadline, const std::atomic<bool> * followed)
+    : is_set(std::chrono::steady_clock::now() >= deadline || (followed && followed->load(std::memory_order_relaxed))),
+      timer(&DeadlineFlag::run, this, deadline, followed)
+  {
+  }
+
+  inline DeadlineFlag::~DeadlineFlag()
+  {
+    {
+      std::lock_guard<std::mutex> lock(stop_mutex);
+      is_stopping = true;
+    }
+    stop_cv.notify_one();
+    timer.join();
+  }
+
+  inline const std::atomic<bool> * DeadlineFlag::flag() const
+  {
+    return &is_set;
+  }
+
+  inline void DeadlineFlag::run(std::chrono::steady_clock::time_point deadline, const std::atomic<bool> * followed)
+  {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+    while(!is_stopping && std::chrono::steady_clock::now() < deadline &&
+          !(followed && followed->load(std::memory_order_relaxed)))
+    {
+      const std::chrono::steady_clock::time_point next_poll = std::chrono::steady_clock::now() + DEADLINE_POLL_INTERVAL;
+      stop_cv.wait_until(lock, followed ? std::min(deadline, next_poll) : deadline);
+    }
+    is_set.store(true, std::memory_order_relaxed);
+  }
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <stdexcept>
+
+namespace wubinboardgames
+{
+  /* FirstResultRace hands the first result offered by any of the tasks racing for it
+     over to whoever waits on its future. Offers compete on one compare and swap: the
+     winner alone sets the promise, so no lock is taken, and later offers are
+     dropped. Once the race is won or cancelled, stopFlag() is set for the runners
+     still at work to give up.
+     If the race is cancelled, or all the runners started by RunRace are done without
+     a result, the future holds a std::runtime_error instead.
+  */
+  template<typename Result>
+  class FirstResultRace
+  {
+  public:
+    FirstResultRace();
+    FirstResultRace(const FirstResultRace &) = delete;
+    FirstResultRace & operator=(const FirstResultRace &) = delete;
+
+    // true if result won the race, and is now the result of the future.
+    bool offer(Result result);
+    // end the race without a winner, if it is not over yet.
+    void cancel();
+    bool isOver() const;
+    // set once the race is over, for the runners to stop. Relaxed loads are enough.
+    const std::atomic<bool> & stopFlag() const;
+    // the future of the result. Only once.
+    std::future<Result> takeFuture();
+
+    template<typename R, typename Task>
+    friend void RunRace(const std::shared_ptr<FirstResultRace<R>> & race, unsigned int num_of_runners, Task task);
+
+  private:
+    enum State
+    {
+      open,
+      setting,
+      over
+    };
+
+    // claim the race for the caller. Only one claim ever succeeds.
+    bool claim();
+    void fail(const char * why);
+    void runnerDone();
+
+    std::atomic<int> state{open};
+    std::atomic<bool> is_stopped{false};
+    std::atomic<unsigned int> num_of_runners{0};
+    std::promise<Result> result_promise;
+  };
+
+  template<typename Result>
+  FirstResultRace<Result>::FirstResultRace() = default;
+
+  template<typename Result>
+  inline bool FirstResultRace<Result>::claim()
+  {
+    int expected = open;
+    if(!state.compare_exchange_strong(expected, setting, std::memory_order_acq_rel))
+      return false;
+    is_stopped.store(true, std::memory_order_relaxed);
+    return true;
+  }
+
+  template<typename Result>
+  bool FirstResultRace<Result>::offer(Result result)
+  {
+    if(!claim())
+      return false;
+    result_promise.set_value(std::move(result));
+    state.store(over, std::memory_order_release);
+    return true;
+  }
+
+  template<typename Result>
+  void FirstResultRace<Result>::fail(const char * why)
+  {
+    if(!claim())
+      return;
+    result_promise.set_exception(std::make_exception_ptr(std::runtime_error(why)));
+    state.store(over, std::memory_order_release);
+  }
+
+  template<typename Result>
+  inline void FirstResultRace<Result>::cancel()
+  {
+    fail("race cancelled");
+  }
+
+  template<typename Result>
+  inline bool FirstResultRace<Result>::isOver() const
+  {
+    return open != state.load(std::memory_order_acquire);
+  }
+
+  template<typename Result>
+  inline const std::atomic<bool> & FirstResultRace<Result>::stopFlag() const
+  {
+    return is_stopped;
+  }
+
+  template<typename Result>
+  inline std::future<Result> FirstResultRace<Result>::takeFuture()
+  {
+    return result_promise.get_future();
+  }
+
+  template<typename Result>
+  inline void FirstResultRace<Result>::runnerDone()
+  {
+    if(1 == num_of_runners.fetch_sub(1, std::memory_order_acq_rel))
+      fail("no runner found a result");
+  }
+
+  /* Start num_of_runners detached threads, each running task(runner, *race) with
+     runner from 0 to num_of_runners - 1. Tasks offer their result to the race, and
+     should watch its stopFlag(). The threads keep race alive as long as they run, so
+     the caller may drop it without waiting for them.
+  */
+  template<typename Result, typename Task>
+  void RunRace(const std::shared_ptr<FirstResultRace<Result>> & race, unsigned int num_of_runners, Task task)
+  {
+    race->num_of_runners.fetch_add(num_of_runners, std::memory_order_relaxed);
+    for(unsigned int runner = 0; runner < num_of_runners; ++runner)
+    {
+      std::thread([race, task, runner]() mutable
+      {
+        task(runner, *race);
+        race->runnerDone();
+      }).detach();
+    }
+  }
+}
@@ -12,22 +12,39 @@
 #include <functional>
 
 #include "Position.h"
+#include "Zobrist.h"
+#include "RegionLayout.h"
+#include "BoardParser.h"
+#include "BoardFormatter.h"
 
 namespace wubinboardgames
 {
   constexpr const char * DEFAULT_FILE_NAME = "Board.data";
 
+  constexpr unsigned int IntegerSqrt(unsigned int value, unsigned int root = 0)
+  {
+    return ((root + 1) * (root + 1) > value) ? root : IntegerSqrt(value, root + 1);
+  }
+
   /*GenericBoard is a template class that can be instantiated to hold any
     type of cells and width. The number of cells is specialized by WIDTH * WIDTH
+    Boxes are BOX_HEIGHT rows by BOX_WIDTH columns. By default they are as square as
+    WIDTH allows: 3x3 for 9*9 sudoku, 2x3 for 6*6, 2x4 for 8*8, 3x4 for 12*12.
   */
-  template<typename CELL, unsigned int WIDTH = CELL::values_length>
+  template<typename CELL, unsigned int WIDTH = CELL::values_length,
+           unsigned int BOX_HEIGHT = IntegerSqrt(WIDTH), unsigned int BOX_WIDTH = WIDTH / BOX_HEIGHT>
   struct  GenericBoard
   {
     static constexpr unsigned int width = WIDTH;
+    // size of each box (grid). Known at compile time, so every index computation on
+    // the box of a cell is folded by the compiler.
+    static constexpr unsigned int box_height = BOX_HEIGHT;
+    static constexpr unsigned int box_width = BOX_WIDTH;
     typedef CELL Cell;
     typedef std::array<CELL, width> Row;
     typedef std::array<Row, width> Board;
     typedef std::array<std::array<typename CELL::ValueType, width>, width> RawValueBoard;
+    typedef ZobristKeys<CELL, WIDTH> Keys;
 
     GenericBoard();
     // rule of five
@@ -49,12 +66,36 @@ namespace wubinboardgames
     bool operator==(const RawValueBoard & rawValueBoard) const;
 
     bool writeToFile(const std::string & path = DEFAULT_FILE_NAME) const;
+    // false if the file cannot be read or is not a board. LoadBoardFile tells why.
     bool loadFromFile(const std::string & path);
+    /* Read the cells from reader, in any format BoardTextReader accepts. The board is
+       unchanged and false is returned if they are not cells of the board.
+    */
+    bool parse(BoardTextReader & reader);
 
     void clear();
     void backup();
     void reset();
 
+    /* Zobrist hash of the board. It is XOR-updated by assign() and vacate(), and kept
+       by clear(), backup() and reset(), so reading it is O(1).
+       Writing cells through operator[] bypasses the hash. Call rehash() after that.
+       Built with -D_no_board_hash, nothing is kept and hash() walks every cell.
+    */
+    uint64_t hash() const;
+    // recompute the hash from every cell. O(width * width)
+    uint64_t rehash();
+    void assign(const unsigned int & row, const unsigned int & col, const typename CELL::ValueType & value);
+    void vacate(const unsigned int & row, const unsigned int & col);
+
+    /* The cells which must hold different values: rows, columns and box_height x
+       box_width boxes. Boards of other shapes hide it with their own layout() and
+       set has_box_layout to false, so the solvers know they cannot compute the
+       units of a cell from its row and column.
+    */
+    static constexpr bool has_box_layout = true;
+    const RegionLayout & layout() const;
+
     // I admit it is not a good practice to expose the underling row...
     // But to make the board easy to be accessed.
     Row & operator[](const unsigned int & row_num);
@@ -64,66 +105,42 @@ namespace wubinboardgames
 
     friend std::ostream & operator<<(std::ostream & os, const GenericBoard & genericBoard)
     {
-      // content is used to remove the trailling spaces
-      // not a good practice, but it works for now.
-      std::string content;
-      const unsigned int cubic_width = std::sqrt(GenericBoard::width);
-      for(unsigned int row = 0; row < width; ++row)
-      {
-        // stringstream to remove the trailling spaces
-        // not a good practice, but it works for now.
-        std::stringstream row_str;
-        for(unsigned int col = 0; col < width; ++col)
-        {
-          if(genericBoard.board[row][col].isVacant())
-          {
-            // width 2 for 16*16 board
-            row_str.width(2);
-            row_str << '0' << " ";
-          }
-          else
-          {
-            row_str.width(2);
-            row_str << genericBoard.board[row][col] << " ";
-          }
-          // for 9*9 sudoku, add a space between each 3 columns
-          if ((col + 1) % cubic_width == 0)
-            row_str << " ";
-        }
-        content = row_str.str();
-        content.replace(content.size()-2, 2, "");
-        os << content;
-        os << "\n";
-        if((row + 1) % cubic_width == 0)
-          os << "\n";
-      }
+      // the text is built on the stack, see FormatBoard.
+      char text[MaxFormattedLength<GenericBoard>(BoardFormat::grid)];
+      os.write(text, static_cast<std::streamsize>(FormatBoard(genericBoard, BoardFormat::grid, text, sizeof(text))));
       return os;
     }
 
     friend std::istream & operator>>(std::istream & is, GenericBoard & genericBoard)
     {
-      constexpr unsigned int end_index = width * width;
-      unsigned int row = 0, col = 0;
-      for(unsigned int index = 0; index < end_index; ++index)
-      {
-        row = index / width;
-        col = index % width;
-        // this requires the CELL must overload its own input operator
-        is >> genericBoard.board[row][col];
-      }
-      return is;
+      return ReadBoard(is, genericBoard);
     }
 
     private:
+    // key of the value held by a cell, 0 for vacant or out-of-range cells.
+    uint64_t cellKey(const unsigned int & row, const unsigned int & col) const;
+
     Board board;
     Board backup_board;
+    uint64_t zobrist_hash = 0;
+    uint64_t backup_zobrist_hash = 0;
   };
 
-  template<typename CELL, unsigned int WIDTH>
-  GenericBoard<CELL, WIDTH>::GenericBoard()
+  // hasher so that boards can be used as keys of unordered containers.
+  template<typename GenericBoardType>
+  struct GenericBoardHasher
   {
-    // check in compile-time. do not allow width > 17 or width < 4
-    static_assert(width < 17, "Width of the board cannot be larger than 16.");
+    std::size_t operator() (const GenericBoardType & board) const
+    {
+      return static_cast<std::size_t>(board.hash());
+    }
+  };
+
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::GenericBoard()
+  {
+    // check in compile-time. do not allow width > 36 or width < 4
+    static_assert(width < 37, "Width of the board cannot be larger than 36.");
     static_assert(width > 3, "Width of the board cannot be less than 4");
     constexpr unsigned int end_index = width * width;
     unsigned int row = 0, col = 0;
@@ -137,16 +154,20 @@ namespace wubinboardgames
     }
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  GenericBoard<CELL, WIDTH>::GenericBoard(const Board & anotherBoard) : board(anotherBoard)
-  {}
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::GenericBoard(const Board & anotherBoard) : board(anotherBoard)
+  {
+    rehash();
+  }
 
-  template<typename CELL, unsigned int WIDTH>
-  GenericBoard<CELL,WIDTH>::GenericBoard(Board && anotherBoard) : board(anotherBoard)
-  {}
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::GenericBoard(Board && anotherBoard) : board(anotherBoard)
+  {
+    rehash();
+  }
 
-  template<typename CELL, unsigned int WIDTH>
-  GenericBoard<CELL,WIDTH>::GenericBoard(const RawValueBoard & rawValueBoard)
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::GenericBoard(const RawValueBoard & rawValueBoard)
   {
     constexpr unsigned int end_index = width * width;
     for(unsigned int index = 0; index < end_index; ++index)
@@ -156,32 +177,39 @@ namespace wubinboardgames
       // set value for each cell. This requires cell must overload operator=(ValueType).
       board[index/width][index%width] = rawValueBoard[index/width][index%width];
     }
+    rehash();
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  GenericBoard<CELL,WIDTH> & GenericBoard<CELL,WIDTH>::operator=(const Board & anotherBoard)
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH> & GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::operator=(const Board & anotherBoard)
   {
     board = anotherBoard;
+    rehash();
+    return *this;
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  GenericBoard<CELL,WIDTH> & GenericBoard<CELL,WIDTH>::operator=(Board && anotherBoard)
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH> & GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::operator=(Board && anotherBoard)
   {
     board = anotherBoard;
+    rehash();
+    return *this;
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  GenericBoard<CELL,WIDTH> & GenericBoard<CELL,WIDTH>::operator=(const GenericBoard::RawValueBoard & rawValueBoard)
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH> & GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::operator=(const GenericBoard::RawValueBoard & rawValueBoard)
   {
     constexpr unsigned int end_index = width * width;
     for(unsigned int index = 0; index < end_index; ++index)
     {
       board[index/width][index%width] = rawValueBoard[index/width][index%width];
     }
+    rehash();
+    return *this;
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  bool GenericBoard<CELL,WIDTH>::operator==(const RawValueBoard & rawValueBoard) const
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  bool GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::operator==(const RawValueBoard & rawValueBoard) const
   {
     constexpr unsigned int end_index = width * width;
     for(unsigned int index = 0; index < end_index; ++index)
@@ -192,8 +220,8 @@ namespace wubinboardgames
     return true;
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  bool GenericBoard<CELL,WIDTH>:: operator==(const Board & anotherBoard) const
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  bool GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>:: operator==(const Board & anotherBoard) const
   {
     constexpr unsigned int end_index = width * width;
     for(unsigned int index = 0; index < end_index; ++index)
@@ -205,50 +233,125 @@ namespace wubinboardgames
 
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  bool GenericBoard<CELL,WIDTH>::operator==(const GenericBoard<CELL,WIDTH> & another) const
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  bool GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::operator==(const GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH> & another) const
   {
     return (this->board == another.board);
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  void GenericBoard<CELL,WIDTH>::clear()
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  void GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::clear()
   {
     constexpr unsigned int end_index = width * width;
     for(unsigned int index = 0; index < end_index; ++index)
     {
       board[index/width][index%width].reset();
     }
+    // every cell is vacant, nothing left to XOR.
+    zobrist_hash = 0;
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  void GenericBoard<CELL,WIDTH>::backup()
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  void GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::backup()
   {
     backup_board = board;
+    backup_zobrist_hash = zobrist_hash;
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  void GenericBoard<CELL,WIDTH>::reset()
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  void GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::reset()
   {
     board = backup_board;
+    zobrist_hash = backup_zobrist_hash;
+  }
+
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  uint64_t GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::cellKey(const unsigned int & row, const unsigned int & col) const
+  {
+    typedef typename CELL::ValueType ValueType;
+    const CELL & cell = board[row][col];
+    if(!cell.isValid() || cell.isVacant())
+      return 0;
+    unsigned int value_offset = static_cast<unsigned int>(static_cast<ValueType>(cell) - CELL::minimum_value);
+    return Keys::key(row * width + col, value_offset);
+  }
+
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  uint64_t GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::hash() const
+  {
+#ifdef _no_board_hash
+    constexpr unsigned int end_index = width * width;
+    uint64_t computed_hash = 0;
+    for(unsigned int index = 0; index < end_index; ++index)
+    {
+      computed_hash ^= cellKey(index/width, index%width);
+    }
+    return computed_hash;
+#else
+    return zobrist_hash;
+#endif
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  typename GenericBoard<CELL,WIDTH>::Row &
-      GenericBoard<CELL,WIDTH>::operator[](const unsigned int & row_num)
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  uint64_t GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::rehash()
+  {
+    constexpr unsigned int end_index = width * width;
+    zobrist_hash = 0;
+    for(unsigned int index = 0; index < end_index; ++index)
+    {
+      zobrist_hash ^= cellKey(index/width, index%width);
+    }
+    return zobrist_hash;
+  }
+
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  void GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::assign(const unsigned int & row, const unsigned int & col,
+                                        const typename CELL::ValueType & value)
+  {
+#ifdef _no_board_hash
+    board[row][col] = value;
+#else
+    // XOR the old value out and the new value in.
+    zobrist_hash ^= cellKey(row, col);
+    board[row][col] = value;
+    zobrist_hash ^= cellKey(row, col);
+#endif
+  }
+
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  void GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::vacate(const unsigned int & row, const unsigned int & col)
+  {
+#ifndef _no_board_hash
+    zobrist_hash ^= cellKey(row, col);
+#endif
+    board[row][col].reset();
+  }
+
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  const RegionLayout & GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::layout() const
+  {
+    static_assert(BOX_HEIGHT * BOX_WIDTH == WIDTH, "Boxes must tile the board.");
+    // built once for every board type.
+    static const RegionLayout box_layout = BoxLayout(width, box_height, box_width);
+    return box_layout;
+  }
+
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  typename GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::Row &
+      GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::operator[](const unsigned int & row_num)
   {
     return board[row_num];
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  const typename GenericBoard<CELL,WIDTH>::Row &
-      GenericBoard<CELL,WIDTH>::operator[](const unsigned int & row_num) const
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  const typename GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::Row &
+      GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::operator[](const unsigned int & row_num) const
   {
     return board[row_num];
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  bool GenericBoard<CELL,WIDTH>::writeToFile(const std::string & path) const
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  bool GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::writeToFile(const std::string & path) const
   {
     std::ofstream ofs(path, std::ofstream::out);
     if(ofs)
@@ -262,18 +365,30 @@ namespace wubinboardgames
     return false;
   }
 
-  template<typename CELL, unsigned int WIDTH>
-  bool GenericBoard<CELL,WIDTH>::loadFromFile(const std::string & path)
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  bool GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::loadFromFile(const std::string & path)
+  {
+    return LoadBoardFile(path, *this);
+  }
+
+  template<typename CELL, unsigned int WIDTH, unsigned int BOX_HEIGHT, unsigned int BOX_WIDTH>
+  bool GenericBoard<CELL,WIDTH,BOX_HEIGHT,BOX_WIDTH>::parse(BoardTextReader & reader)
   {
-    std::ifstream ifs(path);
-    if(ifs)
+    typedef typename CELL::ValueType ValueType;
+    constexpr unsigned int end_index = width * width;
+    // digits from 1 to width, 0 for vacant cells.
+    std::array<uint8_t, end_index> digits;
+    if(!reader.readCells(width, digits.data(), end_index))
+      return false;
+    // the hash is XORed in on the way, rather than by rehash().
+    uint64_t new_hash = 0;
+    for(unsigned int index = 0; index < end_index; ++index)
     {
-      // call operator>>
-      ifs >> *this;
-      ifs.close();
-      return true;
+      board[index/width][index%width] = static_cast<ValueType>(CELL::minimum_value - 1 + digits[index]);
+      if(digits[index])
+        new_hash ^= Keys::key(index, digits[index] - 1u);
     }
-    ifs.close();
-    return false;
+    zobrist_hash = new_hash;
+    return true;
   }
 }
\ No newline at end of file
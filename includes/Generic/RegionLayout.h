@@ -0,0 +1,279 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace wubinboardgames
+{
+  /* RegionLayout describes which cells of a square board must hold different values.
+     Each unit (a row, a column, a box, ...) is a list of cell indexes
+     (row * width + col). The units are compiled once into flat tables:
+     - the cells of every unit,
+     - the units of every cell, padded to the same count with an empty unit so that
+       a loop over them needs no bound check per cell,
+     - the peers of every cell, that is every other cell sharing a unit with it.
+     Cells which belong to no unit are inactive, e.g. the gaps of a samurai board.
+     A unit may also carry a sum its values must add up to, like the cages of killer
+     sudoku. A cell belongs to at most one unit with a sum.
+  */
+  class RegionLayout
+  {
+  public:
+    // no_sum marks a cell in no unit with a sum, and a unit without sum.
+    static constexpr uint16_t no_sum = 0xFFFF;
+
+    // sums, if given, has one entry per unit. 0 means the unit has no sum.
+    RegionLayout(unsigned int width, std::vector<std::vector<unsigned int>> units,
+                 std::vector<unsigned int> sums = std::vector<unsigned int>());
+
+    unsigned int width() const;
+    unsigned int numberOfActiveCells() const;
+    bool isActive(unsigned int index) const;
+
+    // identical units given several times are kept once.
+    unsigned int numberOfUnits() const;
+    unsigned int unitSize(unsigned int unit) const;
+    const uint16_t * unitCells(unsigned int unit) const;
+
+    /* unitsPerCell() entries starting at cellUnits(index). Padding entries refer to
+       the unit numberOfUnits(), which has no cell.
+    */
+    unsigned int unitsPerCell() const;
+    const uint16_t * cellUnits(unsigned int index) const;
+
+    unsigned int numberOfPeers(unsigned int index) const;
+    const uint16_t * peers(unsigned int index) const;
+
+    bool hasSums() const;
+    // the sum of a unit, 0 if it has none.
+    unsigned int unitSum(unsigned int unit) const;
+    // the unit with a sum the cell belongs to, or no_sum.
+    uint16_t sumUnitOf(unsigned int index) const;
+
+  private:
+    unsigned int board_width;
+    unsigned int active_cells;
+    unsigned int units_per_cell;
+    std::vector<uint8_t> active;
+    std::vector<uint32_t> unit_offsets;
+    std::vector<uint16_t> unit_cells;
+    std::vector<uint16_t> cell_units;
+    std::vector<uint32_t> peer_offsets;
+    std::vector<uint16_t> peer_cells;
+    std::vector<unsigned int> unit_sums;
+    std::vector<uint16_t> sum_unit_of_cell;
+    bool with_sums;
+  };
+
+  inline RegionLayout::RegionLayout(unsigned int width, std::vector<std::vector<unsigned int>> units,
+                                    std::vector<unsigned int> sums)
+      : board_width(width), active_cells(0), units_per_cell(0), active(width * width, 0),
+        sum_unit_of_cell(width * width, static_cast<uint16_t>(no_sum)), with_sums(false)
+  {
+    const unsigned int end_index = width * width;
+    sums.resize(units.size(), 0);
+    // drop repeated units but keep the order of the others, so the units of
+    // BoxLayout stay numbered rows first, then columns, then boxes. A repeated
+    // unit keeps the sum given to any of its copies.
+    std::vector<std::vector<unsigned int>> distinct_units;
+    for(unsigned int unit = 0; unit < units.size(); ++unit)
+    {
+      std::sort(units[unit].begin(), units[unit].end());
+      auto itr = std::find(distinct_units.begin(), distinct_units.end(), units[unit]);
+      if(itr == distinct_units.end())
+      {
+        distinct_units.push_back(std::move(units[unit]));
+        unit_sums.push_back(sums[unit]);
+      }
+      else if(sums[unit])
+      {
+        unit_sums[itr - distinct_units.begin()] = sums[unit];
+      }
+    }
+    units.swap(distinct_units);
+    for(unsigned int unit = 0; unit < units.size(); ++unit)
+    {
+      if(!unit_sums[unit])
+        continue;
+      with_sums = true;
+      for(unsigned int index : units[unit])
+        sum_unit_of_cell[index] = static_cast<uint16_t>(unit);
+    }
+    // the padding unit has no sum.
+    unit_sums.push_back(0);
+
+    std::vector<std::vector<uint16_t>> units_of_cell(end_index);
+    unit_offsets.push_back(0);
+    for(unsigned int unit = 0; unit < units.size(); ++unit)
+    {
+      for(unsigned int index : units[unit])
+      {
+        unit_cells.push_back(static_cast<uint16_t>(index));
+        units_of_cell[index].push_back(static_cast<uint16_t>(unit));
+        active[index] = 1;
+      }
+      unit_offsets.push_back(static_cast<uint32_t>(unit_cells.size()));
+    }
+    // the empty unit used as padding.
+    unit_offsets.push_back(static_cast<uint32_t>(unit_cells.size()));
+
+    unsigned int largest_unit = 0;
+    for(const auto & unit : units)
+      largest_unit = std::max(largest_unit, static_cast<unsigned int>(unit.size()));
+    for(unsigned int index = 0; index < end_index; ++index)
+    {
+      active_cells += active[index];
+      units_per_cell = std::max(units_per_cell, static_cast<unsigned int>(units_of_cell[index].size()));
+    }
+    const uint16_t empty_unit = static_cast<uint16_t>(units.size());
+    cell_units.assign(end_index * units_per_cell, empty_unit);
+    peer_offsets.push_back(0);
+    for(unsigned int index = 0; index < end_index; ++index)
+    {
+      std::copy(units_of_cell[index].begin(), units_of_cell[index].end(), cell_units.begin() + index * units_per_cell);
+      // peers are listed taking one cell of each unit in turn, so a check stopping
+      // at the first conflict looks at every unit early.
+      std::vector<uint16_t> cell_peers;
+      std::vector<uint8_t> is_peer(end_index, 0);
+      is_peer[index] = 1;
+      for(unsigned int k = 0; k < largest_unit; ++k)
+      {
+        for(uint16_t unit : units_of_cell[index])
+        {
+          if(k < unitSize(unit) && !is_peer[unitCells(unit)[k]])
+          {
+            is_peer[unitCells(unit)[k]] = 1;
+            cell_peers.push_back(unitCells(unit)[k]);
+          }
+        }
+      }
+      peer_cells.insert(peer_cells.end(), cell_peers.begin(), cell_peers.end());
+      peer_offsets.push_back(static_cast<uint32_t>(peer_cells.size()));
+    }
+  }
+
+  inline unsigned int RegionLayout::width() const
+  {
+    return board_width;
+  }
+
+  inline unsigned int RegionLayout::numberOfActiveCells() const
+  {
+    return active_cells;
+  }
+
+  inline bool RegionLayout::isActive(unsigned int index) const
+  {
+    return active[index] != 0;
+  }
+
+  inline unsigned int RegionLayout::numberOfUnits() const
+  {
+    return static_cast<unsigned int>(unit_offsets.size() - 2);
+  }
+
+  inline unsigned int RegionLayout::unitSize(unsigned int unit) const
+  {
+    return unit_offsets[unit + 1] - unit_offsets[unit];
+  }
+
+  inline const uint16_t * RegionLayout::unitCells(unsigned int unit) const
+  {
+    return unit_cells.data() + unit_offsets[unit];
+  }
+
+  inline unsigned int RegionLayout::unitsPerCell() const
+  {
+    return units_per_cell;
+  }
+
+  inline const uint16_t * RegionLayout::cellUnits(unsigned int index) const
+  {
+    return cell_units.data() + index * units_per_cell;
+  }
+
+  inline unsigned int RegionLayout::numberOfPeers(unsigned int index) const
+  {
+    return peer_offsets[index + 1] - peer_offsets[index];
+  }
+
+  inline const uint16_t * RegionLayout::peers(unsigned int index) const
+  {
+    return peer_cells.data() + peer_offsets[index];
+  }
+
+  inline bool RegionLayout::hasSums() const
+  {
+    return with_sums;
+  }
+
+  inline unsigned int RegionLayout::unitSum(unsigned int unit) const
+  {
+    return unit_sums[unit];
+  }
+
+  inline uint16_t RegionLayout::sumUnitOf(unsigned int index) const
+  {
+    return sum_unit_of_cell[index];
+  }
+
+  // rows, columns and box_height x box_width boxes of a classic board, in this order.
+  inline std::vector<std::vector<unsigned int>> BoxUnits(unsigned int width, unsigned int box_height, unsigned int box_width)
+  {
+    std::vector<std::vector<unsigned int>> units(3 * width);
+    for(unsigned int row = 0; row < width; ++row)
+    {
+      for(unsigned int col = 0; col < width; ++col)
+      {
+        unsigned int index = row * width + col;
+        unsigned int box = (row / box_height) * (width / box_width) + col / box_width;
+        units[row].push_back(index);
+        units[width + col].push_back(index);
+        units[2 * width + box].push_back(index);
+      }
+    }
+    return units;
+  }
+
+  inline RegionLayout BoxLayout(unsigned int width, unsigned int box_height, unsigned int box_width)
+  {
+    return RegionLayout(width, BoxUnits(width, box_height, box_width));
+  }
+
+  // the two main diagonals of X sudoku.
+  inline std::vector<std::vector<unsigned int>> DiagonalUnits(unsigned int width)
+  {
+    std::vector<std::vector<unsigned int>> units(2);
+    for(unsigned int row = 0; row < width; ++row)
+    {
+      units[0].push_back(row * width + row);
+      units[1].push_back(row * width + width - 1 - row);
+    }
+    return units;
+  }
+
+  /* The extra boxes of windoku: box_height x box_width boxes one cell away from the
+     border and from each other, e.g. four boxes starting at rows and columns 1 and 5
+     on a 9x9 board.
+  */
+  inline std::vector<std::vector<unsigned int>> WindowUnits(unsigned int width, unsigned int box_height, unsigned int box_width)
+  {
+    std::vector<std::vector<unsigned int>> units;
+    for(unsigned int top = 1; top + box_height < width; top += box_height + 1)
+    {
+      for(unsigned int left = 1; left + box_width < width; left += box_width + 1)
+      {
+        std::vector<unsigned int> cells;
+        for(unsigned int row = top; row < top + box_height; ++row)
+        {
+          for(unsigned int col = left; col < left + box_width; ++col)
+            cells.push_back(row * width + col);
+        }
+        units.push_back(cells);
+      }
+    }
+    return units;
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+
+namespace wubinboardgames
+{
+  /* C++11 has no std::index_sequence. IndexSequence/MakeIndexSequence is a small
+     replacement. MakeIndexSequence splits N in halves so the depth of template
+     instantiation is log(N) instead of N, which matters for tables of thousands of
+     entries.
+  */
+  template<std::size_t... I>
+  struct IndexSequence
+  {
+    typedef IndexSequence type;
+  };
+
+  template<typename FirstSequence, typename SecondSequence>
+  struct ConcatIndexSequence;
+
+  template<std::size_t... I1, std::size_t... I2>
+  struct ConcatIndexSequence<IndexSequence<I1...>, IndexSequence<I2...>>
+      : IndexSequence<I1..., (sizeof...(I1) + I2)...>
+  {};
+
+  template<std::size_t N>
+  struct MakeIndexSequence
+      : ConcatIndexSequence<typename MakeIndexSequence<N / 2>::type,
+                            typename MakeIndexSequence<N - N / 2>::type>
+  {};
+
+  template<>
+  struct MakeIndexSequence<0> : IndexSequence<>
+  {};
+
+  template<>
+  struct MakeIndexSequence<1> : IndexSequence<0>
+  {};
+
+  /* StaticTable evaluates a generator for each index at compile time.
+     The generator must provide
+       typedef ... ValueType;
+       static constexpr std::size_t size;
+       static constexpr ValueType at(std::size_t index);
+     For example, StaticTable<ZobristKeyGenerator<SudokuCell, 9>>::values is an array
+     of 729 keys computed by the compiler.
+  */
+  template<typename Generator, typename Sequence = typename MakeIndexSequence<Generator::size>::type>
+  struct StaticTable;
+
+  template<typename Generator, std::size_t... I>
+  struct StaticTable<Generator, IndexSequence<I...>>
+  {
+    typedef typename Generator::ValueType ValueType;
+    static constexpr std::size_t size = sizeof...(I);
+    static constexpr ValueType values[sizeof...(I)] = { Generator::at(I)... };
+  };
+
+  // out-of-class definition is still required by C++11 when values is odr-used.
+  template<typename Generator, std::size_t... I>
+  constexpr typename Generator::ValueType StaticTable<Generator, IndexSequence<I...>>::values[sizeof...(I)];
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* Trace records scoped events into a ring buffer owned by each thread and dumps
+   them as Chrome trace-event JSON (chrome://tracing, Perfetto) on demand.
+   Recording never takes a lock: a thread only writes its own buffer, buffers are
+   registered in a lock-free list, and every slot carries a sequence number so a
+   dump running at the same time skips the slots being overwritten.
+   Buffers outlive their threads, so events of finished worker threads can still be
+   dumped. A buffer released by a finished thread is reused by the next new thread,
+   but none is ever freed: each thread tracing at the same time costs a buffer of
+   RING_CAPACITY slots, about 800KB.
+   Tracing is opt-in: TRACE_SCOPE/TRACE_INSTANT record nothing unless _tracing is
+   defined.
+*/
+
+namespace wubinboardgames
+{
+  namespace trace
+  {
+    // events kept per thread. Older events are overwritten.
+    constexpr unsigned int RING_CAPACITY = 1 << 14;
+
+    inline uint64_t NowNanoseconds()
+    {
+      // all timestamps are relative to the first call, which is good enough for a trace.
+      static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+      return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    struct TraceSlot
+    {
+      // odd while the owner is writing the slot, 2 * (event number + 1) once written.
+      std::atomic<uint64_t> sequence{0};
+      // name must be a string literal, only the pointer is kept.
+      std::atomic<const char *> name{nullptr};
+      // 'X' for a complete (scoped) event, 'i' for an instant event.
+      std::atomic<char> phase{'X'};
+      std::atomic<uint64_t> start{0};
+      std::atomic<uint64_t> duration{0};
+      std::atomic<uint64_t> value{0};
+    };
+
+    struct TraceBuffer
+    {
+      explicit TraceBuffer(unsigned int buffer_id) : id(buffer_id) {}
+
+      void record(const char * name, char phase, uint64_t start, uint64_t duration, uint64_t value)
+      {
+        uint64_t number = next.load(std::memory_order_relaxed);
+        TraceSlot & slot = slots[number % RING_CAPACITY];
+        slot.sequence.store(2 * number + 1, std::memory_order_relaxed);
+        // keeps the stores of the fields below from moving before the odd sequence.
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.phase.store(phase, std::memory_order_relaxed);
+        slot.start.store(start, std::memory_order_relaxed);
+        slot.duration.store(duration, std::memory_order_relaxed);
+        slot.value.store(value, std::memory_order_relaxed);
+        slot.sequence.store(2 * number + 2, std::memory_order_release);
+        next.store(number + 1, std::memory_order_release);
+      }
+
+      const unsigned int id;
+      std::atomic<bool> in_use{true};
+      std::atomic<uint64_t> next{0};
+      TraceBuffer * link = nullptr;
+      TraceSlot slots[RING_CAPACITY];
+    };
+
+    // head of the lock-free list of every buffer ever created.
+    inline std::atomic<TraceBuffer *> & BufferList()
+    {
+      static std::atomic<TraceBuffer *> head{nullptr};
+      return head;
+    }
+
+    inline TraceBuffer * AcquireBuffer()
+    {
+      // reuse a buffer released by a finished thread first.
+      for(TraceBuffer * buffer = BufferList().load(std::memory_order_acquire); buffer; buffer = buffer->link)
+      {
+        bool expected = false;
+        if(buffer->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+          return buffer;
+      }
+      static std::atomic<unsigned int> next_id{1};
+      TraceBuffer * buffer = new TraceBuffer(next_id.fetch_add(1, std::memory_order_relaxed));
+      buffer->link = BufferList().load(std::memory_order_relaxed);
+      while(!BufferList().compare_exchange_weak(buffer->link, buffer, std::memory_order_release,
+                                                std::memory_order_relaxed));
+      return buffer;
+    }
+
+    // owns the buffer of the calling thread and releases it when the thread exits.
+    struct ThreadBufferHolder
+    {
+      ThreadBufferHolder() : buffer(AcquireBuffer()) {}
+      ~ThreadBufferHolder()
+      {
+        buffer->in_use.store(false, std::memory_order_release);
+      }
+      TraceBuffer * buffer;
+    };
+
+    inline TraceBuffer & ThreadBuffer()
+    {
+      static thread_local ThreadBufferHolder holder;
+      return *holder.buffer;
+    }
+
+    // an event without duration, e.g. a restart. value is shown in the event args.
+    inline void Instant(const char * name, uint64_t value = 0)
+    {
+      ThreadBuffer().record(name, 'i', NowNanoseconds(), 0, value);
+    }
+
+    // records the lifetime of the object as one complete event.
+    class ScopedEvent
+    {
+    public:
+      explicit ScopedEvent(const char * event_name) : name(event_name), start(NowNanoseconds()) {}
+      ~ScopedEvent()
+      {
+        uint64_t end = NowNanoseconds();
+        ThreadBuffer().record(name, 'X', start, end - start, 0);
+      }
+      ScopedEvent(const ScopedEvent & another) = delete;
+      ScopedEvent & operator=(const ScopedEvent & another) = delete;
+
+    private:
+      const char * name;
+      uint64_t start;
+    };
+
+    /* Write every recorded event as Chrome trace-event JSON. It can be called while
+       other threads keep recording.
+    */
+    inline void DumpChromeTrace(std::ostream & os)
+    {
+      os << "{\"traceEvents\":[";
+      bool first = true;
+      for(TraceBuffer * buffer = BufferList().load(std::memory_order_acquire); buffer; buffer = buffer->link)
+      {
+        uint64_t end = buffer->next.load(std::memory_order_acquire);
+        uint64_t begin = (end > RING_CAPACITY) ? end - RING_CAPACITY : 0;
+        for(uint64_t number = begin; number < end; ++number)
+        {
+          const TraceSlot & slot = buffer->slots[number % RING_CAPACITY];
+          if(slot.sequence.load(std::memory_order_acquire) != 2 * number + 2)
+            continue;
+          const char * name = slot.name.load(std::memory_order_relaxed);
+          char phase = slot.phase.load(std::memory_order_relaxed);
+          uint64_t start = slot.start.load(std::memory_order_relaxed);
+          uint64_t duration = slot.duration.load(std::memory_order_relaxed);
+          uint64_t value = slot.value.load(std::memory_order_relaxed);
+          // keeps the loads above from moving after the check. The owner overwrote the
+          // slot while it was read if the sequence changed.
+          std::atomic_thread_fence(std::memory_order_acquire);
+          if(slot.sequence.load(std::memory_order_relaxed) != 2 * number + 2)
+            continue;
+          os << (first ? "\n" : ",\n");
+          first = false;
+          os << "{\"name\":\"" << name << "\",\"cat\":\"sudoku\",\"ph\":\"" << phase
+             << "\",\"pid\":1,\"tid\":" << buffer->id
+             << ",\"ts\":" << start / 1000 << '.' << (start % 1000) / 100 << (start % 100) / 10 << start % 10;
+          if('X' == phase)
+            os << ",\"dur\":" << duration / 1000 << '.' << (duration % 1000) / 100 << (duration % 100) / 10 << duration % 10;
+          else
+            os << ",\"s\":\"t\"";
+          os << ",\"args\":{\"value\":" << value << "}}";
+        }
+      }
+      os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    inline bool DumpChromeTrace(const std::string & path)
+    {
+      std::ofstream ofs(path, std::ofstream::out);
+      if(!ofs)
+        return false;
+      DumpChromeTrace(ofs);
+      return true;
+    }
+  }
+}
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef _tracing
+#define TRACE_SCOPE(name) ::wubinboardgames::trace::ScopedEvent TRACE_CONCAT(trace_scope_, __LINE__){name}
+#define TRACE_INSTANT(name, value) ::wubinboardgames::trace::Instant(name, value)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_INSTANT(name, value)
+#endif
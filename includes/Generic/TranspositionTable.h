@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+
+namespace wubinboardgames
+{
+  /* TranspositionTable is a bounded, lock-free hash table mapping the key of a
+     search state to the number of solutions found below it.
+     Each slot is a pair of atomics (check, data) where check = key ^ data. A reader
+     accepts a slot only if check ^ data gives back its key, so a slot torn by a
+     concurrent writer is simply seen as a miss. Several solver threads can share one
+     table without any lock.
+     The table never grows. Colliding keys overwrite each other.
+  */
+  class TranspositionTable
+  {
+  public:
+    // counts are saturated to 62 bits. The top bit tells if the count is exact.
+    static constexpr uint64_t max_count = (static_cast<uint64_t>(1) << 62) - 1;
+
+    // capacity is rounded up to a power of two. 1 << 20 slots take 16 MB.
+    explicit TranspositionTable(std::size_t capacity = (1 << 20));
+
+    TranspositionTable(const TranspositionTable & another) = delete;
+    TranspositionTable & operator=(const TranspositionTable & another) = delete;
+
+    /* Look up a key. Returns false on a miss. On a hit, count is the number of
+       solutions below the state. If exact is false, count is only a lower bound
+       because the search that stored it stopped at its limit.
+    */
+    bool probe(uint64_t key, uint64_t & count, bool & exact) const;
+    void store(uint64_t key, uint64_t count, bool exact);
+    void clear();
+
+    std::size_t capacity() const;
+
+  private:
+    static constexpr uint64_t exact_flag = static_cast<uint64_t>(1) << 63;
+
+    struct Slot
+    {
+      std::atomic<uint64_t> check;
+      std::atomic<uint64_t> data;
+    };
+
+    std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  inline TranspositionTable::TranspositionTable(std::size_t capacity) : mask(0)
+  {
+    std::size_t size = 1;
+    while(size < capacity)
+      size <<= 1;
+    mask = size - 1;
+    slots.reset(new Slot[size]);
+    clear();
+  }
+
+  inline bool TranspositionTable::probe(uint64_t key, uint64_t & count, bool & exact) const
+  {
+    const Slot & slot = slots[key & mask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+    // an empty slot has check == data == 0, which only matches key 0.
+    if((check ^ data) != key || 0 == data)
+      return false;
+    count = data & max_count;
+    exact = (data & exact_flag) != 0;
+    return true;
+  }
+
+  inline void TranspositionTable::store(uint64_t key, uint64_t count, bool exact)
+  {
+    if(count > max_count)
+      count = max_count;
+    // keep the data word non-zero so it can be told apart from an empty slot.
+    uint64_t data = count | (exact ? exact_flag : (static_cast<uint64_t>(1) << 62));
+    Slot & slot = slots[key & mask];
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+  }
+
+  inline void TranspositionTable::clear()
+  {
+    for(std::size_t index = 0; index <= mask; ++index)
+    {
+      slots[index].check.store(0, std::memory_order_relaxed);
+      slots[index].data.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  inline std::size_t TranspositionTable::capacity() const
+  {
+    return mask + 1;
+  }
+}
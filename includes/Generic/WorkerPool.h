@@ -0,0 +1,144 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+namespace wubinboardgames
+{
+  /* WorkerPool runs jobs on a fixed set of threads. Jobs submitted while the workers
+     are busy pile up in one queue, and a worker waking up takes up to max_batch of
+     them at once, so concurrent jobs are handled in batches: one lock and one call
+     of the batch handler for all of them.
+
+     When the queue is empty, workers run the idle task (refilling caches, say) until
+     it reports there is nothing left to do. One worker is always kept off the idle
+     task, so queued jobs never wait for it to finish.
+  */
+  template<typename Job>
+  class WorkerPool
+  {
+  public:
+    typedef std::function<void(std::vector<Job> &)> BatchHandler;
+    // returns false if it had nothing to do.
+    typedef std::function<bool()> IdleTask;
+
+    WorkerPool(unsigned int num_of_workers, std::size_t max_batch, BatchHandler handler,
+               IdleTask idle_task = IdleTask());
+    // waits for the jobs being handled, drops those still queued.
+    ~WorkerPool();
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool & operator=(const WorkerPool &) = delete;
+
+    void submit(Job job);
+    // wake the workers, so that the idle task runs again.
+    void wakeUp();
+    std::size_t numberOfQueuedJobs() const;
+
+  private:
+    void run();
+
+    const std::size_t max_batch;
+    const unsigned int max_idle_workers;
+    BatchHandler handler;
+    IdleTask idle_task;
+    mutable std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<Job> queue;
+    unsigned int num_of_idle_workers = 0;
+    bool has_idle_work = true;
+    bool is_stopping = false;
+    std::vector<std::thread> workers;
+  };
+
+  template<typename Job>
+  WorkerPool<Job>::WorkerPool(unsigned int num_of_workers, std::size_t max_batch_size, BatchHandler batch_handler,
+                              IdleTask task)
+    : max_batch(std::max<std::size_t>(max_batch_size, 1)),
+      max_idle_workers(num_of_workers > 1 ? num_of_workers - 1 : 0),
+      handler(std::move(batch_handler)), idle_task(std::move(task))
+  {
+    for(unsigned int i = 0; i < std::max(num_of_workers, 1u); ++i)
+      workers.emplace_back(&WorkerPool::run, this);
+  }
+
+  template<typename Job>
+  WorkerPool<Job>::~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex);
+      is_stopping = true;
+    }
+    queue_cv.notify_all();
+    for(auto & worker : workers)
+      worker.join();
+  }
+
+  template<typename Job>
+  void WorkerPool<Job>::submit(Job job)
+  {
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex);
+      queue.push_back(std::move(job));
+    }
+    queue_cv.notify_one();
+  }
+
+  template<typename Job>
+  void WorkerPool<Job>::wakeUp()
+  {
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex);
+      has_idle_work = true;
+    }
+    queue_cv.notify_all();
+  }
+
+  template<typename Job>
+  std::size_t WorkerPool<Job>::numberOfQueuedJobs() const
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    return queue.size();
+  }
+
+  template<typename Job>
+  void WorkerPool<Job>::run()
+  {
+    std::vector<Job> batch;
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    while(true)
+    {
+      queue_cv.wait(lock, [this]
+      {
+        return is_stopping || !queue.empty() ||
+               (idle_task && has_idle_work && num_of_idle_workers < max_idle_workers);
+      });
+      if(is_stopping)
+        return;
+      if(!queue.empty())
+      {
+        const std::size_t batch_size = std::min(queue.size(), max_batch);
+        batch.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.begin() + batch_size));
+        queue.erase(queue.begin(), queue.begin() + batch_size);
+        if(!queue.empty())
+          queue_cv.notify_one();
+        lock.unlock();
+        handler(batch);
+        batch.clear();
+        lock.lock();
+        continue;
+      }
+      ++num_of_idle_workers;
+      lock.unlock();
+      const bool did_work = idle_task();
+      lock.lock();
+      --num_of_idle_workers;
+      if(!did_work)
+        has_idle_work = false;
+    }
+  }
+}
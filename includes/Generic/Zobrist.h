@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "StaticTable.h"
+
+namespace wubinboardgames
+{
+  // splitmix64 written as single-return functions to stay constexpr in C++11.
+  constexpr uint64_t MixShiftMultiply(uint64_t z, unsigned int shift, uint64_t multiplier)
+  {
+    return (z ^ (z >> shift)) * multiplier;
+  }
+
+  constexpr uint64_t XorShiftRight(uint64_t z, unsigned int shift)
+  {
+    return z ^ (z >> shift);
+  }
+
+  constexpr uint64_t SplitMix64(uint64_t x)
+  {
+    return XorShiftRight(MixShiftMultiply(MixShiftMultiply(x + 0x9E3779B97F4A7C15ULL, 30, 0xBF58476D1CE4E5B9ULL),
+                                          27, 0x94D049BB133111EBULL), 31);
+  }
+
+  /* One random key per (cell index, value) pair. The seed depends on the width and
+     the number of values so that every board type gets its own table.
+  */
+  template<typename CELL, unsigned int WIDTH>
+  struct ZobristKeyGenerator
+  {
+    typedef uint64_t ValueType;
+    static constexpr std::size_t values_length = CELL::values_length;
+    static constexpr std::size_t size = WIDTH * WIDTH * values_length;
+    static constexpr uint64_t seed = (static_cast<uint64_t>(WIDTH) << 32) ^ values_length;
+
+    static constexpr uint64_t at(std::size_t index)
+    {
+      return SplitMix64(SplitMix64(seed) + index);
+    }
+  };
+
+  /* ZobristKeys gives the key of a value sitting on a cell. The hash of a board is
+     the XOR of the keys of every non-vacant cell, so assigning or resetting a cell
+     updates the hash with a single XOR. The table is generated at compile time.
+  */
+  template<typename CELL, unsigned int WIDTH>
+  struct ZobristKeys
+  {
+    typedef StaticTable<ZobristKeyGenerator<CELL, WIDTH>> Table;
+
+    // value_offset is the value minus CELL::minimum_value
+    static inline uint64_t key(unsigned int cell_index, unsigned int value_offset)
+    {
+      return Table::values[cell_index * CELL::values_length + value_offset];
+    }
+  };
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "Generic/StaticTable.h"
+
+/* Digit combinations of killer cages, computed by the compiler.
+   A cage of n cells summing to s can only hold the digits of some set of n distinct
+   digits (1 to 9) adding up to s. CageCombinations(n, s) is the union of all these
+   sets as a mask (bit d - 1 for digit d), so pruning a cage is a table lookup and a
+   mask AND. It is 0 when no set exists, e.g. CageCombinations(2, 18).
+*/
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    constexpr unsigned int MAX_CAGE_DIGIT = 9;
+    // 1 + 2 + ... + 9
+    constexpr unsigned int MAX_CAGE_SUM = MAX_CAGE_DIGIT * (MAX_CAGE_DIGIT + 1) / 2;
+
+    // set on the mask of a feasible (maybe empty) combination, removed from the table.
+    constexpr uint32_t FEASIBLE_COMBINATION = static_cast<uint32_t>(1) << 31;
+
+    // the combinations using digit, if the rest can be completed with larger digits.
+    constexpr uint32_t WithDigit(uint32_t rest, unsigned int digit)
+    {
+      return rest ? (rest | (static_cast<uint32_t>(1) << (digit - 1))) : 0;
+    }
+
+    // union of the sets of size distinct digits, all >= digit, adding up to sum.
+    constexpr uint32_t UnionOfCombinations(unsigned int size, unsigned int sum, unsigned int digit)
+    {
+      return (0 == size) ? ((0 == sum) ? FEASIBLE_COMBINATION : 0) :
+             (digit > MAX_CAGE_DIGIT || sum < digit) ? 0 :
+             (WithDigit(UnionOfCombinations(size - 1, sum - digit, digit + 1), digit) |
+              UnionOfCombinations(size, sum, digit + 1));
+    }
+
+    struct CageCombinationGenerator
+    {
+      typedef uint16_t ValueType;
+      static constexpr std::size_t size = (MAX_CAGE_DIGIT + 1) * (MAX_CAGE_SUM + 1);
+
+      // index is size * (MAX_CAGE_SUM + 1) + sum
+      static constexpr uint16_t at(std::size_t index)
+      {
+        return static_cast<uint16_t>(UnionOfCombinations(static_cast<unsigned int>(index / (MAX_CAGE_SUM + 1)),
+                                                         static_cast<unsigned int>(index % (MAX_CAGE_SUM + 1)), 1) &
+                                     ~FEASIBLE_COMBINATION);
+      }
+    };
+
+    typedef StaticTable<CageCombinationGenerator> CageCombinationTable;
+
+    /* Digits which may complete a cage with size vacant cells and sum left to reach.
+       size 0 and sum 0 gives 0 as well: there is nothing left to put.
+    */
+    inline uint16_t CageCombinations(unsigned int size, int sum)
+    {
+      if(size > MAX_CAGE_DIGIT || sum < 0 || sum > static_cast<int>(MAX_CAGE_SUM))
+        return 0;
+      return CageCombinationTable::values[size * (MAX_CAGE_SUM + 1) + static_cast<unsigned int>(sum)];
+    }
+  }
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <fstream>
+#include <array>
+#include <algorithm>
+
+#include "Generic/GenericBoard.h"
+#include "Generic/RegionLayout.h"
+#include "SudokuCell.h"
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    /* GenericJigsawBoard is a sudoku board whose boxes are replaced by irregular
+       regions of width cells each. The regions are given at runtime, so every board
+       owns its layout (rows, columns and regions). Boards copied from each other share
+       the same layout. A new board has the square boxes of a classic board as regions.
+
+       Files hold the values, then the region of every cell (1 to width) laid out the
+       same way.
+    */
+    template<typename CELL, unsigned int WIDTH = CELL::values_length>
+    class GenericJigsawBoard : public GenericBoard<CELL, WIDTH>
+    {
+    public:
+      typedef GenericBoard<CELL, WIDTH> BaseBoard;
+      using BaseBoard::width;
+      using BaseBoard::box_height;
+      using BaseBoard::box_width;
+      static constexpr bool has_box_layout = false;
+
+      GenericJigsawBoard() = default;
+      using BaseBoard::BaseBoard;
+
+      const RegionLayout & layout() const;
+      // the cells of every region.
+      const std::vector<std::vector<unsigned int>> & regions() const;
+
+      /* Replace the regions. The regions are kept unchanged and false is returned
+         unless there are width regions of width cells each, covering the board.
+      */
+      bool setRegions(std::vector<std::vector<unsigned int>> new_regions);
+
+      bool writeToFile(const std::string & path = DEFAULT_FILE_NAME) const;
+      bool loadFromFile(const std::string & path);
+      bool parse(BoardTextReader & reader);
+
+      friend std::ostream & operator<<(std::ostream & os, const GenericJigsawBoard & jigsawBoard)
+      {
+        os << static_cast<const BaseBoard &>(jigsawBoard);
+        std::array<unsigned int, width * width> region_of_cell;
+        for(unsigned int region = 0; region < width; ++region)
+        {
+          for(unsigned int index : jigsawBoard.regions()[region])
+            region_of_cell[index] = region + 1;
+        }
+        char text[MaxFormattedLength<BaseBoard>(BoardFormat::grid)];
+        const char * end = WriteBoardGrid(text, width, box_height, box_width,
+                                          [&region_of_cell](unsigned int index, char * field)
+                                          {
+                                            return WriteDecimal(region_of_cell[index], field);
+                                          });
+        os.write(text, static_cast<std::streamsize>(end - text));
+        return os;
+      }
+
+      friend std::istream & operator>>(std::istream & is, GenericJigsawBoard & jigsawBoard)
+      {
+        return ReadBoard(is, jigsawBoard);
+      }
+
+    private:
+      typedef std::vector<std::vector<unsigned int>> RegionList;
+      static std::shared_ptr<const RegionList> BoxRegions();
+      static std::shared_ptr<const RegionLayout> BoxRegionLayout();
+
+      // shared by copies, as boards are copied all along a search.
+      std::shared_ptr<const RegionList> region_list = BoxRegions();
+      std::shared_ptr<const RegionLayout> regions_layout = BoxRegionLayout();
+    };
+
+    template<typename CELL, unsigned int WIDTH>
+    std::shared_ptr<const typename GenericJigsawBoard<CELL,WIDTH>::RegionList> GenericJigsawBoard<CELL,WIDTH>::BoxRegions()
+    {
+      static const std::shared_ptr<const RegionList> box_regions = []
+      {
+        RegionList units = BoxUnits(width, box_height, box_width);
+        return std::shared_ptr<const RegionList>(new RegionList(units.begin() + 2 * width, units.end()));
+      }();
+      return box_regions;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    std::shared_ptr<const RegionLayout> GenericJigsawBoard<CELL,WIDTH>::BoxRegionLayout()
+    {
+      static const std::shared_ptr<const RegionLayout> box_layout =
+          std::shared_ptr<const RegionLayout>(new RegionLayout(width, BoxUnits(width, box_height, box_width)));
+      return box_layout;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    inline const RegionLayout & GenericJigsawBoard<CELL,WIDTH>::layout() const
+    {
+      return *regions_layout;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    inline const std::vector<std::vector<unsigned int>> & GenericJigsawBoard<CELL,WIDTH>::regions() const
+    {
+      return *region_list;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    bool GenericJigsawBoard<CELL,WIDTH>::setRegions(std::vector<std::vector<unsigned int>> new_regions)
+    {
+      if(new_regions.size() != width)
+        return false;
+      std::vector<uint8_t> is_covered(width * width, 0);
+      // rows and columns first, then the regions.
+      std::vector<std::vector<unsigned int>> units = BoxUnits(width, box_height, box_width);
+      units.resize(2 * width);
+      for(auto & region : new_regions)
+      {
+        if(region.size() != width)
+          return false;
+        for(unsigned int index : region)
+        {
+          if(index >= width * width || is_covered[index])
+            return false;
+          is_covered[index] = 1;
+        }
+        std::sort(region.begin(), region.end());
+        units.push_back(region);
+      }
+      regions_layout = std::shared_ptr<const RegionLayout>(new RegionLayout(width, std::move(units)));
+      region_list = std::shared_ptr<const RegionList>(new RegionList(std::move(new_regions)));
+      return true;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    bool GenericJigsawBoard<CELL,WIDTH>::writeToFile(const std::string & path) const
+    {
+      std::ofstream ofs(path, std::ofstream::out);
+      if(ofs)
+      {
+        ofs << *this;
+        return true;
+      }
+      return false;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    bool GenericJigsawBoard<CELL,WIDTH>::loadFromFile(const std::string & path)
+    {
+      return LoadBoardFile(path, *this);
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    bool GenericJigsawBoard<CELL,WIDTH>::parse(BoardTextReader & reader)
+    {
+      BaseBoard values;
+      if(!values.parse(reader))
+        return false;
+      std::vector<std::vector<unsigned int>> new_regions(width);
+      unsigned int region = 0;
+      for(unsigned int index = 0; index < width * width; ++index)
+      {
+        if(!reader.readNumber(region, width))
+          return false;
+        if(0 == region)
+          return reader.fail("regions are numbered from 1");
+        new_regions[region - 1].push_back(index);
+      }
+      if(!setRegions(std::move(new_regions)))
+        return reader.fail("every region must have " + std::to_string(width) + " cells");
+      BaseBoard::operator=(values);
+      return true;
+    }
+
+    typedef GenericJigsawBoard<SudokuCell> JigsawBoard;
+  }
+}
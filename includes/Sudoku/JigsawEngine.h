@@ -0,0 +1,145 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+
+#include "SudokuEngine.h"
+#include "JigsawBoard.h"
+
+/* Generation of jigsaw sudoku boards. Solving, uniqueness and levels need nothing
+   more than SudokuEngine.h, which reads the regions from the layout of the board.
+   Including this file lets GenerateSolvableBoard draw the regions of jigsaw boards.
+*/
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    // true if the cells of region form one piece, moving up, down, left and right.
+    template<unsigned int WIDTH>
+    bool IsRegionConnected(const std::vector<unsigned int> & region_of_cell, unsigned int region, unsigned int start)
+    {
+      std::vector<uint8_t> is_reached(WIDTH * WIDTH, 0);
+      std::queue<unsigned int> cells;
+      is_reached[start] = 1;
+      cells.push(start);
+      unsigned int num_of_reached = 1;
+      while(!cells.empty())
+      {
+        const unsigned int index = cells.front(), row = index / WIDTH, col = index % WIDTH;
+        cells.pop();
+        const unsigned int neighbours[4] = {row > 0 ? index - WIDTH : index, row + 1 < WIDTH ? index + WIDTH : index,
+                                            col > 0 ? index - 1 : index, col + 1 < WIDTH ? index + 1 : index};
+        for(unsigned int next : neighbours)
+        {
+          if(!is_reached[next] && region_of_cell[next] == region)
+          {
+            is_reached[next] = 1;
+            ++num_of_reached;
+            cells.push(next);
+          }
+        }
+      }
+      return WIDTH == num_of_reached;
+    }
+
+    /* Reshape regions at random, starting from regions (of a jigsaw board). A cell a
+       on the border of its region A moves to the region B next to it, and a cell b of
+       B next to A moves to A in exchange. The exchange is undone if A or B is no longer
+       in one piece.
+    */
+    template<typename JigsawSudokuBoard>
+    std::vector<std::vector<unsigned int>> DrawRandomRegions(const std::vector<std::vector<unsigned int>> & regions)
+    {
+      constexpr unsigned int width = JigsawSudokuBoard::width;
+      constexpr unsigned int end_index = width * width;
+
+      std::vector<unsigned int> region_of_cell(end_index, 0);
+      for(unsigned int region = 0; region < width; ++region)
+      {
+        for(unsigned int index : regions[region])
+          region_of_cell[index] = region;
+      }
+      // neighbour of index in direction (up, down, left, right), index itself at the border.
+      auto neighbour_of = [](unsigned int index, unsigned int direction)
+      {
+        const unsigned int row = index / width, col = index % width;
+        switch(direction)
+        {
+          case 0: return row > 0 ? index - width : index;
+          case 1: return row + 1 < width ? index + width : index;
+          case 2: return col > 0 ? index - 1 : index;
+          default: return col + 1 < width ? index + 1 : index;
+        }
+      };
+
+      unsigned int num_of_exchanges = 0;
+      std::vector<unsigned int> exchangeable;
+      for(unsigned int attempt = 0; attempt < 20 * end_index && num_of_exchanges < 2 * end_index; ++attempt)
+      {
+        const unsigned int a = RandomIndex(end_index);
+        const unsigned int region_a = region_of_cell[a];
+        const unsigned int region_b = region_of_cell[neighbour_of(a, RandomIndex(4))];
+        if(region_a == region_b)
+          continue;
+        exchangeable.clear();
+        for(unsigned int index = 0; index < end_index; ++index)
+        {
+          if(region_of_cell[index] != region_b)
+            continue;
+          for(unsigned int direction = 0; direction < 4; ++direction)
+          {
+            const unsigned int next = neighbour_of(index, direction);
+            if(next != a && region_of_cell[next] == region_a)
+            {
+              exchangeable.push_back(index);
+              break;
+            }
+          }
+        }
+        if(exchangeable.empty())
+          continue;
+        const unsigned int b = exchangeable[RandomIndex(static_cast<unsigned int>(exchangeable.size()))];
+        region_of_cell[a] = region_b;
+        region_of_cell[b] = region_a;
+        if(IsRegionConnected<width>(region_of_cell, region_a, b) && IsRegionConnected<width>(region_of_cell, region_b, a))
+        {
+          ++num_of_exchanges;
+          continue;
+        }
+        region_of_cell[a] = region_a;
+        region_of_cell[b] = region_b;
+      }
+
+      std::vector<std::vector<unsigned int>> new_regions(width);
+      for(unsigned int index = 0; index < end_index; ++index)
+        new_regions[region_of_cell[index]].push_back(index);
+      return new_regions;
+    }
+
+    /* Jigsaw boards get new regions before cells are set vacant, so
+       GenerateSolvableBoard<JigsawBoard> generates jigsaw puzzles. The final board is
+       filled again to fit the new regions, which are drawn again if it takes too long.
+    */
+    template<typename CELL, unsigned int WIDTH>
+    void PrepareToDig(GenericJigsawBoard<CELL, WIDTH> & final_board)
+    {
+      typedef GenericJigsawBoard<CELL, WIDTH> JigsawSudokuBoard;
+      StatsRecorder recorder(nullptr);
+      while(true)
+      {
+        JigsawSudokuBoard empty_board;
+        empty_board.setRegions(DrawRandomRegions<JigsawSudokuBoard>(final_board.regions()));
+        CandidateGrid<JigsawSudokuBoard> grid{empty_board};
+        unsigned int node_budget = 20 * WIDTH * WIDTH;
+        if(FillRandomly<JigsawSudokuBoard>(grid, node_budget, recorder))
+        {
+          final_board = grid.board();
+          final_board.rehash();
+          return;
+        }
+        TRACE_INSTANT("RegionsRestart", 0);
+      }
+    }
+  }
+}
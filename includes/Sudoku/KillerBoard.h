@@ -0,0 +1,215 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <fstream>
+#include <array>
+#include <algorithm>
+
+#include "Generic/GenericBoard.h"
+#include "Generic/RegionLayout.h"
+#include "SudokuCell.h"
+#include "CageCombinations.h"
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    /* GenericKillerBoard is a sudoku board with cages on top of its rows, columns and
+       boxes. A cage is a group of cells whose digits are all different and add up to
+       the sum of the cage. A cell belongs to at most one cage, and may belong to none.
+       The cages are part of the layout of the board, as units with a sum, so the
+       solvers in SudokuEngine.h prune them with the tables of CageCombinations.h.
+       Boards copied from each other share the same layout.
+
+       Files hold the values, then the cage of every cell (1 for the first cage, 0 for
+       none) laid out the same way, then the sums of the cages in order on one line.
+    */
+    template<typename CELL, unsigned int WIDTH = CELL::values_length>
+    class GenericKillerBoard : public GenericBoard<CELL, WIDTH>
+    {
+    public:
+      typedef GenericBoard<CELL, WIDTH> BaseBoard;
+      using BaseBoard::width;
+      using BaseBoard::box_height;
+      using BaseBoard::box_width;
+      static constexpr bool has_box_layout = false;
+      static_assert(CELL::values_length <= MAX_CAGE_DIGIT, "Cages hold digits from 1 to 9 only.");
+
+      struct Cage
+      {
+        unsigned int sum;
+        std::vector<unsigned int> cells;
+      };
+
+      GenericKillerBoard() = default;
+      using BaseBoard::BaseBoard;
+
+      const RegionLayout & layout() const;
+      const std::vector<Cage> & cages() const;
+
+      /* Replace the cages. The cages are kept unchanged and false is returned if a cell
+         is out of the board or in two cages, or if no distinct digits of a cage can add
+         up to its sum.
+      */
+      bool setCages(std::vector<Cage> new_cages);
+
+      bool writeToFile(const std::string & path = DEFAULT_FILE_NAME) const;
+      bool loadFromFile(const std::string & path);
+      bool parse(BoardTextReader & reader);
+
+      friend std::ostream & operator<<(std::ostream & os, const GenericKillerBoard & killerBoard)
+      {
+        os << static_cast<const BaseBoard &>(killerBoard);
+        std::array<unsigned int, width * width> cage_of_cell;
+        cage_of_cell.fill(0);
+        const std::vector<Cage> & cages = killerBoard.cages();
+        for(unsigned int cage = 0; cage < cages.size(); ++cage)
+        {
+          for(unsigned int index : cages[cage].cells)
+            cage_of_cell[index] = cage + 1;
+        }
+        // a cage number is no longer than a value of an unsigned int cell.
+        char text[MaxFormattedLength<BaseBoard>(BoardFormat::grid) + width * width * 4];
+        char * out = WriteBoardGrid(text, width, box_height, box_width,
+                                    [&cage_of_cell](unsigned int index, char * field)
+                                    {
+                                      return WriteDecimal(cage_of_cell[index], field);
+                                    });
+        for(unsigned int cage = 0; cage < cages.size(); ++cage)
+        {
+          if(cage)
+            *out++ = ' ';
+          out = WriteDecimal(cages[cage].sum, out);
+        }
+        *out++ = '\n';
+        os.write(text, static_cast<std::streamsize>(out - text));
+        return os;
+      }
+
+      friend std::istream & operator>>(std::istream & is, GenericKillerBoard & killerBoard)
+      {
+        return ReadBoard(is, killerBoard);
+      }
+
+    private:
+      // the cages and the layout of a board without cages.
+      static std::shared_ptr<const std::vector<Cage>> NoCages();
+      static std::shared_ptr<const RegionLayout> BoxUnitsOnly();
+
+      // shared by copies, as boards are copied all along a search.
+      std::shared_ptr<const std::vector<Cage>> cage_list = NoCages();
+      std::shared_ptr<const RegionLayout> regions = BoxUnitsOnly();
+    };
+
+    template<typename CELL, unsigned int WIDTH>
+    std::shared_ptr<const std::vector<typename GenericKillerBoard<CELL,WIDTH>::Cage>> GenericKillerBoard<CELL,WIDTH>::NoCages()
+    {
+      static const std::shared_ptr<const std::vector<Cage>> no_cages = std::make_shared<const std::vector<Cage>>();
+      return no_cages;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    std::shared_ptr<const RegionLayout> GenericKillerBoard<CELL,WIDTH>::BoxUnitsOnly()
+    {
+      static const std::shared_ptr<const RegionLayout> box_units =
+          std::shared_ptr<const RegionLayout>(new RegionLayout(width, BoxUnits(width, box_height, box_width)));
+      return box_units;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    inline const RegionLayout & GenericKillerBoard<CELL,WIDTH>::layout() const
+    {
+      return *regions;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    inline const std::vector<typename GenericKillerBoard<CELL,WIDTH>::Cage> & GenericKillerBoard<CELL,WIDTH>::cages() const
+    {
+      return *cage_list;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    bool GenericKillerBoard<CELL,WIDTH>::setCages(std::vector<Cage> new_cages)
+    {
+      std::vector<uint8_t> is_caged(width * width, 0);
+      std::vector<std::vector<unsigned int>> units = BoxUnits(width, box_height, box_width);
+      std::vector<unsigned int> sums(units.size(), 0);
+      for(const auto & cage : new_cages)
+      {
+        for(unsigned int index : cage.cells)
+        {
+          if(index >= width * width || is_caged[index])
+            return false;
+          is_caged[index] = 1;
+        }
+        if(0 == CageCombinations(static_cast<unsigned int>(cage.cells.size()), static_cast<int>(cage.sum)))
+          return false;
+        units.push_back(cage.cells);
+        sums.push_back(cage.sum);
+      }
+      if(new_cages.empty())
+      {
+        regions = BoxUnitsOnly();
+        cage_list = NoCages();
+        return true;
+      }
+      regions = std::shared_ptr<const RegionLayout>(new RegionLayout(width, std::move(units), std::move(sums)));
+      cage_list = std::make_shared<const std::vector<Cage>>(std::move(new_cages));
+      return true;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    bool GenericKillerBoard<CELL,WIDTH>::writeToFile(const std::string & path) const
+    {
+      std::ofstream ofs(path, std::ofstream::out);
+      if(ofs)
+      {
+        ofs << *this;
+        return true;
+      }
+      return false;
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    bool GenericKillerBoard<CELL,WIDTH>::loadFromFile(const std::string & path)
+    {
+      return LoadBoardFile(path, *this);
+    }
+
+    template<typename CELL, unsigned int WIDTH>
+    bool GenericKillerBoard<CELL,WIDTH>::parse(BoardTextReader & reader)
+    {
+      BaseBoard values;
+      if(!values.parse(reader))
+        return false;
+      std::vector<unsigned int> cage_of_cell(width * width, 0);
+      unsigned int num_of_cages = 0;
+      for(unsigned int index = 0; index < width * width; ++index)
+      {
+        if(!reader.readNumber(cage_of_cell[index], width * width))
+          return false;
+        num_of_cages = std::max(num_of_cages, cage_of_cell[index]);
+      }
+      std::vector<Cage> new_cages(num_of_cages);
+      for(unsigned int cage = 0; cage < num_of_cages; ++cage)
+      {
+        if(!reader.readNumber(new_cages[cage].sum, width * (width + 1) / 2))
+          return false;
+      }
+      for(unsigned int index = 0; index < width * width; ++index)
+      {
+        if(cage_of_cell[index])
+          new_cages[cage_of_cell[index] - 1].cells.push_back(index);
+      }
+      if(!setCages(std::move(new_cages)))
+        return reader.fail("no distinct digits of a cage add up to its sum");
+      BaseBoard::operator=(values);
+      return true;
+    }
+
+    typedef GenericKillerBoard<SudokuCell> KillerBoard;
+  }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "SudokuEngine.h"
+#include "KillerBoard.h"
+
+/* Generation of killer sudoku boards. Solving, uniqueness and levels need nothing
+   more than SudokuEngine.h, which reads the cages from the layout of the board.
+   Including this file lets GenerateSolvableBoard draw the cages of killer boards.
+*/
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    constexpr unsigned int MIN_CAGE_SIZE = 2;
+    constexpr unsigned int MAX_CAGE_SIZE = 5;
+
+    /* Split a final board into cages. Each cage starts on a random cell out of every
+       cage so far and grows to a random size between MIN_CAGE_SIZE and MAX_CAGE_SIZE,
+       one random neighbour (up, down, left, right) at a time, taking only digits not
+       in the cage yet. A cage which cannot grow stays smaller, possibly a single cell.
+       The sums are read from the board.
+    */
+    template<typename KillerSudokuBoard>
+    std::vector<typename KillerSudokuBoard::Cage> DrawRandomCages(const KillerSudokuBoard & final_board)
+    {
+      typedef typename KillerSudokuBoard::Cell Cell;
+      typedef typename Cell::ValueType ValueType;
+      constexpr unsigned int width = KillerSudokuBoard::width;
+      constexpr unsigned int end_index = width * width;
+
+      auto digit_of = [&final_board](unsigned int index)
+      {
+        return static_cast<unsigned int>(static_cast<ValueType>(final_board[index / width][index % width]) -
+                                         Cell::minimum_value) + 1;
+      };
+
+      std::vector<unsigned int> order(end_index);
+      for(unsigned int index = 0; index < end_index; ++index)
+        order[index] = index;
+      std::shuffle(order.begin(), order.end(), RandomEngine());
+
+      std::vector<uint8_t> is_caged(end_index, 0);
+      std::vector<typename KillerSudokuBoard::Cage> cages;
+      for(unsigned int start : order)
+      {
+        if(is_caged[start])
+          continue;
+        typename KillerSudokuBoard::Cage cage{digit_of(start), {start}};
+        is_caged[start] = 1;
+        unsigned int used_digits = 1u << digit_of(start);
+        const unsigned int size = MIN_CAGE_SIZE + RandomIndex(MAX_CAGE_SIZE - MIN_CAGE_SIZE + 1);
+        while(cage.cells.size() < size)
+        {
+          std::vector<unsigned int> neighbours;
+          for(unsigned int index : cage.cells)
+          {
+            const unsigned int row = index / width, col = index % width;
+            const unsigned int candidates[4] = {row > 0 ? index - width : end_index,
+                                                row + 1 < width ? index + width : end_index,
+                                                col > 0 ? index - 1 : end_index,
+                                                col + 1 < width ? index + 1 : end_index};
+            for(unsigned int next : candidates)
+            {
+              if(next < end_index && !is_caged[next] && !(used_digits & (1u << digit_of(next))))
+                neighbours.push_back(next);
+            }
+          }
+          if(neighbours.empty())
+            break;
+          unsigned int next = neighbours[RandomIndex(static_cast<unsigned int>(neighbours.size()))];
+          is_caged[next] = 1;
+          used_digits |= 1u << digit_of(next);
+          cage.sum += digit_of(next);
+          cage.cells.push_back(next);
+        }
+        cages.push_back(cage);
+      }
+      return cages;
+    }
+
+    /* Killer boards get their cages before cells are set vacant, so
+       GenerateSolvableBoard<KillerBoard> generates killer puzzles.
+    */
+    template<typename CELL, unsigned int WIDTH>
+    inline void PrepareToDig(GenericKillerBoard<CELL, WIDTH> & final_board)
+    {
+      final_board.setCages(DrawRandomCages<GenericKillerBoard<CELL, WIDTH>>(final_board));
+    }
+  }
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+
+#include "Generic/GenericBoard.h"
+#include "Generic/RegionLayout.h"
+#include "SudokuCell.h"
+#include "SudokuBoard.h"
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    /* SamuraiBoard is a 21x21 board made of five 9x9 sudoku grids: four in the
+       corners and one in the center sharing a corner box with each of them.
+
+        A A A . B B B
+        A A A . B B B
+        A A X C Y B B        every letter is a 3x3 box, the dots
+        . . C C C . .        are inactive boxes.
+        D D Z C W E E
+        D D D . E E E
+        D D D . E E E
+
+       Every grid keeps the rules of sudoku on its own rows, columns and boxes. The
+       four shared boxes (X, Y, Z, W) belong to two grids at the same time, so the
+       solvers in SudokuEngine.h see the whole board as one set of constraints.
+       The 72 cells out of the five grids are inactive: they are always vacant and
+       take no part in the game.
+       Files hold the values of the active cells only, row by row.
+    */
+    class SamuraiBoard : public GenericBoard<SudokuCell, 21>
+    {
+    public:
+      static constexpr unsigned int number_of_grids = 5;
+      // width of each of the five grids, and size of their boxes.
+      static constexpr unsigned int sub_width = SudokuCell::values_length;
+      static constexpr unsigned int box_height = 3;
+      static constexpr unsigned int box_width = 3;
+      static constexpr bool has_box_layout = false;
+
+      SamuraiBoard() = default;
+      using GenericBoard<SudokuCell, 21>::GenericBoard;
+
+      // top left cell of each grid: top left, top right, center, bottom left, bottom right.
+      static unsigned int gridRow(unsigned int grid);
+      static unsigned int gridCol(unsigned int grid);
+
+      const RegionLayout & layout() const;
+
+      // one of the five grids as a regular sudoku board.
+      SudokuBoard subBoard(unsigned int grid) const;
+
+      bool writeToFile(const std::string & path = DEFAULT_FILE_NAME) const;
+      bool loadFromFile(const std::string & path);
+      bool parse(BoardTextReader & reader);
+
+      friend std::ostream & operator<<(std::ostream & os, const SamuraiBoard & samuraiBoard)
+      {
+        // inactive cells are left blank.
+        char text[MaxFormattedLength<SamuraiBoard>(BoardFormat::grid)];
+        os.write(text, static_cast<std::streamsize>(FormatBoard(samuraiBoard, BoardFormat::grid, text, sizeof(text))));
+        return os;
+      }
+
+      friend std::istream & operator>>(std::istream & is, SamuraiBoard & samuraiBoard)
+      {
+        return ReadBoard(is, samuraiBoard);
+      }
+    };
+
+    inline unsigned int SamuraiBoard::gridRow(unsigned int grid)
+    {
+      return (grid < 2) ? 0 : ((2 == grid) ? 6 : 12);
+    }
+
+    inline unsigned int SamuraiBoard::gridCol(unsigned int grid)
+    {
+      return (2 == grid) ? 6 : ((grid % 3 == 0) ? 0 : 12);
+    }
+
+    inline const RegionLayout & SamuraiBoard::layout() const
+    {
+      static const RegionLayout samurai_layout = []
+      {
+        // rows, columns and boxes of every grid. The shared boxes come twice and are
+        // kept once by RegionLayout.
+        std::vector<std::vector<unsigned int>> units;
+        for(unsigned int grid = 0; grid < number_of_grids; ++grid)
+        {
+          RegionLayout grid_layout = BoxLayout(sub_width, box_height, box_width);
+          for(unsigned int unit = 0; unit < grid_layout.numberOfUnits(); ++unit)
+          {
+            std::vector<unsigned int> cells;
+            for(unsigned int k = 0; k < grid_layout.unitSize(unit); ++k)
+            {
+              unsigned int sub_index = grid_layout.unitCells(unit)[k];
+              cells.push_back((gridRow(grid) + sub_index / sub_width) * width +
+                              gridCol(grid) + sub_index % sub_width);
+            }
+            units.push_back(cells);
+          }
+        }
+        return RegionLayout(width, std::move(units));
+      }();
+      return samurai_layout;
+    }
+
+    inline SudokuBoard SamuraiBoard::subBoard(unsigned int grid) const
+    {
+      SudokuBoard sub_board;
+      for(unsigned int row = 0; row < sub_width; ++row)
+      {
+        for(unsigned int col = 0; col < sub_width; ++col)
+        {
+          const SudokuCell & cell = (*this)[gridRow(grid) + row][gridCol(grid) + col];
+          if(!cell.isVacant())
+            sub_board[row][col] = static_cast<SudokuCell::ValueType>(cell);
+        }
+      }
+      sub_board.rehash();
+      return sub_board;
+    }
+
+    inline bool SamuraiBoard::writeToFile(const std::string & path) const
+    {
+      std::ofstream ofs(path, std::ofstream::out);
+      if(ofs)
+      {
+        ofs << *this;
+        return true;
+      }
+      return false;
+    }
+
+    inline bool SamuraiBoard::loadFromFile(const std::string & path)
+    {
+      return LoadBoardFile(path, *this);
+    }
+
+    inline bool SamuraiBoard::parse(BoardTextReader & reader)
+    {
+      const RegionLayout & layout = this->layout();
+      std::vector<uint8_t> digits(layout.numberOfActiveCells());
+      if(!reader.readCells(sub_width, digits.data(), layout.numberOfActiveCells()))
+        return false;
+      unsigned int active_index = 0;
+      for(unsigned int index = 0; index < width * width; ++index)
+      {
+        if(layout.isActive(index))
+          (*this)[index / width][index % width] = digits[active_index++];
+        else
+          (*this)[index / width][index % width].reset();
+      }
+      rehash();
+      return true;
+    }
+  }
+}
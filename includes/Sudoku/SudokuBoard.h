@@ -13,6 +13,12 @@ namespace wubinboardgames
     typedef GenericBoard<ExtendedSudokuCell> ExtendedSudokuBoard;
     typedef GenericBoard<PunctuationSudokuCell> PunctuationSudokuBoard;
     typedef GenericBoard<ExtendedAlphaSudokuCell> ExtendedAlphaSudokuBoard;
+    typedef GenericBoard<GiantSudokuCell> GiantSudokuBoard;
+    typedef GenericBoard<ColossalSudokuCell> ColossalSudokuBoard;
+    // boards with rectangular boxes: box height, then box width.
+    typedef GenericBoard<MiniSudokuCell, 6, 2, 3> MiniSudokuBoard;
+    typedef GenericBoard<OctoSudokuCell, 8, 2, 4> OctoSudokuBoard;
+    typedef GenericBoard<DozenSudokuCell, 12, 3, 4> DozenSudokuBoard;
   }
 
 }
\ No newline at end of file
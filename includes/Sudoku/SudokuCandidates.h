@@ -0,0 +1,452 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#include "Generic/RegionLayout.h"
+#include "Generic/Zobrist.h"
+#include "CageCombinations.h"
+
+/* CandidateGrid keeps, for every unit (row, column, box, ...) of a sudoku board, a
+   bit mask of the values already used. The candidates of a vacant cell are then found
+   with a few ORs instead of scanning its units. The units come from the layout() of
+   the board, so boards made of overlapping grids are searched the same way.
+   Units with a sum (killer cages) also keep the sum left and their vacant cells, and
+   limit the candidates of their cells to the digits of CageCombinations.
+   It also keeps the list of vacant cells so a search can pick the most constrained
+   cell (MRV) quickly.
+   It is the working state of the mask-based searches in SudokuEngine.h.
+*/
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    // bit mask wide enough to hold one bit per value of a cell.
+    template<unsigned int VALUES_LENGTH>
+    struct ValueMask
+    {
+      typedef typename std::conditional<(VALUES_LENGTH <= 32), uint32_t, uint64_t>::type type;
+    };
+
+    inline unsigned int PopCount(uint64_t mask)
+    {
+      return static_cast<unsigned int>(__builtin_popcountll(mask));
+    }
+
+    inline unsigned int LowestBit(uint64_t mask)
+    {
+      return static_cast<unsigned int>(__builtin_ctzll(mask));
+    }
+
+    template<typename SudokuBoard>
+    class CandidateGrid
+    {
+    public:
+      static constexpr unsigned int width = SudokuBoard::width;
+      static constexpr unsigned int end_index = width * width;
+      static constexpr unsigned int vacant_value = 0xFF;
+      typedef typename SudokuBoard::Cell Cell;
+      typedef typename Cell::ValueType ValueType;
+      static constexpr unsigned int values_length = Cell::values_length;
+      typedef typename ValueMask<values_length>::type Mask;
+      static constexpr Mask full_mask = static_cast<Mask>((static_cast<uint64_t>(1) << values_length) - 1);
+      // units of box layouts are rows, columns then boxes, and are computed instead of looked up.
+      static constexpr bool box_layout = SudokuBoard::has_box_layout;
+      static constexpr unsigned int box_height = SudokuBoard::box_height;
+      static constexpr unsigned int box_width = SudokuBoard::box_width;
+
+      explicit CandidateGrid(const SudokuBoard & board);
+
+      // false if the givens already break the rule of sudoku.
+      bool isConsistent() const;
+      unsigned int numberOfVacants() const;
+      // the index (row * width + col) of the n-th vacant cell.
+      unsigned int vacantAt(unsigned int n) const;
+      bool isVacant(unsigned int index) const;
+      const RegionLayout & layout() const;
+
+      // bit i set means minimum_value + i can be put on the cell.
+      Mask candidates(unsigned int index) const;
+
+      // value_offset is the value minus the minimum value of the cell.
+      void assign(unsigned int index, unsigned int value_offset);
+      // undo the last assign(). assign/unassign must be called in LIFO order.
+      void unassign(unsigned int index);
+
+      /* Pick the vacant cell with fewest candidates. Returns false if some vacant cell
+         has no candidate at all, which means the state is a dead end.
+      */
+      bool mostConstrainedCell(unsigned int & index, Mask & mask) const;
+
+      /* Key of the sub-problem left to solve: the vacant cells with their candidates.
+         Two states with equal keys have the same number of completions, no matter
+         which values were put on the filled cells.
+      */
+      uint64_t subproblemKey() const;
+
+      /* Fill naked singles (cells with one candidate) and hidden singles (values that
+         fit in only one cell of a unit) round after round until nothing changes.
+         Every assigned cell is appended to trail so the caller can unassign them.
+         rounds returns the number of rounds that assigned something. Returns false
+         if a contradiction is found.
+      */
+      bool propagateSingles(std::vector<uint16_t> & trail, unsigned int & rounds);
+
+      const SudokuBoard & board() const;
+
+    private:
+      static unsigned int rowOf(unsigned int index);
+      static unsigned int colOf(unsigned int index);
+      static unsigned int gridOf(unsigned int index);
+      Mask usedValues(unsigned int index) const;
+      void markUsed(unsigned int index, Mask bit);
+      void markUnused(unsigned int index, Mask bit);
+      // keep the sum left of the cage of the cell. digit is value_offset + 1.
+      void addToSum(unsigned int index, int digit);
+
+      SudokuBoard work_board;
+      const RegionLayout * regions;
+      // one mask per unit, and a last one for the padding unit which stays 0.
+      std::vector<Mask> unit_used;
+      // for units with a sum: the sum left to reach and the number of vacant cells.
+      std::vector<int> sum_left;
+      std::vector<uint8_t> vacants_in_unit;
+      std::array<uint8_t, end_index> values;
+      // vacant cells are kept in vacants[0, vacant_count). vacant_position is the
+      // reverse lookup used to remove a cell in O(1). Inactive cells are never vacant.
+      std::array<uint16_t, end_index> vacants;
+      std::array<uint16_t, end_index> vacant_position;
+      unsigned int vacant_count;
+      // (cell, value_offset) found in one round of propagateSingles(), applied together
+      // at its end. Kept so that the searches calling it at every node reuse the buffer.
+      std::vector<std::pair<uint16_t, uint8_t>> singles;
+      bool consistent;
+    };
+
+    template<typename SudokuBoard>
+    CandidateGrid<SudokuBoard>::CandidateGrid(const SudokuBoard & board)
+        : work_board(board), regions(&work_board.layout()),
+          unit_used(regions->numberOfUnits() + 1, 0), vacant_count(0), consistent(true)
+    {
+      if(regions->hasSums())
+      {
+        sum_left.resize(unit_used.size());
+        vacants_in_unit.assign(unit_used.size(), 0);
+        for(unsigned int unit = 0; unit < regions->numberOfUnits(); ++unit)
+          sum_left[unit] = static_cast<int>(regions->unitSum(unit));
+      }
+      static_assert(values_length <= 64, "Candidate masks cannot hold more than 64 values.");
+      for(unsigned int index = 0; index < end_index; ++index)
+      {
+        const Cell & cell = board[index / width][index % width];
+        values[index] = vacant_value;
+        if(!regions->isActive(index))
+          continue;
+        // counted vacant first, then filled like assign() does.
+        addToSum(index, 0);
+        if(cell.isVacant())
+        {
+          vacant_position[index] = static_cast<uint16_t>(vacant_count);
+          vacants[vacant_count++] = static_cast<uint16_t>(index);
+          continue;
+        }
+        // unsigned, so that a value below the minimum wraps past values_length.
+        unsigned int value_offset = static_cast<unsigned int>(static_cast<ValueType>(cell)) -
+                                    static_cast<unsigned int>(Cell::minimum_value);
+        if(!cell.isValid() || value_offset >= values_length)
+        {
+          consistent = false;
+          continue;
+        }
+        Mask bit = static_cast<Mask>(static_cast<Mask>(1) << value_offset);
+        if(usedValues(index) & bit)
+          consistent = false;
+        markUsed(index, bit);
+        values[index] = static_cast<uint8_t>(value_offset);
+        addToSum(index, static_cast<int>(value_offset) + 1);
+      }
+      // the givens must leave a reachable sum to every cage.
+      for(unsigned int unit = 0; regions->hasSums() && unit < regions->numberOfUnits(); ++unit)
+      {
+        if(!regions->unitSum(unit))
+          continue;
+        if(vacants_in_unit[unit] ? !CageCombinations(vacants_in_unit[unit], sum_left[unit]) : (0 != sum_left[unit]))
+          consistent = false;
+      }
+    }
+
+    template<typename SudokuBoard>
+    inline void CandidateGrid<SudokuBoard>::addToSum(unsigned int index, int digit)
+    {
+      if(box_layout || !regions->hasSums())
+        return;
+      uint16_t unit = regions->sumUnitOf(index);
+      if(RegionLayout::no_sum == unit)
+        return;
+      // digit 0 counts a vacant cell, a negative digit takes the digit of a cell back.
+      if(digit > 0)
+        --vacants_in_unit[unit];
+      else
+        ++vacants_in_unit[unit];
+      sum_left[unit] -= digit;
+    }
+
+    template<typename SudokuBoard>
+    inline unsigned int CandidateGrid<SudokuBoard>::rowOf(unsigned int index)
+    {
+      return index / width;
+    }
+
+    template<typename SudokuBoard>
+    inline unsigned int CandidateGrid<SudokuBoard>::colOf(unsigned int index)
+    {
+      return index % width;
+    }
+
+    template<typename SudokuBoard>
+    inline unsigned int CandidateGrid<SudokuBoard>::gridOf(unsigned int index)
+    {
+      return (width / box_width) * (rowOf(index) / box_height) + colOf(index) / box_width;
+    }
+
+    template<typename SudokuBoard>
+    inline typename CandidateGrid<SudokuBoard>::Mask CandidateGrid<SudokuBoard>::usedValues(unsigned int index) const
+    {
+      if(box_layout)
+        return static_cast<Mask>(unit_used[rowOf(index)] | unit_used[width + colOf(index)] |
+                                 unit_used[2 * width + gridOf(index)]);
+      const uint16_t * units = regions->cellUnits(index);
+      Mask used = 0;
+      for(unsigned int n = 0; n < regions->unitsPerCell(); ++n)
+        used |= unit_used[units[n]];
+      return used;
+    }
+
+    template<typename SudokuBoard>
+    inline void CandidateGrid<SudokuBoard>::markUsed(unsigned int index, Mask bit)
+    {
+      if(box_layout)
+      {
+        unit_used[rowOf(index)] |= bit;
+        unit_used[width + colOf(index)] |= bit;
+        unit_used[2 * width + gridOf(index)] |= bit;
+        return;
+      }
+      const uint16_t * units = regions->cellUnits(index);
+      for(unsigned int n = 0; n < regions->unitsPerCell(); ++n)
+        unit_used[units[n]] |= bit;
+      // the padding unit must stay empty.
+      unit_used.back() = 0;
+    }
+
+    template<typename SudokuBoard>
+    inline void CandidateGrid<SudokuBoard>::markUnused(unsigned int index, Mask bit)
+    {
+      if(box_layout)
+      {
+        unit_used[rowOf(index)] &= static_cast<Mask>(~bit);
+        unit_used[width + colOf(index)] &= static_cast<Mask>(~bit);
+        unit_used[2 * width + gridOf(index)] &= static_cast<Mask>(~bit);
+        return;
+      }
+      const uint16_t * units = regions->cellUnits(index);
+      for(unsigned int n = 0; n < regions->unitsPerCell(); ++n)
+        unit_used[units[n]] &= static_cast<Mask>(~bit);
+    }
+
+    template<typename SudokuBoard>
+    inline bool CandidateGrid<SudokuBoard>::isVacant(unsigned int index) const
+    {
+      return vacant_value == values[index];
+    }
+
+    template<typename SudokuBoard>
+    inline bool CandidateGrid<SudokuBoard>::isConsistent() const
+    {
+      return consistent;
+    }
+
+    template<typename SudokuBoard>
+    inline unsigned int CandidateGrid<SudokuBoard>::numberOfVacants() const
+    {
+      return vacant_count;
+    }
+
+    template<typename SudokuBoard>
+    inline unsigned int CandidateGrid<SudokuBoard>::vacantAt(unsigned int n) const
+    {
+      return vacants[n];
+    }
+
+    template<typename SudokuBoard>
+    inline const RegionLayout & CandidateGrid<SudokuBoard>::layout() const
+    {
+      return *regions;
+    }
+
+    template<typename SudokuBoard>
+    inline typename CandidateGrid<SudokuBoard>::Mask CandidateGrid<SudokuBoard>::candidates(unsigned int index) const
+    {
+      Mask mask = static_cast<Mask>(full_mask & ~usedValues(index));
+      if(box_layout || !regions->hasSums())
+        return mask;
+      uint16_t unit = regions->sumUnitOf(index);
+      if(RegionLayout::no_sum == unit)
+        return mask;
+      return static_cast<Mask>(mask & CageCombinations(vacants_in_unit[unit], sum_left[unit]));
+    }
+
+    template<typename SudokuBoard>
+    inline void CandidateGrid<SudokuBoard>::assign(unsigned int index, unsigned int value_offset)
+    {
+      markUsed(index, static_cast<Mask>(static_cast<Mask>(1) << value_offset));
+      values[index] = static_cast<uint8_t>(value_offset);
+      addToSum(index, static_cast<int>(value_offset) + 1);
+      work_board.assign(rowOf(index), colOf(index), static_cast<ValueType>(Cell::minimum_value + value_offset));
+
+      // swap the last vacant cell into the slot of this one.
+      unsigned int position = vacant_position[index];
+      uint16_t last = vacants[--vacant_count];
+      vacants[position] = last;
+      vacant_position[last] = static_cast<uint16_t>(position);
+      // keep where the cell was, unassign() puts it back there.
+      vacant_position[index] = static_cast<uint16_t>(position);
+    }
+
+    template<typename SudokuBoard>
+    inline void CandidateGrid<SudokuBoard>::unassign(unsigned int index)
+    {
+      markUnused(index, static_cast<Mask>(static_cast<Mask>(1) << values[index]));
+      addToSum(index, -(static_cast<int>(values[index]) + 1));
+      values[index] = vacant_value;
+      work_board.vacate(rowOf(index), colOf(index));
+
+      // reverse the swap done by assign()
+      unsigned int position = vacant_position[index];
+      uint16_t moved = vacants[position];
+      vacants[vacant_count] = moved;
+      vacant_position[moved] = static_cast<uint16_t>(vacant_count);
+      vacants[position] = static_cast<uint16_t>(index);
+      vacant_position[index] = static_cast<uint16_t>(position);
+      ++vacant_count;
+    }
+
+    template<typename SudokuBoard>
+    bool CandidateGrid<SudokuBoard>::mostConstrainedCell(unsigned int & index, Mask & mask) const
+    {
+      unsigned int best_count = values_length + 1;
+      for(unsigned int n = 0; n < vacant_count; ++n)
+      {
+        Mask cell_mask = candidates(vacants[n]);
+        unsigned int count = PopCount(cell_mask);
+        if(count < best_count)
+        {
+          best_count = count;
+          index = vacants[n];
+          mask = cell_mask;
+          // nothing beats a dead end or a forced cell.
+          if(count <= 1)
+            break;
+        }
+      }
+      return best_count > 0;
+    }
+
+    template<typename SudokuBoard>
+    uint64_t CandidateGrid<SudokuBoard>::subproblemKey() const
+    {
+      uint64_t key = 0;
+      for(unsigned int n = 0; n < vacant_count; ++n)
+      {
+        uint64_t index = vacants[n];
+        uint64_t cell_key = (index << 40) ^ candidates(vacants[n]);
+        // cells of a cage also depend on the sum left. Cages only hold digits up to 9,
+        // so their candidates never reach bit 16.
+        if(!box_layout && regions->hasSums() && RegionLayout::no_sum != regions->sumUnitOf(vacants[n]))
+          cell_key ^= static_cast<uint64_t>(sum_left[regions->sumUnitOf(vacants[n])]) << 16;
+        key ^= SplitMix64(cell_key);
+      }
+      return key;
+    }
+
+    template<typename SudokuBoard>
+    bool CandidateGrid<SudokuBoard>::propagateSingles(std::vector<uint16_t> & trail, unsigned int & rounds)
+    {
+      rounds = 0;
+      while(vacant_count)
+      {
+        singles.clear();
+        for(unsigned int n = 0; n < vacant_count; ++n)
+        {
+          Mask mask = candidates(vacants[n]);
+          if(0 == mask)
+            return false;
+          if(1 == PopCount(mask))
+            singles.push_back(std::make_pair(vacants[n], static_cast<uint8_t>(LowestBit(mask))));
+        }
+        for(unsigned int unit = 0; unit < regions->numberOfUnits(); ++unit)
+        {
+          const uint16_t * cells = regions->unitCells(unit);
+          const unsigned int size = regions->unitSize(unit);
+          // seen_once/seen_twice collect which values fit one or several cells of the unit
+          Mask seen_once = 0, seen_twice = 0, placed = 0;
+          for(unsigned int k = 0; k < size; ++k)
+          {
+            unsigned int index = cells[k];
+            if(!isVacant(index))
+            {
+              placed |= static_cast<Mask>(static_cast<Mask>(1) << values[index]);
+              continue;
+            }
+            Mask mask = candidates(index);
+            seen_twice |= static_cast<Mask>(seen_once & mask);
+            seen_once |= mask;
+          }
+          // only a unit with a cell per value must hold every value.
+          if(size < values_length)
+            continue;
+          // a value that fits nowhere in the unit is a contradiction.
+          if((seen_once | placed) != full_mask)
+            return false;
+          Mask hidden = static_cast<Mask>(seen_once & ~seen_twice);
+          for(unsigned int k = 0; hidden && k < size; ++k)
+          {
+            unsigned int index = cells[k];
+            if(!isVacant(index) || !(candidates(index) & hidden))
+              continue;
+            Mask value_bit = static_cast<Mask>(candidates(index) & hidden);
+            singles.push_back(std::make_pair(static_cast<uint16_t>(index), static_cast<uint8_t>(LowestBit(value_bit))));
+            hidden &= static_cast<Mask>(~value_bit);
+          }
+        }
+        if(singles.empty())
+          break;
+        ++rounds;
+        for(const auto & single : singles)
+        {
+          if(!isVacant(single.first))
+          {
+            // found twice in this round. Fine if it is the same value.
+            if(values[single.first] != single.second)
+              return false;
+            continue;
+          }
+          if(!(candidates(single.first) & (static_cast<Mask>(1) << single.second)))
+            return false;
+          assign(single.first, single.second);
+          trail.push_back(single.first);
+        }
+      }
+      return true;
+    }
+
+    template<typename SudokuBoard>
+    inline const SudokuBoard & CandidateGrid<SudokuBoard>::board() const
+    {
+      return work_board;
+    }
+  }
+}
@@ -8,9 +8,14 @@ namespace wubinboardgames
   {
     // instantiated to each type of cells.
     typedef GenericCell<unsigned int, 1, 9> SudokuCell;
+    typedef GenericCell<unsigned int, 1, 6> MiniSudokuCell;
+    typedef GenericCell<unsigned int, 1, 8> OctoSudokuCell;
+    typedef GenericCell<unsigned int, 1, 12> DozenSudokuCell;
     typedef GenericCell<uint8_t, 'a', 9> AlphaSudokuCell;
     typedef GenericCell<uint8_t, ' ', 9> PunctuationSudokuCell;
     typedef GenericCell<unsigned int, 1, 16> ExtendedSudokuCell;
     typedef GenericCell<uint8_t, 'a', 16> ExtendedAlphaSudokuCell;
+    typedef GenericCell<unsigned int, 1, 25> GiantSudokuCell;
+    typedef GenericCell<unsigned int, 1, 36> ColossalSudokuCell;
   }
 }
\ No newline at end of file
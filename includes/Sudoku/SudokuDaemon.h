@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstddef>
+
+#include "SudokuProtocol.h"
+
+/*
+  SudokuDaemon serves solve, grade and generate requests of the binary protocol in
+  SudokuProtocol.h on a Unix domain socket.
+*/
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    struct DaemonOptions
+    {
+      std::string socket_path;
+      unsigned int num_of_workers = std::max(std::thread::hardware_concurrency(), 2u);
+      // requests a worker takes off the queue at once.
+      std::size_t max_batch = 64;
+      // puzzles kept ready for each kind and level asked for.
+      std::size_t pool_size = 8;
+      // budget of the search of each solve or grade request. No node limit if 0.
+      std::chrono::milliseconds solve_timeout{1000};
+      uint64_t solve_node_budget = 0;
+      // a client not reading its replies for that long is hung up on.
+      std::chrono::milliseconds send_timeout{5000};
+    };
+
+    /* The highest level generated for each kind of board. Higher levels take from
+       seconds to forever on the wider boards, so they are answered unsupported.
+    */
+    LEVEL MaxGeneratedLevel(BoardKind kind);
+
+    /* Answer one request, generating on the spot. No pool, no socket. Generations
+       publish into progress, which answers progress requests (unsupported without it).
+       Once cancelled is set, a generation gives up and its cells are meaningless.
+       Solve and grade requests search within budget, and are answered over_budget
+       once it runs out.
+    */
+    DaemonResponse HandleDaemonRequest(const DaemonRequest & request, GenerationProgress * progress = nullptr,
+                                       const std::atomic<bool> * cancelled = nullptr,
+                                       const SolveBudget & budget = SolveBudget());
+
+    /* Listen on options.socket_path until StopSolverDaemon() is called, or SIGINT or
+       SIGTERM is received. Requests read at the same time are queued together and
+       answered in batches by options.num_of_workers workers, the answers of a batch
+       going back to each client in one write. Between requests, the workers refill
+       pools of generated puzzles: regular boards at EASY, MEDIUM and HARD from the
+       start, other kinds and levels once they are asked for. Progress requests report
+       the work of every generation since the start.
+       Returns false if the socket cannot be opened.
+    */
+    bool RunSolverDaemon(const DaemonOptions & options);
+
+    // async-signal-safe.
+    void StopSolverDaemon();
+
+    /* Send requests to the daemon at path over one connection and wait for all of
+       their responses, in the order of the requests. False if the daemon cannot be
+       reached or hangs up.
+    */
+    bool SendDaemonRequests(const std::string & path, const std::vector<DaemonRequest> & requests,
+                            std::vector<DaemonResponse> & responses);
+  }
+}
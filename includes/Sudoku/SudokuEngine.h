@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <array>
 #include <list>
 #include <stack>
 #include <cmath>
@@ -12,8 +13,21 @@
 #include <unordered_map>
 #include <algorithm>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <random>
+#include <atomic>
+#include <type_traits>
 
 #include "Generic/Position.h"
+#include "Generic/TranspositionTable.h"
+#include "Generic/Trace.h"
+#include "Generic/FirstResultRace.h"
+#include "Generic/DeadlineFlag.h"
+#include "SudokuCandidates.h"
+#include "UnavoidableSets.h"
+#include "SudokuStats.h"
 
 /* SudokuEngine is a set of template functions to implement algorithems of
    every type of Sudoku Game. Each type of Sudoku game should only be diffientiated
@@ -44,33 +58,164 @@ namespace wubinboardgames
       EXTREME = 1000000
     };
 
+    // Boards wider than this are searched on the most constrained cell instead of in
+    // raster order, which cannot finish on 25x25 and 36x36 boards.
+    constexpr unsigned int RASTER_SEARCH_MAX_WIDTH = 16;
+
+    // GenerateMinimalBoard walks boards dug at most that many given cells above the
+    // range, for that many steps.
+    constexpr unsigned int MINIMAL_WALK_MAX_EXCESS = 2;
+    constexpr unsigned int MINIMAL_WALK_STEPS = 300;
+
+    // GenerateSolvableBoard climbs from a board dug off its level for that many steps,
+    // starting at that temperature (see ClimbToLevel).
+    constexpr unsigned int LEVEL_CLIMB_STEPS = 100;
+    constexpr double LEVEL_CLIMB_TEMPERATURE = 0.3;
+
+    /* Symmetries of the given cells of generated puzzles: a cell is set vacant along
+       with its image, so the pattern of the given cells maps onto itself.
+    */
+    enum class Symmetry
+    {
+      none,
+      rotational, // half turn around the center
+      diagonal,   // mirror on the main diagonal
+      horizontal, // mirror top to bottom
+      vertical    // mirror left to right
+    };
+
+    // the image of the cell at index.
+    inline unsigned int SymmetricIndex(unsigned int index, unsigned int width, Symmetry symmetry)
+    {
+      const unsigned int row = index / width;
+      const unsigned int col = index % width;
+      switch(symmetry)
+      {
+        case Symmetry::rotational:
+          return (width - 1 - row) * width + width - 1 - col;
+        case Symmetry::diagonal:
+          return col * width + row;
+        case Symmetry::horizontal:
+          return (width - 1 - row) * width + col;
+        case Symmetry::vertical:
+          return row * width + width - 1 - col;
+        case Symmetry::none:
+        default:
+          return index;
+      }
+    }
+
+    // true once the flag of a generation, if any, asks it to give up.
+    inline bool IsCancelled(const std::atomic<bool> * cancelled)
+    {
+      return cancelled && cancelled->load(std::memory_order_relaxed);
+    }
+
+    // Random engine of the calling thread. Seeded once per thread, so generators
+    // called several times in the same second do not repeat their boards.
+    inline std::mt19937 & RandomEngine()
+    {
+      static thread_local std::mt19937 engine{
+          static_cast<std::mt19937::result_type>(std::random_device{}() ^
+              std::hash<std::thread::id>{}(std::this_thread::get_id()) ^
+              static_cast<std::size_t>(std::chrono::steady_clock::now().time_since_epoch().count()))};
+      return engine;
+    }
+
+    inline unsigned int RandomIndex(unsigned int end)
+    {
+      return std::uniform_int_distribution<unsigned int>(0, end - 1)(RandomEngine());
+    }
+
+    /* IsBoardValid of boards made of rows, columns and boxes only. The unit of a cell
+       is computed and the flags stay on the stack, which keeps the classic boards off
+       the layout tables and the heap.
+    */
+    template<typename SudokuBoard>
+    bool IsBoxBoardValid(const SudokuBoard & board, bool check_vacant)
+    {
+      constexpr unsigned int width = SudokuBoard::width;
+      constexpr unsigned int end_index = width * width;
+      constexpr unsigned int box_height = SudokuBoard::box_height;
+      constexpr unsigned int box_width = SudokuBoard::box_width;
+      typedef typename SudokuBoard::Cell Cell;
+      typedef typename Cell::ValueType ValueType;
+      typedef typename ValueMask<Cell::values_length>::type Mask;
+
+      /* lookup table to determine if the value has already existed
+         For example
+         if bit 3 of rowFlags[1] is set, it means 3 has already existed in row 1
+         if bit 3 of colFlags[7] is set, it means 3 has already existed in col 7
+         if bit 3 of boxFlags[4] is set, it means 3 has already existed in 4th box.
+      */
+      std::array<Mask, width> rowFlags{}, colFlags{}, boxFlags{};
+
+      unsigned int row = 0, col = 0;
+      for(unsigned int index = 0; index < end_index; ++index)
+      {
+        row = index / width;
+        col = index % width;
+        if(check_vacant && (!board[row][col].isValid() || board[row][col].isVacant()))
+          return false;
+
+        // if the cell is vacant, skip
+        if(board[row][col].isValid() && !board[row][col].isVacant())
+        {
+          unsigned int value = static_cast<unsigned int>(static_cast<ValueType>(board[row][col]));
+          unsigned int value_offset = value % Cell::values_length;
+          Mask value_bit = static_cast<Mask>(static_cast<Mask>(1) << value_offset);
+          unsigned int box = (width / box_width) * (row / box_height) + col / box_width;
+          if((rowFlags[row] | colFlags[col] | boxFlags[box]) & value_bit)
+          {
+            return false;
+          }
+          // if the cell has not existed yet, set flags.
+          rowFlags[row] |= value_bit;
+          colFlags[col] |= value_bit;
+          boxFlags[box] |= value_bit;
+        }
+        // if the cell is not valid and not vacant, the board then is not valid.
+        else if(!board[row][col].isValid())
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
     /*
     Check if a board has a valid state. A valid state means there is no violation to
     the rule of sudoku. if check_vacant is true, boards containing
     vacant cells will be regarded as invalid.
+    Boards of rows, columns and boxes are checked by IsBoxBoardValid. For the others
+    the units to check come from the layout of the board. Inactive cells are skipped.
+    Units with a sum (killer cages) must not go beyond it, and must reach it once full.
     */
     template<typename SudokuBoard>
     bool IsBoardValid(const SudokuBoard & board, bool check_vacant = false)
     {
+      if(SudokuBoard::has_box_layout)
+        return IsBoxBoardValid<SudokuBoard>(board, check_vacant);
+
       constexpr unsigned int width = SudokuBoard::width;
       constexpr unsigned int end_index = width * width;
-      typedef typename SudokuBoard::Cell::ValueType ValueType;
+      typedef typename SudokuBoard::Cell Cell;
+      typedef typename Cell::ValueType ValueType;
+      typedef typename ValueMask<Cell::values_length>::type Mask;
 
-      const unsigned int cubic_width = std::sqrt(width);
+      const RegionLayout & layout = board.layout();
       /* lookup table to determine if the value has already existed
          For example
-         if rowFlags[1][3] is true, it means 3 has already existed in row 1
-         if colFlags[3][7] is true, it means 3 has already existed in col 7
-         if cubicFlags[4][3] is true, it means 3 has already existed in 4th grid.
+         if bit 3 of unitFlags[1] is set, it means 3 has already existed in unit 1,
+         which may be a row, a column or a grid.
       */
-      bool rowFlags[width][width] = {{false}};
-      bool colFlags[width][width] = {{false}};
-      bool cubicFlags[width][width] = {{false}};
-
+      std::vector<Mask> unitFlags(layout.numberOfUnits() + 1, 0);
 
       unsigned int row = 0, col = 0;
       for(unsigned int index = 0; index < end_index; ++index)
       {
+        if(!layout.isActive(index))
+          continue;
         row = index / width;
         col = index % width;
         if(check_vacant && (!board[row][col].isValid() || board[row][col].isVacant()))
@@ -84,16 +229,20 @@ namespace wubinboardgames
 
           // value may be larger than width. Imagine we are playing 9x9 sudoku
           // number of which starts from 10...
-          unsigned int value_offset = value % width;
-          if(rowFlags[row][value_offset] || colFlags[value_offset][col] ||
-             cubicFlags[cubic_width*(row/cubic_width) + col/cubic_width][value_offset])
+          unsigned int value_offset = value % Cell::values_length;
+          Mask value_bit = static_cast<Mask>(static_cast<Mask>(1) << value_offset);
+          const uint16_t * units = layout.cellUnits(index);
+          Mask used = 0;
+          for(unsigned int n = 0; n < layout.unitsPerCell(); ++n)
+            used |= unitFlags[units[n]];
+          if(used & value_bit)
           {
             return false;
           }
           // if the cell has not existed yet, set flags.
-          rowFlags[row][value_offset] = true;
-          colFlags[value_offset][col] = true;
-          cubicFlags[cubic_width*(row/cubic_width) + col/cubic_width][value_offset] = true;
+          for(unsigned int n = 0; n < layout.unitsPerCell(); ++n)
+            unitFlags[units[n]] |= value_bit;
+          unitFlags.back() = 0;
         }
         // if the cell is not valid and not vacant, the board then is not valid.
         else if(!board[row][col].isValid())
@@ -101,6 +250,23 @@ namespace wubinboardgames
           return false;
         }
       }
+      for(unsigned int unit = 0; layout.hasSums() && unit < layout.numberOfUnits(); ++unit)
+      {
+        if(!layout.unitSum(unit))
+          continue;
+        unsigned int sum = 0;
+        bool is_full = true;
+        for(unsigned int k = 0; k < layout.unitSize(unit); ++k)
+        {
+          const Cell & cell = board[layout.unitCells(unit)[k] / width][layout.unitCells(unit)[k] % width];
+          if(cell.isVacant())
+            is_full = false;
+          else
+            sum += static_cast<unsigned int>(static_cast<ValueType>(cell) - Cell::minimum_value) + 1;
+        }
+        if(sum > layout.unitSum(unit) || (is_full && sum != layout.unitSum(unit)))
+          return false;
+      }
       return true;
     }
 
@@ -184,7 +350,8 @@ namespace wubinboardgames
 
     /* Check if a cell is suitable to be put on the board.
        if it does not violate the rule(no repeating element for each row, col and grid) of sudoku,
-       it is elegible.
+       it is elegible. Boards without box layout check the peers of the cell in their layout,
+       and the sum of its cage if it is in one.
     */
     template<typename SudokuBoard>
     inline bool IsCellEligible(const SudokuBoard & board, const typename SudokuBoard::Cell & cell)
@@ -193,7 +360,8 @@ namespace wubinboardgames
         return false;
       typedef typename SudokuBoard::Cell::ValueType ValueType;
       constexpr const int width = SudokuBoard::width;
-      const unsigned int & grid_width = std::sqrt(width);
+      constexpr unsigned int box_height = SudokuBoard::box_height;
+      constexpr unsigned int box_width = SudokuBoard::box_width;
 
       if(!IsPositionValid<SudokuBoard>(cell.getPosition()))
         return false;
@@ -202,6 +370,34 @@ namespace wubinboardgames
       CoordinateConvert(cell.getPosition(), row_index, col_index);
 
       const ValueType value = static_cast<ValueType>(cell);
+      if(!SudokuBoard::has_box_layout)
+      {
+        const RegionLayout & layout = board.layout();
+        const unsigned int index = row_index * width + col_index;
+        const uint16_t * peers = layout.peers(index);
+        for(unsigned int n = 0; n < layout.numberOfPeers(index); ++n)
+        {
+          if(board[peers[n] / width][peers[n] % width] == value)
+            return false;
+        }
+        const uint16_t unit = layout.sumUnitOf(index);
+        if(RegionLayout::no_sum == unit)
+          return true;
+        unsigned int sum = static_cast<unsigned int>(value - SudokuBoard::Cell::minimum_value) + 1;
+        bool is_full = true;
+        for(unsigned int k = 0; k < layout.unitSize(unit); ++k)
+        {
+          const unsigned int other = layout.unitCells(unit)[k];
+          if(other == index)
+            continue;
+          if(board[other / width][other % width].isVacant())
+            is_full = false;
+          else
+            sum += static_cast<unsigned int>(static_cast<ValueType>(board[other / width][other % width]) -
+                                             SudokuBoard::Cell::minimum_value) + 1;
+        }
+        return is_full ? (sum == layout.unitSum(unit)) : (sum < layout.unitSum(unit));
+      }
 
       for(unsigned int x = 0; x < width; ++x)
       {
@@ -209,11 +405,14 @@ namespace wubinboardgames
         if(board[row_index][x] == value || board[x][col_index] == value) 
           return false;
       }
-      for(unsigned int row = (row_index/grid_width) * grid_width; row < ((row_index/grid_width + 1) * grid_width); ++row)
+      // box_height and box_width are constant, so both loops are unrolled.
+      const unsigned int box_top = (row_index / box_height) * box_height;
+      const unsigned int box_left = (col_index / box_width) * box_width;
+      for(unsigned int row = 0; row < box_height; ++row)
       {
-        for(unsigned int col = (col_index/grid_width) * grid_width; col < ((col_index/grid_width + 1) * grid_width); ++col)
+        for(unsigned int col = 0; col < box_width; ++col)
         {
-          if(board[row][col] == value)
+          if(board[box_top + row][box_left + col] == value)
             return false;
         }
       }
@@ -222,13 +421,21 @@ namespace wubinboardgames
 
     /*
       Search solutions for a given board. num_of_retries can return the numbers of retries made in the
-      process of solving.
+      process of solving. stats, if given, is filled with the telemetry of the search. Once cancelled is
+      set, the search gives up at its next backtrack and returns no solution. The search stops at
+      max_solutions solutions: 1 is enough to grade a board known to be unique. With max_forwards, it
+      also stops after that many forwards, num_of_retries then being max_forwards: grading needs no
+      more than LEVEL::SAMURAI, the retries of the highest level.
     */
     template<typename SudokuBoard>
-    std::vector<SudokuBoard> SearchSolution(const SudokuBoard & board, unsigned int * num_of_retries = nullptr)
+    std::vector<SudokuBoard> SearchSolution(const SudokuBoard & board, unsigned int * num_of_retries,
+                                            SearchStats * stats, std::false_type /* raster order */,
+                                            const std::atomic<bool> * cancelled = nullptr,
+                                            unsigned int max_solutions = 2, unsigned int max_forwards = 0)
     {
       constexpr const int width = SudokuBoard::width;
       typedef typename SudokuBoard::Cell Cell;
+      StatsRecorder recorder(stats);
 
       std::vector<SudokuBoard> solutions;
       if(!IsBoardValid<SudokuBoard>(board))
@@ -238,6 +445,7 @@ namespace wubinboardgames
       // return the board...
       if(!IsPositionValid<SudokuBoard>(FindVacantPosition<SudokuBoard>(board)))
       {
+        recorder.solution();
         solutions.push_back(board);
         return solutions;
       }
@@ -261,6 +469,7 @@ namespace wubinboardgames
       CoordinateConvert(FindVacantPosition<SudokuBoard>(board), first_vacant_row, first_vacant_col);
       // push the first vacant cell before we get into the loop
       stack_of_vacant_cells.push(board[first_vacant_row][first_vacant_col]);
+      recorder.node(1);
 
       unsigned int top_cell_row = width, top_cell_col = width;
 
@@ -287,6 +496,13 @@ namespace wubinboardgames
           {
             // increment number of retries
             ++num_of_forwards;
+            recorder.forward();
+            if(max_forwards && num_of_forwards >= max_forwards)
+            {
+              if(num_of_retries && 0 == num_of_solutions)
+                *num_of_retries = num_of_forwards;
+              return solutions;
+            }
             // set the cell on the board.
             work_board[top_cell_row][top_cell_col] = cell_on_top;
             // find next fillable cell
@@ -301,11 +517,15 @@ namespace wubinboardgames
             // otherwise push next fillable cell into the stack
             CoordinateConvert(next_vacant_pos, top_cell_row, top_cell_col);
             stack_of_vacant_cells.push(work_board[top_cell_row][top_cell_col]);
+            recorder.node(static_cast<unsigned int>(stack_of_vacant_cells.size()));
           }
           else
           {
+            if(IsCancelled(cancelled))
+              return std::vector<SudokuBoard>{};
             // no eligible value found. pop it.
             stack_of_vacant_cells.pop();
+            recorder.backtrack();
             // reset the top cell on the board to make sure later we can try with
             // it from the minimum value.
             work_board[top_cell_row][top_cell_col].reset();
@@ -317,13 +537,16 @@ namespace wubinboardgames
         {
           // save the solution as there might be more than one.
           solutions.push_back(work_board);
+          // cells are written through operator[] above, so the hash is computed once here.
+          solutions.back().rehash();
+          recorder.solution();
+          // if this is the first solution, take the num_of_retries.
+          if(num_of_retries && 0 == num_of_solutions)
+            *num_of_retries = num_of_forwards;
           // break if this is the second solution. No need to find every solution
           // for an invalid game setup.
-          if(++num_of_solutions == 2)
+          if(++num_of_solutions == max_solutions)
             break;
-          // if this is the first solution, take the num_of_retries.
-          if(num_of_retries)
-            *num_of_retries = num_of_forwards;
           // we want to find another solution, so pop the last fillabe cell in
           // the stack. Now the top one was the second last and will do ++ to
           // find another solution.
@@ -336,6 +559,32 @@ namespace wubinboardgames
       return solutions;
     }
 
+    /* Boards searched on the most constrained cell rather than row by row: wide boards,
+       boards with rectangular boxes, and boards whose units are not only rows, columns
+       and boxes. The levels of the row by row search were tuned on square boxes.
+    */
+    template<typename SudokuBoard>
+    constexpr bool SearchesMostConstrainedCell()
+    {
+      return !SudokuBoard::has_box_layout || SudokuBoard::width > RASTER_SEARCH_MAX_WIDTH ||
+             SudokuBoard::box_height != SudokuBoard::box_width;
+    }
+
+    // Wide and irregular boards: search on the most constrained cell. num_of_retries is
+    // then the number of forwards of that search before its first solution.
+    template<typename SudokuBoard>
+    std::vector<SudokuBoard> SearchSolution(const SudokuBoard & board, unsigned int * num_of_retries,
+                                            SearchStats * stats, std::true_type /* most constrained cell */,
+                                            const std::atomic<bool> * cancelled = nullptr);
+
+    template<typename SudokuBoard>
+    std::vector<SudokuBoard> SearchSolution(const SudokuBoard & board, unsigned int * num_of_retries = nullptr,
+                                            SearchStats * stats = nullptr)
+    {
+      return SearchSolution<SudokuBoard>(board, num_of_retries, stats,
+          std::integral_constant<bool, SearchesMostConstrainedCell<SudokuBoard>()>());
+    }
+
     // GetOneSolution no matter it is unique or not.
     // set isUnique to indicate.
     template<typename SudokuBoard>
@@ -352,6 +601,7 @@ namespace wubinboardgames
     template<typename SudokuBoard>
     bool IsSolutionUnique(const SudokuBoard & board)
     {
+      TRACE_SCOPE("IsSolutionUnique");
       std::vector<SudokuBoard> solutions = SearchSolution<SudokuBoard>(board);
       return (1 == solutions.size());
     }
@@ -363,19 +613,339 @@ namespace wubinboardgames
       return (1 <= solutions.size());
     }
 
-    // level evaluation determined by the number of retries.
+    /* Solutions kept by CountCompletions, and the forwards made before the first one.
+       Once cancelled is set, or the search is out of max_nodes nodes or past deadline,
+       it unwinds without counting anything more.
+    */
     template<typename SudokuBoard>
-    LEVEL LevelEvaluate(const SudokuBoard & board)
+    struct SolutionCollector
     {
-      unsigned int num_of_retries = 0;
-      std::vector<SudokuBoard> solutions = SearchSolution<SudokuBoard>(board, &num_of_retries);
+      std::vector<SudokuBoard> solutions;
+      uint64_t forwards = 0;
+      uint64_t forwards_to_first_solution = 0;
+      const std::atomic<bool> * cancelled = nullptr;
+      uint64_t nodes = 0;
+      // no limit if 0.
+      uint64_t max_nodes = 0;
+      std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+      bool is_out_of_budget = false;
 
-      if(0 == solutions.size())
-        return LEVEL::NO_SOLUTION;
+      // true once the search must unwind. The clock is read every 256 nodes.
+      bool isStopped()
+      {
+        if(!is_out_of_budget && ((max_nodes && nodes >= max_nodes) ||
+           (0 == nodes % 256 && deadline != std::chrono::steady_clock::time_point::max() &&
+            std::chrono::steady_clock::now() >= deadline)))
+          is_out_of_budget = true;
+        return is_out_of_budget || IsCancelled(cancelled);
+      }
+    };
 
-      if(2 == solutions.size())
-        return LEVEL::NO_UNIQUE_SOLUTION;
+    /*
+      Recursive step of CountSolutions. Singles are filled first, then it branches on
+      the vacant cell with fewest candidates: without hidden singles the proof that a
+      wide board has no second solution can take hours. The filled cells are appended
+      to trail, shared by every node, and taken off again before returning.
+      Results of branching states are kept in the transposition table under the key
+      of the remaining sub-problem, so a sub-problem reached again through another
+      partial assignment is answered without searching it.
+    */
+    template<typename SudokuBoard>
+    uint64_t CountCompletions(CandidateGrid<SudokuBoard> & grid, uint64_t limit, TranspositionTable * table,
+                              StatsRecorder & recorder, std::vector<uint16_t> & trail, unsigned int depth = 0,
+                              SolutionCollector<SudokuBoard> * collector = nullptr)
+    {
+      typedef typename CandidateGrid<SudokuBoard>::Mask Mask;
+      if(collector && collector->isStopped())
+        return 0;
+      recorder.node(depth);
+      if(collector)
+        ++collector->nodes;
+
+      const std::size_t trail_start = trail.size();
+      unsigned int rounds = 0;
+      unsigned int index = 0;
+      Mask mask = 0;
+      uint64_t total = 0;
+      if(!grid.propagateSingles(trail, rounds) ||
+         (grid.numberOfVacants() && !grid.mostConstrainedCell(index, mask)))
+      {
+        recorder.backtrack();
+      }
+      else if(0 == grid.numberOfVacants())
+      {
+        recorder.propagation(static_cast<unsigned int>(trail.size() - trail_start));
+        recorder.solution();
+        if(collector)
+        {
+          if(collector->solutions.empty())
+            collector->forwards_to_first_solution = collector->forwards;
+          collector->solutions.push_back(grid.board());
+        }
+        total = 1;
+      }
+      else
+      {
+        recorder.propagation(static_cast<unsigned int>(trail.size() - trail_start));
+        uint64_t key = 0;
+        uint64_t known_count = 0;
+        bool exact = false;
+        if(table)
+          key = grid.subproblemKey();
+        if(table && table->probe(key, known_count, exact) && (exact || known_count >= limit))
+        {
+          total = std::min(known_count, limit);
+        }
+        else
+        {
+          while(mask && total < limit)
+          {
+            unsigned int value_offset = LowestBit(mask);
+            mask &= static_cast<Mask>(mask - 1);
+            grid.assign(index, value_offset);
+            recorder.forward();
+            if(collector)
+              ++collector->forwards;
+            total += CountCompletions<SudokuBoard>(grid, limit - total, table, recorder, trail, depth + 1, collector);
+            grid.unassign(index);
+          }
+          // if the limit stopped the loop, total is only a lower bound. If stopped, it is nothing.
+          if(table && !(collector && collector->isStopped()))
+            table->store(key, total, total < limit);
+        }
+      }
+      while(trail.size() > trail_start)
+      {
+        grid.unassign(trail.back());
+        trail.pop_back();
+      }
+      return total;
+    }
+
+    /*
+      Count the solutions of a board, stopping once limit solutions are found.
+      A transposition table can be shared between calls (and threads) on boards of the
+      same type. It is what makes counting the solutions of boards with few givens
+      feasible, as their sub-problems repeat a lot.
+    */
+    template<typename SudokuBoard>
+    uint64_t CountSolutions(const SudokuBoard & board,
+                            uint64_t limit = TranspositionTable::max_count,
+                            TranspositionTable * table = nullptr,
+                            SearchStats * stats = nullptr)
+    {
+      StatsRecorder recorder(stats);
+      CandidateGrid<SudokuBoard> grid(board);
+      if(!grid.isConsistent() || 0 == limit)
+        return 0;
+      std::vector<uint16_t> trail;
+      trail.reserve(SudokuBoard::width * SudokuBoard::width);
+      return CountCompletions<SudokuBoard>(grid, limit, table, recorder, trail);
+    }
+
+    /*
+      Recursive step of EnumerateSolutions, filling singles and branching on the most
+      constrained cell as CountCompletions, with the same trail. Returns false once the
+      visitor, or cancelled, stops it.
+    */
+    template<typename SudokuBoard, typename Visitor>
+    bool VisitCompletions(CandidateGrid<SudokuBoard> & grid, Visitor & visitor, uint64_t & num_of_solutions,
+                          StatsRecorder & recorder, std::vector<uint16_t> & trail,
+                          const std::atomic<bool> * cancelled, unsigned int depth = 0)
+    {
+      typedef typename CandidateGrid<SudokuBoard>::Mask Mask;
+      if(IsCancelled(cancelled))
+        return false;
+      recorder.node(depth);
+
+      const std::size_t trail_start = trail.size();
+      unsigned int rounds = 0;
+      unsigned int index = 0;
+      Mask mask = 0;
+      bool goes_on = true;
+      if(!grid.propagateSingles(trail, rounds) ||
+         (grid.numberOfVacants() && !grid.mostConstrainedCell(index, mask)))
+      {
+        recorder.backtrack();
+      }
+      else if(0 == grid.numberOfVacants())
+      {
+        recorder.propagation(static_cast<unsigned int>(trail.size() - trail_start));
+        recorder.solution();
+        ++num_of_solutions;
+        goes_on = visitor(grid.board());
+      }
+      else
+      {
+        recorder.propagation(static_cast<unsigned int>(trail.size() - trail_start));
+        while(mask && goes_on)
+        {
+          unsigned int value_offset = LowestBit(mask);
+          mask &= static_cast<Mask>(mask - 1);
+          grid.assign(index, value_offset);
+          recorder.forward();
+          goes_on = VisitCompletions<SudokuBoard>(grid, visitor, num_of_solutions, recorder, trail, cancelled,
+                                                  depth + 1);
+          grid.unassign(index);
+        }
+      }
+      while(trail.size() > trail_start)
+      {
+        grid.unassign(trail.back());
+        trail.pop_back();
+      }
+      return goes_on;
+    }
+
+    /*
+      Enumerate the solutions of a board, calling visitor(solution) for each of them.
+      solution is the working board of the search, a view valid during the call only:
+      the visitor copies it if it keeps it, nothing else does. The visitor returns true
+      to go on, false to stop there, so that counting every solution or sampling some
+      of them takes no memory. Once cancelled is set, the enumeration stops too.
+      Returns the number of solutions visited.
+    */
+    template<typename SudokuBoard, typename Visitor>
+    uint64_t EnumerateSolutions(const SudokuBoard & board, Visitor visitor, SearchStats * stats = nullptr,
+                                const std::atomic<bool> * cancelled = nullptr)
+    {
+      TRACE_SCOPE("EnumerateSolutions");
+      StatsRecorder recorder(stats);
+      uint64_t num_of_solutions = 0;
+      CandidateGrid<SudokuBoard> grid(board);
+      std::vector<uint16_t> trail;
+      trail.reserve(SudokuBoard::width * SudokuBoard::width);
+      if(grid.isConsistent())
+        VisitCompletions<SudokuBoard>(grid, visitor, num_of_solutions, recorder, trail, cancelled);
+      return num_of_solutions;
+    }
+
+    template<typename SudokuBoard>
+    std::vector<SudokuBoard> SearchSolution(const SudokuBoard & board, unsigned int * num_of_retries,
+                                            SearchStats * stats, std::true_type, const std::atomic<bool> * cancelled)
+    {
+      StatsRecorder recorder(stats);
+      SolutionCollector<SudokuBoard> collector;
+      collector.cancelled = cancelled;
+      CandidateGrid<SudokuBoard> grid(board);
+      std::vector<uint16_t> trail;
+      trail.reserve(SudokuBoard::width * SudokuBoard::width);
+      if(grid.isConsistent())
+        CountCompletions<SudokuBoard>(grid, 2, nullptr, recorder, trail, 0, &collector);
+      if(IsCancelled(cancelled))
+        return std::vector<SudokuBoard>{};
+      if(num_of_retries && !collector.solutions.empty())
+        *num_of_retries = static_cast<unsigned int>(collector.forwards_to_first_solution);
+      return collector.solutions;
+    }
+
+    /*
+      Race the row by row search against the search on the most constrained cell, on a
+      thread each, and take the solutions of the first one done. The row by row search
+      is quick on boards with many givens, and may get lost on boards with few; the
+      loser is stopped. Boards always searched on the most constrained cell are simply
+      searched on the calling thread.
+    */
+    template<typename SudokuBoard>
+    std::vector<SudokuBoard> SearchSolutionPortfolio(const SudokuBoard & board)
+    {
+      typedef std::vector<SudokuBoard> Solutions;
+      if(SearchesMostConstrainedCell<SudokuBoard>())
+        return SearchSolution<SudokuBoard>(board);
+      std::shared_ptr<FirstResultRace<Solutions>> race = std::make_shared<FirstResultRace<Solutions>>();
+      std::future<Solutions> solutions = race->takeFuture();
+      RunRace(race, 2, [board](unsigned int runner, FirstResultRace<Solutions> & solution_race)
+      {
+        const std::atomic<bool> * is_stopped = &solution_race.stopFlag();
+        Solutions runner_solutions = (0 == runner) ?
+            SearchSolution<SudokuBoard>(board, nullptr, nullptr, std::false_type(), is_stopped) :
+            SearchSolution<SudokuBoard>(board, nullptr, nullptr, std::true_type(), is_stopped);
+        if(!IsCancelled(is_stopped))
+          solution_race.offer(std::move(runner_solutions));
+      });
+      return solutions.get();
+    }
+
+    /* SolveWithinBudget tells what its search found of the solutions of a board:
+       solved: a solution, but the budget ran out before it was known to be unique.
+       budget_exceeded: the budget ran out before any solution was found.
+    */
+    enum class SolveStatus
+    {
+      solved,
+      unique,
+      multiple,
+      no_solution,
+      budget_exceeded
+    };
+
+    // limits of SolveWithinBudget: nodes of its search, and the time it must be done by.
+    struct SolveBudget
+    {
+      // no limit if 0.
+      uint64_t max_nodes = 0;
+      std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+      // a budget of timeout from now, and max_nodes nodes.
+      template<typename Duration>
+      static SolveBudget within(Duration timeout, uint64_t max_nodes = 0)
+      {
+        SolveBudget budget;
+        budget.max_nodes = max_nodes;
+        budget.deadline = std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+        return budget;
+      }
+    };
+
+    template<typename SudokuBoard>
+    struct SolveResult
+    {
+      SolveStatus status = SolveStatus::no_solution;
+      // up to two, the first ones found.
+      std::vector<SudokuBoard> solutions;
+      SearchStats stats;
+    };
+
+    /*
+      Search the solutions of board on the most constrained cell, as CountSolutions
+      does, within budget: whatever the board, a search out of nodes or time unwinds
+      at once, and so does a cancelled one (see SolveStatus). Boards whose search could
+      tie up a thread, like a nearly empty ExtendedSudokuBoard with a contradiction deep
+      down, come back budget_exceeded instead.
+    */
+    template<typename SudokuBoard>
+    SolveResult<SudokuBoard> SolveWithinBudget(const SudokuBoard & board, const SolveBudget & budget,
+                                               const std::atomic<bool> * cancelled = nullptr)
+    {
+      TRACE_SCOPE("SolveWithinBudget");
+      SolveResult<SudokuBoard> result;
+      SolutionCollector<SudokuBoard> collector;
+      collector.cancelled = cancelled;
+      collector.max_nodes = budget.max_nodes;
+      collector.deadline = budget.deadline;
+      {
+        StatsRecorder recorder(&result.stats);
+        CandidateGrid<SudokuBoard> grid(board);
+        if(!grid.isConsistent())
+          return result;
+        std::vector<uint16_t> trail;
+        trail.reserve(SudokuBoard::width * SudokuBoard::width);
+        CountCompletions<SudokuBoard>(grid, 2, nullptr, recorder, trail, 0, &collector);
+      }
+      result.solutions = std::move(collector.solutions);
+      if(2 == result.solutions.size())
+        result.status = SolveStatus::multiple;
+      else if(collector.is_out_of_budget || IsCancelled(cancelled))
+        result.status = result.solutions.empty() ? SolveStatus::budget_exceeded : SolveStatus::solved;
+      else
+        result.status = result.solutions.empty() ? SolveStatus::no_solution : SolveStatus::unique;
+      return result;
+    }
 
+    // the level of a board whose unique solution took num_of_retries forwards.
+    inline LEVEL LevelOfRetries(unsigned int num_of_retries)
+    {
       if(num_of_retries < LEVEL::EASY)
         return LEVEL::EASY;
 
@@ -391,161 +961,924 @@ namespace wubinboardgames
       return LEVEL::EXTREME;
     }
 
-    /* Algorithm to generate a final board, that is board complying to rule
-       of sudoku and has no vacant cell.
-       The algorithm first sets up a table for each cell. The table maps the index
-       of the cell with a list of values that can be set to the cell. 
-       For sudoku, the default list of values are from 1 to 9.
-       Then each time, we randomly pick up a value from the list for each cell, and try
-       it to see if the board is still valid. If it is not, remove it from the list.
-       If the list becomes empty,
-       1. go back to its previous cell and delete its current value
-       2. set the current cell with default list to make sure it is ready for next turn
-       of trials.
-       Back and forth until we find a valid final table.
+    /* Forwards the row by row search needs to tell whether a board is of level: once
+       there, LevelOfRetries puts it above level. LEVEL::SAMURAI forwards tell the
+       highest level, so digging to EASY stops each search after LEVEL::EASY forwards.
     */
-    template<typename SudokuBoard>
-    SudokuBoard GenerateFinalBoard()
+    inline unsigned int ForwardsToTellLevel(LEVEL level)
     {
-      std::srand(std::time(nullptr));
-
-      SudokuBoard work_board;
-      typedef typename SudokuBoard::Cell Cell;
-      typedef typename Cell::ValueType ValueType;
-      constexpr unsigned int board_width = SudokuBoard::width;
-      constexpr unsigned int end_index = board_width * board_width;
-      constexpr unsigned int value_width = Cell::values_length;
-      constexpr ValueType minimum = Cell::minimum_value;
+      return std::min(static_cast<unsigned int>(level), static_cast<unsigned int>(LEVEL::SAMURAI));
+    }
 
-      std::vector<std::list<ValueType>> cells_candidate_values;
-      std::list<ValueType> cell_default_values;
+    /*
+      DifficultyGrade is the result of GradeDifficulty. score is continuous, level is
+      the LEVEL bucket of the score. The other members are the metrics behind it.
+    */
+    struct DifficultyGrade
+    {
+      double score = 0.0;
+      LEVEL level = LEVEL::NO_SOLUTION;
+      // rounds of singles needed before the first guess, and the cells they filled.
+      unsigned int propagation_depth = 0;
+      unsigned int solved_by_singles = 0;
+      // search nodes needed to find the solution and prove it is unique.
+      unsigned int nodes = 0;
+      // nodes where a guess was needed, and the mean number of candidates there.
+      unsigned int guesses = 0;
+      double branching_factor = 0.0;
+      // false if the node budget ran out. The grade is then EXTREME.
+      bool within_budget = true;
+    };
 
-      for(unsigned int i = 0; i < value_width; ++i)
-      {
-        cell_default_values.push_back(minimum + i);
-      }
-      for(unsigned int i = 0; i < board_width * board_width; ++i)
+    /*
+      Recursive step of GradeDifficulty. The cells filled by singles are appended to trail,
+      which is shared by every node, and taken off again before returning, so the search
+      does not allocate once trail has grown to the deepest path.
+    */
+    template<typename SudokuBoard>
+    uint64_t GradeCompletions(CandidateGrid<SudokuBoard> & grid, uint64_t limit,
+                              DifficultyGrade & grade, unsigned int node_budget,
+                              std::vector<uint16_t> & trail)
+    {
+      typedef typename CandidateGrid<SudokuBoard>::Mask Mask;
+      if(++grade.nodes > node_budget)
       {
-        // set for each cell
-        cells_candidate_values.push_back(cell_default_values);
+        grade.within_budget = false;
+        return 0;
       }
-      unsigned int pos = 0;
-      while(!IsBoardSolved<SudokuBoard>(work_board) && pos < end_index)
+      const std::size_t trail_start = trail.size();
+      unsigned int rounds = 0;
+      uint64_t total = 0;
+      if(grid.propagateSingles(trail, rounds))
       {
-        ValueType value;
-        unsigned int steps_forward = 0;
-        while(0 < cells_candidate_values[pos].size())
+        unsigned int index = 0;
+        Mask mask = 0;
+        if(0 == grid.numberOfVacants())
         {
-          // pick up a random value from the cell's candidate list
-          steps_forward = std::rand() % cells_candidate_values[pos].size();
-          auto itr_list = cells_candidate_values[pos].begin();
-          std::advance (itr_list,steps_forward);
-          value  = *itr_list;
-          work_board[pos/board_width][pos%board_width] = value;
-
-          // Bingo! we find a suitable value for the cell.
-          if(IsBoardValid(work_board))
-              break;
-          // otherwise, remove the value and try another random value from the list.
-          auto it = std::find(cells_candidate_values[pos].begin(), cells_candidate_values[pos].end(), value);
-          cells_candidate_values[pos].erase(it);
-          work_board[pos/board_width][pos%board_width].reset();
-        }
-        // no suitable value found for this cell, set it default and go back
-        // to its previous cell.
-        if(0 == cells_candidate_values[pos].size())
-        {
-          work_board[pos/board_width][pos%board_width].reset();
-          cells_candidate_values[pos] = cell_default_values;
-          auto value_of_last_cell = static_cast<ValueType>(work_board[(pos-1) / board_width][(pos-1) % board_width]);
-          auto it = std::find(cells_candidate_values[pos-1].begin(), cells_candidate_values[pos-1].end(), value_of_last_cell);
-          cells_candidate_values[pos - 1].erase(it);
-          --pos;
-        }
-        // if the value is suitable, proceed to next cell.
-        else
+          total = 1;
+        }
+        else if(grid.mostConstrainedCell(index, mask))
         {
-          ++pos;
+          ++grade.guesses;
+          grade.branching_factor += PopCount(mask);
+          while(mask && total < limit && grade.within_budget)
+          {
+            unsigned int value_offset = LowestBit(mask);
+            mask &= static_cast<Mask>(mask - 1);
+            grid.assign(index, value_offset);
+            total += GradeCompletions<SudokuBoard>(grid, limit - total, grade, node_budget, trail);
+            grid.unassign(index);
+          }
         }
       }
-      return work_board;
+      while(trail.size() > trail_start)
+      {
+        grid.unassign(trail.back());
+        trail.pop_back();
+      }
+      return total;
     }
 
     /*
-      GenerateSolvableBoard returns a solvable board with given difficulty level.
-      You can aslo determine the minimum number of vacant cells the board must have.
-      Befault, it is width*width / 2.5. For sudoku, it is 32.
-      The algorithm will first get a final table and then try to set some cells vacant
-      to generate a solvable game.
-      If setting a cell vacant makes the board have no solution or more than one solution, it
-      recover the cell back and tries to set another cell vacant.
-      After certain amount of tries, if the solvable board still cannot be generated complying to
-      the given level. The algorithm will require a new final board and retry.
+      GradeDifficulty grades a board in a bounded amount of work. Unlike LevelEvaluate
+      it does not depend on the raster order of a search:
+      1. singles are propagated, recording how many rounds it takes,
+      2. the rest is searched on the most constrained cell with singles at each node,
+         until the solution is found and proven unique.
+      The score combines the share of vacant cells, the propagation depth, the share
+      of cells singles cannot fill and the search nodes. After node_budget nodes the
+      search gives up and the board is graded EXTREME.
     */
     template<typename SudokuBoard>
-    SudokuBoard GenerateSolvableBoard(const LEVEL & level = LEVEL::MEDIUM,
-                                      const unsigned int & minimum_empties = SudokuBoard::width * SudokuBoard::width / 2.5)
+    DifficultyGrade GradeDifficulty(const SudokuBoard & board, unsigned int node_budget = 20000)
     {
-      typedef typename SudokuBoard::Cell Cell;
-      typedef typename Cell::ValueType ValueType;
-      constexpr unsigned int width = SudokuBoard::width;
-      constexpr unsigned int end_index = width * width;
+      DifficultyGrade grade;
+      CandidateGrid<SudokuBoard> grid(board);
+      if(!grid.isConsistent())
+        return grade;
 
-      std::srand(std::time(nullptr));
-      if(level < LEVEL::EASY)
+      unsigned int vacants = grid.numberOfVacants();
+      std::vector<uint16_t> trail;
+      // a cell is filled at most once on a path, so trail never grows past this.
+      trail.reserve(SudokuBoard::width * SudokuBoard::width);
+      if(!grid.propagateSingles(trail, grade.propagation_depth))
+        return grade;
+      grade.solved_by_singles = static_cast<unsigned int>(trail.size());
+
+      uint64_t num_of_solutions = (0 == grid.numberOfVacants()) ? 1 :
+          GradeCompletions<SudokuBoard>(grid, 2, grade, node_budget, trail);
+      if(grade.guesses)
+        grade.branching_factor /= grade.guesses;
+
+      if(!grade.within_budget)
       {
-        return SudokuBoard{};
+        grade.score = std::log10(static_cast<double>(LEVEL::EXTREME));
+        grade.level = LEVEL::EXTREME;
+        return grade;
       }
-      SudokuBoard work_board;
-
-      unsigned int num_of_empties = 0;
-      unsigned int num_of_retries = 0;
-      unsigned int index = 0;
-      work_board = GenerateFinalBoard<SudokuBoard>();
-      // I realize it is a good opportunity to testing the IsSolutionUnique function here.
-      // As GenerateFinalBoard does not rely on SearchSolution, we can solve the solvable board by
-      // SearchSolution and compare it with the final board initially returned by GenerateFinalBoard.
-      // If for all time they match, we can assume that IsSolutionUnique works fine.
-#ifdef _testing
-      SudokuBoard testing_board;
-      testing_board = work_board;
-      unsigned int num_of_testing = 100;
-      while(--num_of_testing){
-#endif
-      while(true)
+      if(0 == num_of_solutions)
+        return grade;
+      if(2 == num_of_solutions)
       {
-        // randomly pick up a number, if it is already vacant, skip
-        index = std::rand() % end_index;
-        if(work_board[index/width][index%width].isVacant())
-          continue;
+        grade.level = LEVEL::NO_UNIQUE_SOLUTION;
+        return grade;
+      }
 
-        // keep its value and set it to vacant.
-        ValueType value = static_cast<ValueType>(work_board[index/width][index%width]);
-        work_board[index/width][index%width].reset();
+      /* The score estimates log10 of the retries LevelEvaluate would count, so it is
+         bucketed with the same LEVEL thresholds. The weights come from a least squares
+         fit over 1500 randomly dug 9x9 boards. The metrics are normalized by the size
+         of the board.
+      */
+      const double active_cells = board.layout().numberOfActiveCells();
+      double empty_share = vacants / active_cells;
+      double unsolved_share = vacants ? 1.0 - static_cast<double>(grade.solved_by_singles) / vacants : 0.0;
+      grade.score = std::max(0.0, 6.35 * empty_share +
+                                  0.88 * grade.propagation_depth / SudokuBoard::width +
+                                  0.045 * std::log2(1.0 + grade.nodes) +
+                                  1.07 * unsolved_share - 1.45);
+      grade.level = LevelOfRetries(static_cast<unsigned int>(std::min(std::pow(10.0, grade.score), 4e9)));
+      return grade;
+    }
+
+    /* Level of a board known to have a unique solution, found by SearchSolution after
+       num_of_retries forwards. Forwards of the search on the most constrained cell
+       say little about how hard a board is, so those boards are graded by
+       GradeDifficulty instead.
+    */
+    template<typename SudokuBoard>
+    LEVEL LevelOfUniqueBoard(const SudokuBoard & board, unsigned int num_of_retries)
+    {
+      if(SearchesMostConstrainedCell<SudokuBoard>())
+        return GradeDifficulty<SudokuBoard>(board).level;
+      return LevelOfRetries(num_of_retries);
+    }
+
+    /* DifficultyScore of a board known to have a unique solution: log10 of the forwards
+       of the row by row search to its solution, or the score of GradeDifficulty for the
+       boards it grades. Either way, LEVEL thresholds bucket it, in log10. level, if
+       given, is set to the level of the board, as LevelOfUniqueBoard tells it. Once
+       cancelled is set, the score is meaningless.
+    */
+    template<typename SudokuBoard>
+    double DifficultyScore(const SudokuBoard & board, SearchStats * stats = nullptr, LEVEL * level = nullptr,
+                           const std::atomic<bool> * cancelled = nullptr)
+    {
+      if(SearchesMostConstrainedCell<SudokuBoard>())
+      {
+        const DifficultyGrade grade = GradeDifficulty<SudokuBoard>(board);
+        if(level)
+          *level = grade.level;
+        return grade.score;
+      }
+      unsigned int num_of_retries = 0;
+      SearchSolution<SudokuBoard>(board, &num_of_retries, stats, std::false_type(), cancelled, 1, LEVEL::SAMURAI);
+      if(level)
+        *level = LevelOfRetries(num_of_retries);
+      return std::log10(std::max(1u, num_of_retries));
+    }
+
+    // how far score is above the bucket of level, in log10: 0 in it, negative below it.
+    inline double LevelDistance(double score, const LEVEL & level)
+    {
+      static const LEVEL levels[] = {LEVEL::EASY, LEVEL::MEDIUM, LEVEL::HARD, LEVEL::SAMURAI, LEVEL::EXTREME};
+      const unsigned int num_of_levels = sizeof(levels) / sizeof(levels[0]);
+      for(unsigned int n = 0; n < num_of_levels; ++n)
+      {
+        if(level != levels[n])
+          continue;
+        if(n > 0 && score < std::log10(static_cast<double>(levels[n - 1])))
+          return score - std::log10(static_cast<double>(levels[n - 1]));
+        if(n + 1 < num_of_levels && score >= std::log10(static_cast<double>(levels[n])))
+          return score - std::log10(static_cast<double>(levels[n])) + 1e-9;
+        return 0.0;
+      }
+      return 0.0;
+    }
+
+    // level evaluation determined by the number of retries.
+    template<typename SudokuBoard>
+    LEVEL LevelEvaluate(const SudokuBoard & board)
+    {
+      TRACE_SCOPE("LevelEvaluate");
+      unsigned int num_of_retries = 0;
+      std::vector<SudokuBoard> solutions = SearchSolution<SudokuBoard>(board, &num_of_retries);
+
+      if(0 == solutions.size())
+        return LEVEL::NO_SOLUTION;
+
+      if(2 == solutions.size())
+        return LEVEL::NO_UNIQUE_SOLUTION;
 
-        if(IsSolutionUnique<SudokuBoard>(work_board))
+      return LevelOfUniqueBoard<SudokuBoard>(board, num_of_retries);
+    }
+
+
+    /*
+      Recursive step of GenerateFinalBoard. Fills the most constrained vacant cell with
+      its candidates in random order. Gives up once node_budget nodes are spent, so a
+      fill stuck deep in a dead branch can restart from scratch, or once cancelled is
+      set, as a fill of a wide board can take seconds.
+    */
+    template<typename SudokuBoard>
+    bool FillRandomly(CandidateGrid<SudokuBoard> & grid, unsigned int & node_budget,
+                      StatsRecorder & recorder, const std::atomic<bool> * cancelled = nullptr,
+                      unsigned int depth = 0)
+    {
+      typedef typename CandidateGrid<SudokuBoard>::Mask Mask;
+      recorder.node(depth);
+      if(0 == node_budget || IsCancelled(cancelled))
+        return false;
+      --node_budget;
+
+      // singles follow from the values already put, only the other cells are random.
+      std::vector<uint16_t> trail;
+      unsigned int rounds = 0;
+      bool is_filled = false;
+      if(grid.propagateSingles(trail, rounds))
+      {
+        recorder.propagation(static_cast<unsigned int>(trail.size()));
+        unsigned int index = 0;
+        Mask mask = 0;
+        if(0 == grid.numberOfVacants())
+          return true;
+        if(grid.mostConstrainedCell(index, mask))
         {
-          ++num_of_empties;
-          num_of_retries = 0;
+          uint8_t value_offsets[64];
+          unsigned int num_of_values = 0;
+          for(; mask; mask &= static_cast<Mask>(mask - 1))
+            value_offsets[num_of_values++] = static_cast<uint8_t>(LowestBit(mask));
+          std::shuffle(value_offsets, value_offsets + num_of_values, RandomEngine());
+          for(unsigned int n = 0; n < num_of_values && !is_filled; ++n)
+          {
+            grid.assign(index, value_offsets[n]);
+            recorder.forward();
+            is_filled = FillRandomly<SudokuBoard>(grid, node_budget, recorder, cancelled, depth + 1);
+            if(!is_filled)
+              grid.unassign(index);
+          }
+        }
+      }
+      if(is_filled)
+        return true;
+      for(auto itr = trail.rbegin(); itr != trail.rend(); ++itr)
+        grid.unassign(*itr);
+      recorder.backtrack();
+      return false;
+    }
+
+    /* Algorithm to generate a final board, that is board complying to rule
+       of sudoku and has no vacant cell.
+       The cells are filled one by one, always the vacant cell with the fewest values
+       left, with a value picked at random among them. Cells left with a single value,
+       or values left with a single cell in a row, column or box, are filled right away.
+       If a cell has no value left, the search goes back to the previous random cell and
+       tries its next value.
+       Picking the most constrained cell keeps the back and forth short even on 25x25
+       and 36x36 boards. If the fill still takes too long, it starts over.
+       Once cancelled is set, the fill gives up and it returns an empty board.
+       progress, if given, counts the final boards and the fills started over.
+    */
+    template<typename SudokuBoard>
+    SudokuBoard GenerateFinalBoard(SearchStats * stats = nullptr, const std::atomic<bool> * cancelled = nullptr,
+                                   GenerationProgress * progress = nullptr)
+    {
+      TRACE_SCOPE("GenerateFinalBoard");
+      StatsRecorder recorder(stats);
+      constexpr unsigned int end_index = SudokuBoard::width * SudokuBoard::width;
+
+      while(!IsCancelled(cancelled))
+      {
+        CandidateGrid<SudokuBoard> grid{SudokuBoard{}};
+        unsigned int node_budget = 20 * end_index;
+        if(FillRandomly<SudokuBoard>(grid, node_budget, recorder, cancelled))
+        {
+          SudokuBoard final_board{grid.board()};
+          final_board.rehash();
+          if(progress)
+          {
+            GenerationProgress::add(progress->final_boards);
+            progress->clues.store(end_index, std::memory_order_relaxed);
+          }
+          return final_board;
+        }
+        TRACE_INSTANT("FinalBoardRestart", 0);
+        if(progress)
+          GenerationProgress::add(progress->fill_restarts);
+      }
+      return SudokuBoard{};
+    }
+
+    // the cell set vacant along with the given cell at index: its image, if it is given too.
+    template<typename SudokuBoard>
+    unsigned int PartnerIndex(const SudokuBoard & work_board, unsigned int index, Symmetry symmetry)
+    {
+      constexpr unsigned int width = SudokuBoard::width;
+      const unsigned int partner = SymmetricIndex(index, width, symmetry);
+      return work_board[partner/width][partner%width].isVacant() ? index : partner;
+    }
+
+    // the UnavoidableSets of work_board if it is a final board, that is all its num_of_filled cells are given.
+    template<typename SudokuBoard>
+    std::unique_ptr<UnavoidableSets<SudokuBoard>> UnavoidableSetsOfFinalBoard(const SudokuBoard & work_board,
+                                                                            unsigned int num_of_filled)
+    {
+      if(num_of_filled != work_board.layout().numberOfActiveCells())
+        return std::unique_ptr<UnavoidableSets<SudokuBoard>>();
+      return std::unique_ptr<UnavoidableSets<SudokuBoard>>(new UnavoidableSets<SudokuBoard>(work_board));
+    }
+
+    /*
+      Set cells of work_board vacant, one random cell at a time, until it has more than
+      minimum_empties vacant cells and the given level.
+      If setting a cell vacant makes the board have no solution or more than one solution, it
+      recover the cell back and tries to set another cell vacant. A cell so recovered is
+      not tried again: with fewer given cells, the board could only get more solutions.
+      Returns false once every given cell left was tried, the board being minimal then.
+      work_board should be given up for a new final board.
+      Also returns false, between two cells, once cancelled is set.
+      progress, if given, follows the cells set vacant and the nodes of the searches.
+      Dug from a final board, removals emptying one of its UnavoidableSets fail without
+      a search. Uniqueness is told by the search on the most constrained cell, which
+      gives up on boards with two solutions much sooner than the row by row search: the
+      latter only grades the unique boards past minimum_empties. With a symmetry, a cell
+      is set vacant along with its image.
+    */
+    template<typename SudokuBoard>
+    bool DigToLevel(SudokuBoard & work_board, const LEVEL & level, const unsigned int & minimum_empties,
+                    SearchStats * stats = nullptr, const std::atomic<bool> * cancelled = nullptr,
+                    GenerationProgress * progress = nullptr, Symmetry symmetry = Symmetry::none)
+    {
+      typedef typename SudokuBoard::Cell Cell;
+      typedef typename Cell::ValueType ValueType;
+      constexpr unsigned int width = SudokuBoard::width;
+      constexpr unsigned int end_index = width * width;
+
+      // the given cells, one per orbit of the symmetry, in random order.
+      std::vector<unsigned int> filled;
+      // cages can keep a board unique down to no given cell at all.
+      unsigned int num_of_filled = 0;
+      for(unsigned int index = 0; index < end_index; ++index)
+      {
+        if(work_board[index/width][index%width].isVacant())
+          continue;
+        ++num_of_filled;
+        if(PartnerIndex(work_board, index, symmetry) >= index)
+          filled.push_back(index);
+      }
+      std::shuffle(filled.begin(), filled.end(), RandomEngine());
+      std::unique_ptr<UnavoidableSets<SudokuBoard>> sets = UnavoidableSetsOfFinalBoard(work_board, num_of_filled);
+      // the searches count their nodes for progress, into stats or a SearchStats of their own.
+      SearchStats progress_stats;
+      SearchStats * search_stats = (stats || !progress) ? stats : &progress_stats;
+      unsigned int num_of_empties = 0;
+      for(unsigned int index : filled)
+      {
+        if(IsCancelled(cancelled))
+          break;
+        // keep its value and set it to vacant, and its image.
+        const unsigned int partner = PartnerIndex(work_board, index, symmetry);
+        const unsigned int orbit_size = (partner == index) ? 1 : 2;
+        ValueType value = static_cast<ValueType>(work_board[index/width][index%width]);
+        ValueType partner_value = static_cast<ValueType>(work_board[partner/width][partner%width]);
+        work_board.vacate(index/width, index%width);
+        work_board.vacate(partner/width, partner%width);
+
+        unsigned int num_of_forwards = 0;
+        std::vector<SudokuBoard> solutions;
+        if(!sets || sets->canRemove(index, partner))
+        {
+          TRACE_SCOPE("UniquenessAndLevel");
+          const uint64_t nodes_before = search_stats ? search_stats->nodes : 0;
+          // a search cancelled finds no solution: the cells are given back.
+          solutions = SearchSolution<SudokuBoard>(work_board, &num_of_forwards, search_stats, std::true_type(),
+                                                  cancelled);
+          if(1 == solutions.size() && num_of_empties + orbit_size > minimum_empties &&
+             !SearchesMostConstrainedCell<SudokuBoard>())
+            SearchSolution<SudokuBoard>(work_board, &num_of_forwards, search_stats, std::false_type(), cancelled, 1,
+                                        ForwardsToTellLevel(level));
+          if(progress)
+            GenerationProgress::add(progress->search_nodes, search_stats->nodes - nodes_before);
+        }
+        if(progress)
+          GenerationProgress::add((1 == solutions.size()) ? progress->removals : progress->rejected_removals);
+        if(1 == solutions.size())
+        {
+          num_of_empties += orbit_size;
+          if(sets)
+          {
+            sets->remove(index);
+            if(partner != index)
+              sets->remove(partner);
+          }
+          if(progress)
+            progress->clues.store(num_of_filled - num_of_empties, std::memory_order_relaxed);
           //Bingo! We find the solvable board with given level.
-          if(level == LevelEvaluate<SudokuBoard>(work_board) && num_of_empties > minimum_empties)
-            break;
+          if(num_of_empties > minimum_empties && !IsCancelled(cancelled) &&
+             level == LevelOfUniqueBoard<SudokuBoard>(work_board, num_of_forwards))
+            return true;
         }
         else
         {
-          ++num_of_retries;
-          work_board[index/width][index%width] = value;
+          work_board.assign(partner/width, partner%width, partner_value);
+          work_board.assign(index/width, index%width, value);
+          // the solutions differ from the final board on vacant cells, and the cells put back.
+          for(unsigned int n = 0; sets && n < solutions.size(); ++n)
+            sets->learn(solutions[n], work_board);
+        }
+      }
+      TRACE_INSTANT("Restart", num_of_empties);
+      return false;
+    }
+
+    /*
+      RemovalTrials is the team of DigToLevelInParallel: num_of_trials threads, the
+      calling one included. Each round, every thread sets one cell of its own copy of
+      the board vacant, and searches it. The helper threads wait for the next round in
+      between, and live as long as the team.
+    */
+    template<typename SudokuBoard>
+    class RemovalTrials
+    {
+    public:
+      struct Trial
+      {
+        // index of the cell set vacant, and partner of the one set vacant with it, if any.
+        unsigned int index = 0;
+        unsigned int partner = 0;
+        std::size_t num_of_solutions = 0;
+        // up to two, the first ones found.
+        std::vector<SudokuBoard> solutions;
+        unsigned int num_of_forwards = 0;
+        // graded only if unique, and asked for.
+        LEVEL level = LEVEL::EASY;
+        SearchStats stats;
+      };
+
+      explicit RemovalTrials(unsigned int num_of_trials);
+      ~RemovalTrials();
+      RemovalTrials(const RemovalTrials &) = delete;
+      RemovalTrials & operator=(const RemovalTrials &) = delete;
+
+      unsigned int size() const;
+      // the trial of each thread. Set the indices of a round before run().
+      Trial & operator[](unsigned int trial);
+      /* run the first round_size trials on board, in parallel. Returns once all are done.
+         Once cancelled is set, the searches give up and the trials find no solution.
+         Graded trials tell levels up to level, and put the boards above it just above.
+      */
+      void run(const SudokuBoard & board, unsigned int round_size, bool grades,
+               const std::atomic<bool> * cancelled = nullptr, LEVEL level = LEVEL::EXTREME);
+
+    private:
+      void tryRemoval(unsigned int trial);
+      void runHelper(unsigned int trial);
+
+      std::vector<Trial> trials;
+      std::vector<std::thread> helpers;
+      std::mutex round_mutex;
+      std::condition_variable round_started;
+      std::condition_variable round_done;
+      // the round being run, guarded by round_mutex.
+      const SudokuBoard * round_board = nullptr;
+      unsigned int round_size = 0;
+      bool round_grades = false;
+      LEVEL round_level = LEVEL::EXTREME;
+      const std::atomic<bool> * round_cancelled = nullptr;
+      uint64_t round = 0;
+      unsigned int num_of_running_helpers = 0;
+      bool is_stopping = false;
+    };
+
+    template<typename SudokuBoard>
+    RemovalTrials<SudokuBoard>::RemovalTrials(unsigned int num_of_trials)
+      : trials(std::max(num_of_trials, 1u))
+    {
+      for(unsigned int trial = 1; trial < trials.size(); ++trial)
+        helpers.emplace_back(&RemovalTrials::runHelper, this, trial);
+    }
+
+    template<typename SudokuBoard>
+    RemovalTrials<SudokuBoard>::~RemovalTrials()
+    {
+      {
+        std::lock_guard<std::mutex> lock(round_mutex);
+        is_stopping = true;
+      }
+      round_started.notify_all();
+      for(std::thread & helper : helpers)
+        helper.join();
+    }
+
+    template<typename SudokuBoard>
+    inline unsigned int RemovalTrials<SudokuBoard>::size() const
+    {
+      return static_cast<unsigned int>(trials.size());
+    }
+
+    template<typename SudokuBoard>
+    inline typename RemovalTrials<SudokuBoard>::Trial & RemovalTrials<SudokuBoard>::operator[](unsigned int trial)
+    {
+      return trials[trial];
+    }
+
+    template<typename SudokuBoard>
+    void RemovalTrials<SudokuBoard>::run(const SudokuBoard & board, unsigned int size_of_round, bool grades,
+                                         const std::atomic<bool> * cancelled, LEVEL level)
+    {
+      {
+        std::lock_guard<std::mutex> lock(round_mutex);
+        round_board = &board;
+        round_size = std::min(size_of_round, size());
+        round_grades = grades;
+        round_level = level;
+        round_cancelled = cancelled;
+        num_of_running_helpers = (round_size > 1) ? round_size - 1 : 0;
+        ++round;
+      }
+      round_started.notify_all();
+      if(round_size)
+        tryRemoval(0);
+      std::unique_lock<std::mutex> lock(round_mutex);
+      round_done.wait(lock, [this] { return 0 == num_of_running_helpers; });
+    }
+
+    template<typename SudokuBoard>
+    void RemovalTrials<SudokuBoard>::tryRemoval(unsigned int trial_index)
+    {
+      constexpr unsigned int width = SudokuBoard::width;
+      Trial & trial = trials[trial_index];
+      SudokuBoard board{*round_board};
+      board.vacate(trial.index/width, trial.index%width);
+      board.vacate(trial.partner/width, trial.partner%width);
+      trial.stats.clear();
+      trial.num_of_forwards = 0;
+      // as in DigToLevel, the row by row search only grades unique boards.
+      trial.solutions = SearchSolution<SudokuBoard>(board, &trial.num_of_forwards, &trial.stats, std::true_type(),
+                                                    round_cancelled);
+      trial.num_of_solutions = trial.solutions.size();
+      if(round_grades && 1 == trial.num_of_solutions)
+      {
+        if(!SearchesMostConstrainedCell<SudokuBoard>())
+          SearchSolution<SudokuBoard>(board, &trial.num_of_forwards, &trial.stats, std::false_type(), round_cancelled, 1,
+                                      ForwardsToTellLevel(round_level));
+        trial.level = LevelOfUniqueBoard<SudokuBoard>(board, trial.num_of_forwards);
+      }
+    }
+
+    template<typename SudokuBoard>
+    void RemovalTrials<SudokuBoard>::runHelper(unsigned int trial)
+    {
+      uint64_t last_round = 0;
+      while(true)
+      {
+        {
+          std::unique_lock<std::mutex> lock(round_mutex);
+          round_started.wait(lock, [this, last_round] { return is_stopping || round != last_round; });
+          if(is_stopping)
+            return;
+          last_round = round;
+          if(trial >= round_size)
+            continue;
+        }
+        tryRemoval(trial);
+        std::lock_guard<std::mutex> lock(round_mutex);
+        if(0 == --num_of_running_helpers)
+          round_done.notify_one();
+      }
+    }
+
+    /*
+      DigToLevel, trying trials.size() cells (or orbits of symmetry) at a time on as
+      many threads rather than one. Near a minimal board most removals fail, and the
+      failures are then found in parallel. Of the removals keeping the solution unique,
+      the first one giving the level is kept, or else the first one; the others are
+      tried again later as the board changes.
+    */
+    template<typename SudokuBoard>
+    bool DigToLevelInParallel(SudokuBoard & work_board, const LEVEL & level, const unsigned int & minimum_empties,
+                              RemovalTrials<SudokuBoard> & trials, SearchStats * stats = nullptr,
+                              const std::atomic<bool> * cancelled = nullptr, GenerationProgress * progress = nullptr,
+                              Symmetry symmetry = Symmetry::none)
+    {
+      typedef typename RemovalTrials<SudokuBoard>::Trial Trial;
+      constexpr unsigned int width = SudokuBoard::width;
+      constexpr unsigned int end_index = width * width;
+
+      // the given cells, one per orbit of the symmetry.
+      std::vector<unsigned int> filled;
+      unsigned int num_of_filled = 0;
+      for(unsigned int index = 0; index < end_index; ++index)
+      {
+        if(work_board[index/width][index%width].isVacant())
+          continue;
+        ++num_of_filled;
+        if(PartnerIndex(work_board, index, symmetry) >= index)
+          filled.push_back(index);
+      }
+      std::unique_ptr<UnavoidableSets<SudokuBoard>> sets = UnavoidableSetsOfFinalBoard(work_board, num_of_filled);
+      unsigned int num_of_empties = 0;
+      while(!filled.empty() && !IsCancelled(cancelled))
+      {
+        // distinct random orbits drawn from the back of filled. Orbits the unavoidable
+        // sets keep given fail as they are drawn. Like in DigToLevel, an orbit that
+        // failed is not tried again.
+        unsigned int round_size = 0;
+        while(!filled.empty() && round_size < trials.size())
+        {
+          std::swap(filled.back(), filled[RandomIndex(static_cast<unsigned int>(filled.size()))]);
+          const unsigned int index = filled.back();
+          filled.pop_back();
+          const unsigned int partner = PartnerIndex(work_board, index, symmetry);
+          if(sets && !sets->canRemove(index, partner))
+          {
+            if(progress)
+              GenerationProgress::add(progress->rejected_removals);
+            continue;
+          }
+          trials[round_size].index = index;
+          trials[round_size].partner = partner;
+          ++round_size;
+        }
+        if(0 == round_size)
+          break;
+        {
+          TRACE_SCOPE("ParallelUniquenessAndLevel");
+          trials.run(work_board, round_size, num_of_empties + 2 > minimum_empties, cancelled, level);
+        }
+        // a cancelled search finds no solution, and a cancelled grading says nothing.
+        if(IsCancelled(cancelled))
+          break;
+
+        unsigned int kept = round_size;
+        bool is_kept_at_level = false;
+        std::vector<unsigned int> unique_trials;
+        for(unsigned int trial = 0; trial < round_size; ++trial)
+        {
+          const Trial & result = trials[trial];
+          if(stats)
+            stats->addCounters(result.stats);
+          if(progress)
+            GenerationProgress::add(progress->search_nodes, result.stats.nodes);
+          if(1 != result.num_of_solutions)
+          {
+            if(progress)
+              GenerationProgress::add(progress->rejected_removals);
+            for(unsigned int n = 0; sets && n < result.solutions.size(); ++n)
+              sets->learn(result.solutions[n], work_board);
+            continue;
+          }
+          unique_trials.push_back(trial);
+          const unsigned int orbit_size = (result.partner == result.index) ? 1 : 2;
+          const bool is_at_level = num_of_empties + orbit_size > minimum_empties && level == result.level;
+          if(kept == round_size || (is_at_level && !is_kept_at_level))
+          {
+            kept = trial;
+            is_kept_at_level = is_at_level;
+          }
+        }
+        if(kept < round_size)
+        {
+          for(unsigned int index : {trials[kept].index, trials[kept].partner})
+          {
+            if(work_board[index/width][index%width].isVacant())
+              continue;
+            work_board.vacate(index/width, index%width);
+            if(sets)
+              sets->remove(index);
+            ++num_of_empties;
+          }
+          if(progress)
+          {
+            GenerationProgress::add(progress->removals);
+            progress->clues.store(num_of_filled - num_of_empties, std::memory_order_relaxed);
+          }
+          //Bingo! We find the solvable board with given level.
+          if(is_kept_at_level)
+            return true;
+        }
+        for(unsigned int trial : unique_trials)
+        {
+          if(trial != kept)
+            filled.push_back(trials[trial].index);
+        }
+      }
+      TRACE_INSTANT("Restart", num_of_empties);
+      return false;
+    }
+
+    /*
+      Climb from work_board, a unique board dug from final_board that fell off the given
+      level, back to it. Each step gives a random vacant cell of final_board back, then
+      sets given cells vacant while the solution stays unique: two if the board is too
+      easy, one if it has minimum_empties vacant cells or fewer, none otherwise. The
+      step is scored by DifficultyScore and kept if it gets the board closer to the
+      level, or farther by d with probability exp(-d / temperature), the temperature
+      cooling from LEVEL_CLIMB_TEMPERATURE to 0 over num_of_steps steps.
+      Returns true once work_board has the level and more than minimum_empties vacant
+      cells. With a symmetry, cells go along with their images, as in DigToLevel.
+    */
+    template<typename SudokuBoard>
+    bool ClimbToLevel(SudokuBoard & work_board, const SudokuBoard & final_board, const LEVEL & level,
+                      const unsigned int & minimum_empties, unsigned int num_of_steps,
+                      SearchStats * stats = nullptr, const std::atomic<bool> * cancelled = nullptr,
+                      GenerationProgress * progress = nullptr, Symmetry symmetry = Symmetry::none)
+    {
+      typedef typename SudokuBoard::Cell::ValueType ValueType;
+      constexpr unsigned int width = SudokuBoard::width;
+      constexpr unsigned int end_index = width * width;
+      if(IsCancelled(cancelled))
+        return false;
+      SearchStats progress_stats;
+      SearchStats * search_stats = (stats || !progress) ? stats : &progress_stats;
+      auto image_of = [&final_board, symmetry](unsigned int index)
+      {
+        const unsigned int image = SymmetricIndex(index, width, symmetry);
+        return final_board[image/width][image%width].isVacant() ? index : image;
+      };
+
+      UnavoidableSets<SudokuBoard> sets(final_board);
+      const unsigned int num_of_filled = final_board.layout().numberOfActiveCells();
+      unsigned int num_of_empties = 0;
+      for(unsigned int index = 0; index < end_index; ++index)
+      {
+        if(!final_board[index/width][index%width].isVacant() && work_board[index/width][index%width].isVacant())
+        {
+          ++num_of_empties;
+          sets.remove(index);
+        }
+      }
+      double distance = LevelDistance(DifficultyScore<SudokuBoard>(work_board, search_stats, nullptr, cancelled),
+                                      level);
+      if(IsCancelled(cancelled))
+        return false;
+      std::vector<unsigned int> givens, vacants, given_back, set_vacant;
+      std::uniform_real_distribution<double> uniform(0.0, 1.0);
+      for(unsigned int step = 0; step < num_of_steps && !IsCancelled(cancelled); ++step)
+      {
+        if(0.0 == distance && num_of_empties > minimum_empties)
+          break;
+        // the cells of one orbit each.
+        givens.clear();
+        vacants.clear();
+        for(unsigned int index = 0; index < end_index; ++index)
+        {
+          if(final_board[index/width][index%width].isVacant() || image_of(index) < index)
+            continue;
+          (work_board[index/width][index%width].isVacant() ? vacants : givens).push_back(index);
+        }
+        if(vacants.empty())
+          break;
+
+        const uint64_t nodes_before = search_stats ? search_stats->nodes : 0;
+        SudokuBoard next_board{work_board};
+        unsigned int next_num_of_empties = num_of_empties;
+        given_back.clear();
+        set_vacant.clear();
+        const unsigned int back = vacants[RandomIndex(static_cast<unsigned int>(vacants.size()))];
+        for(unsigned int index : {back, image_of(back)})
+        {
+          if(!next_board[index/width][index%width].isVacant())
+            continue;
+          next_board.assign(index/width, index%width, static_cast<ValueType>(final_board[index/width][index%width]));
+          sets.restore(index);
+          given_back.push_back(index);
+          --next_num_of_empties;
         }
-        // try certain amount of times. For soduko, it tries 121.
-        // if no solvable board found, ask for a new final board.
-        if(num_of_retries > (end_index * 1.5))
+        unsigned int num_of_removals = (distance < 0.0) ? 2 : (next_num_of_empties <= minimum_empties);
+        std::shuffle(givens.begin(), givens.end(), RandomEngine());
+        for(unsigned int n = 0; n < givens.size() && num_of_removals > 0; ++n)
         {
-          work_board = GenerateFinalBoard<SudokuBoard>();
-          num_of_empties = num_of_retries = 0;
+          const unsigned int index = givens[n];
+          const unsigned int partner = image_of(index);
+          if(!sets.canRemove(index, partner))
+            continue;
+          next_board.vacate(index/width, index%width);
+          next_board.vacate(partner/width, partner%width);
+          std::vector<SudokuBoard> solutions = SearchSolution<SudokuBoard>(next_board, nullptr, search_stats,
+                                                                           std::true_type(), cancelled);
+          if(progress)
+            GenerationProgress::add((1 == solutions.size()) ? progress->removals : progress->rejected_removals);
+          if(1 != solutions.size())
+          {
+            next_board.assign(index/width, index%width, static_cast<ValueType>(final_board[index/width][index%width]));
+            next_board.assign(partner/width, partner%width, static_cast<ValueType>(final_board[partner/width][partner%width]));
+            for(const SudokuBoard & solution : solutions)
+              sets.learn(solution, next_board);
+            continue;
+          }
+          sets.remove(index);
+          set_vacant.push_back(index);
+          if(partner != index)
+          {
+            sets.remove(partner);
+            set_vacant.push_back(partner);
+          }
+          next_num_of_empties += (partner == index) ? 1 : 2;
+          --num_of_removals;
+        }
+
+        const double next_distance =
+            LevelDistance(DifficultyScore<SudokuBoard>(next_board, search_stats, nullptr, cancelled), level);
+        if(IsCancelled(cancelled))
+          break;
+        const double temperature = LEVEL_CLIMB_TEMPERATURE * (num_of_steps - step) / num_of_steps;
+        if(std::fabs(next_distance) <= std::fabs(distance) ||
+           uniform(RandomEngine()) < std::exp((std::fabs(distance) - std::fabs(next_distance)) / temperature))
+        {
+          work_board = next_board;
+          num_of_empties = next_num_of_empties;
+          distance = next_distance;
+          if(progress)
+            progress->clues.store(num_of_filled - num_of_empties, std::memory_order_relaxed);
+        }
+        else
+        {
+          for(unsigned int index : given_back)
+            sets.remove(index);
+          for(unsigned int index : set_vacant)
+            sets.restore(index);
+        }
+        if(progress)
+          GenerationProgress::add(progress->search_nodes, search_stats->nodes - nodes_before);
+      }
+      TRACE_INSTANT("Climb", num_of_empties);
+      return 0.0 == distance && num_of_empties > minimum_empties;
+    }
+
+    /* Boards whose puzzles carry more than their given cells, like the cages of killer
+       sudoku, overload PrepareToDig to set them up on the final board before its cells
+       are set vacant. Other boards need nothing.
+    */
+    template<typename SudokuBoard>
+    inline void PrepareToDig(SudokuBoard & /* final_board */)
+    {
+    }
+
+    /*
+      GenerateSolvableBoard returns a solvable board with given difficulty level.
+      You can aslo determine the minimum number of vacant cells the board must have.
+      Befault, it is width*width / 2.5. For sudoku, it is 32.
+      The algorithm will first get a final table, prepare it (see PrepareToDig) and then
+      try to set some cells vacant to generate a solvable game (see DigToLevel).
+      If the dug board misses the given level, it is steered toward it (see ClimbToLevel)
+      before the algorithm requires a new final board and retries.
+      stats, if given, adds up the telemetry of every search made while generating.
+      Setting cancelled, from any thread, stops the generation within a search or so:
+      it then returns an empty board. progress, if given, is kept up to date for other
+      threads to follow (see GenerationProgress).
+      With num_of_trials above 1, cells are set vacant num_of_trials at a time, on as
+      many threads (see DigToLevelInParallel). With a symmetry, the given cells of the
+      board make a symmetric pattern.
+    */
+    template<typename SudokuBoard>
+    SudokuBoard GenerateSolvableBoard(const LEVEL & level = LEVEL::MEDIUM,
+                                      const unsigned int & minimum_empties = SudokuBoard::width * SudokuBoard::width / 2.5,
+                                      SearchStats * stats = nullptr, const std::atomic<bool> * cancelled = nullptr,
+                                      GenerationProgress * progress = nullptr, unsigned int num_of_trials = 1,
+                                      Symmetry symmetry = Symmetry::none)
+    {
+      TRACE_SCOPE("GenerateSolvableBoard");
+
+      if(level < LEVEL::EASY)
+      {
+        return SudokuBoard{};
+      }
+      SudokuBoard work_board;
+
+      work_board = GenerateFinalBoard<SudokuBoard>(stats, cancelled, progress);
+      if(IsCancelled(cancelled))
+        return SudokuBoard{};
+      PrepareToDig(work_board);
+      SudokuBoard final_board{work_board};
+      // I realize it is a good opportunity to testing the IsSolutionUnique function here.
+      // As GenerateFinalBoard does not rely on SearchSolution, we can solve the solvable board by
+      // SearchSolution and compare it with the final board initially returned by GenerateFinalBoard.
+      // If for all time they match, we can assume that IsSolutionUnique works fine.
+#ifdef _testing
+      SudokuBoard testing_board;
+      testing_board = work_board;
+      unsigned int num_of_testing = 100;
+      while(--num_of_testing){
+#endif
+      std::unique_ptr<RemovalTrials<SudokuBoard>> trials;
+      if(num_of_trials > 1)
+        trials.reset(new RemovalTrials<SudokuBoard>(num_of_trials));
+      // if no solvable board found, even climbing from the dug board, ask for a new final board.
+      while(!(trials ? DigToLevelInParallel<SudokuBoard>(work_board, level, minimum_empties, *trials, stats,
+                                                          cancelled, progress, symmetry) :
+                       DigToLevel<SudokuBoard>(work_board, level, minimum_empties, stats, cancelled, progress,
+                                               symmetry)) &&
+            !ClimbToLevel<SudokuBoard>(work_board, final_board, level, minimum_empties, LEVEL_CLIMB_STEPS, stats,
+                                       cancelled, progress, symmetry))
+      {
+        work_board = GenerateFinalBoard<SudokuBoard>(stats, cancelled, progress);
+        if(IsCancelled(cancelled))
+          return SudokuBoard{};
+        PrepareToDig(work_board);
+        final_board = work_board;
 #ifdef _testing
-          testing_board = work_board;
+        testing_board = work_board;
 #endif
-        }
       }
 #ifdef _testing
       std::cout << "Testing: " << num_of_testing << " th"<< std::endl;
@@ -556,6 +1889,337 @@ namespace wubinboardgames
       return work_board;
   }
 
+    /*
+      GenerateBoardFromMask returns a board of given level whose given cells are exactly
+      the active cells of clue_mask, indexed as the cells of the board. The cells of
+      every final board out of the mask are set vacant at once: a mask missing all the
+      cells of one of its UnavoidableSets is turned down without a search, and a new
+      final board is tried. As there may be no such board at all, it only returns, with
+      an empty board, once cancelled is set, or if the mask is not width * width long.
+      stats and progress are as in GenerateSolvableBoard.
+    */
+    template<typename SudokuBoard>
+    SudokuBoard GenerateBoardFromMask(const std::vector<bool> & clue_mask, const LEVEL & level = LEVEL::MEDIUM,
+                                      SearchStats * stats = nullptr, const std::atomic<bool> * cancelled = nullptr,
+                                      GenerationProgress * progress = nullptr)
+    {
+      TRACE_SCOPE("GenerateBoardFromMask");
+      constexpr unsigned int width = SudokuBoard::width;
+      constexpr unsigned int end_index = width * width;
+      if(clue_mask.size() != end_index || level < LEVEL::EASY)
+        return SudokuBoard{};
+      SearchStats progress_stats;
+      SearchStats * search_stats = (stats || !progress) ? stats : &progress_stats;
+      while(!IsCancelled(cancelled))
+      {
+        SudokuBoard work_board = GenerateFinalBoard<SudokuBoard>(stats, cancelled, progress);
+        if(IsCancelled(cancelled))
+          break;
+        PrepareToDig(work_board);
+        UnavoidableSets<SudokuBoard> sets(work_board);
+        bool is_covered = true;
+        unsigned int num_of_clues = 0;
+        for(unsigned int index = 0; index < end_index && is_covered; ++index)
+        {
+          if(work_board[index/width][index%width].isVacant())
+            continue;
+          if(clue_mask[index])
+          {
+            ++num_of_clues;
+            continue;
+          }
+          is_covered = sets.canRemove(index);
+          if(is_covered)
+            sets.remove(index);
+          work_board.vacate(index/width, index%width);
+        }
+        if(!is_covered)
+        {
+          if(progress)
+            GenerationProgress::add(progress->rejected_removals);
+          continue;
+        }
+        unsigned int num_of_forwards = 0;
+        std::vector<SudokuBoard> solutions;
+        {
+          TRACE_SCOPE("UniquenessAndLevel");
+          const uint64_t nodes_before = search_stats ? search_stats->nodes : 0;
+          solutions = SearchSolution<SudokuBoard>(work_board, &num_of_forwards, search_stats);
+          if(progress)
+            GenerationProgress::add(progress->search_nodes, search_stats->nodes - nodes_before);
+        }
+        const bool is_unique = (1 == solutions.size());
+        if(progress)
+          GenerationProgress::add(is_unique ? progress->removals : progress->rejected_removals);
+        if(is_unique && level == LevelOfUniqueBoard<SudokuBoard>(work_board, num_of_forwards))
+        {
+          if(progress)
+            progress->clues.store(num_of_clues, std::memory_order_relaxed);
+          return work_board;
+        }
+      }
+      return SudokuBoard{};
+    }
+
+    // the mask of the given cells of board, for GenerateBoardFromMask.
+    template<typename SudokuBoard>
+    std::vector<bool> ClueMaskOf(const SudokuBoard & board)
+    {
+      constexpr unsigned int width = SudokuBoard::width;
+      std::vector<bool> clue_mask(width * width);
+      for(unsigned int index = 0; index < width * width; ++index)
+        clue_mask[index] = !board[index/width][index%width].isVacant();
+      return clue_mask;
+    }
+
+    /*
+      Set the given cells of work_board vacant, each tried once in random order, as long
+      as its solution stays unique. The board is then minimal: a cell that could not be
+      set vacant cannot be on a board with fewer given cells either. A cell left with a
+      single candidate by the others is set vacant without a search, a cell emptying an
+      unavoidable set of a final board is kept without one. The others are checked by
+      CountSolutions, sharing table.
+      Returns false as soon as the board cannot get down to max_clues given cells any
+      more, or once cancelled is set.
+    */
+    template<typename SudokuBoard>
+    bool DigToMinimal(SudokuBoard & work_board, unsigned int max_clues, TranspositionTable * table = nullptr,
+                      SearchStats * stats = nullptr, const std::atomic<bool> * cancelled = nullptr,
+                      GenerationProgress * progress = nullptr)
+    {
+      typedef typename SudokuBoard::Cell Cell;
+      typedef typename Cell::ValueType ValueType;
+      constexpr unsigned int width = SudokuBoard::width;
+      constexpr unsigned int end_index = width * width;
+
+      std::vector<unsigned int> givens;
+      for(unsigned int index = 0; index < end_index; ++index)
+      {
+        if(!work_board[index/width][index%width].isVacant())
+          givens.push_back(index);
+      }
+      std::shuffle(givens.begin(), givens.end(), RandomEngine());
+      std::unique_ptr<UnavoidableSets<SudokuBoard>> sets =
+          UnavoidableSetsOfFinalBoard(work_board, static_cast<unsigned int>(givens.size()));
+      SearchStats progress_stats;
+      SearchStats * search_stats = (stats || !progress) ? stats : &progress_stats;
+      unsigned int num_of_clues = static_cast<unsigned int>(givens.size());
+      for(unsigned int tried = 0; tried < givens.size(); ++tried)
+      {
+        // even if every cell left to try is set vacant.
+        if(num_of_clues - (static_cast<unsigned int>(givens.size()) - tried) > max_clues || IsCancelled(cancelled))
+          return false;
+        const unsigned int index = givens[tried];
+        if(sets && !sets->canRemove(index))
+        {
+          if(progress)
+            GenerationProgress::add(progress->rejected_removals);
+          continue;
+        }
+        ValueType value = static_cast<ValueType>(work_board[index/width][index%width]);
+        work_board.vacate(index/width, index%width);
+        bool is_unique = (1 == PopCount(CandidateGrid<SudokuBoard>(work_board).candidates(index)));
+        if(!is_unique)
+        {
+          TRACE_SCOPE("MinimalUniqueness");
+          const uint64_t nodes_before = search_stats ? search_stats->nodes : 0;
+          is_unique = (1 == CountSolutions<SudokuBoard>(work_board, 2, table, search_stats));
+          if(progress)
+            GenerationProgress::add(progress->search_nodes, search_stats->nodes - nodes_before);
+        }
+        if(progress)
+          GenerationProgress::add(is_unique ? progress->removals : progress->rejected_removals);
+        if(is_unique)
+        {
+          --num_of_clues;
+          if(sets)
+            sets->remove(index);
+          if(progress)
+            progress->clues.store(num_of_clues, std::memory_order_relaxed);
+        }
+        else
+          work_board.assign(index/width, index%width, value);
+      }
+      return num_of_clues <= max_clues;
+    }
+
+    template<typename SudokuBoard>
+    unsigned int NumberOfGivens(const SudokuBoard & board)
+    {
+      constexpr unsigned int width = SudokuBoard::width;
+      unsigned int num_of_givens = 0;
+      for(unsigned int index = 0; index < width * width; ++index)
+        num_of_givens += !board[index/width][index%width].isVacant();
+      return num_of_givens;
+    }
+
+    /*
+      Walk from the minimal board work_board to other minimal boards of final_board, its
+      solution, with no more given cells: each step sets two given cells vacant, gives
+      cells of final_board back until the solution is unique again, and digs the result
+      to a minimal board. Steps giving more given cells are undone. Stops after
+      num_of_steps steps, or once work_board has max_clues given cells at most, which
+      is then the result.
+    */
+    template<typename SudokuBoard>
+    bool WalkToFewerClues(SudokuBoard & work_board, const SudokuBoard & final_board, unsigned int max_clues,
+                          unsigned int num_of_steps, TranspositionTable * table = nullptr,
+                          SearchStats * stats = nullptr, const std::atomic<bool> * cancelled = nullptr,
+                          GenerationProgress * progress = nullptr)
+    {
+      typedef typename SudokuBoard::Cell::ValueType ValueType;
+      constexpr unsigned int width = SudokuBoard::width;
+      constexpr unsigned int end_index = width * width;
+      unsigned int num_of_clues = NumberOfGivens(work_board);
+      std::vector<unsigned int> givens, vacants;
+      for(unsigned int step = 0; step < num_of_steps && num_of_clues > max_clues && !IsCancelled(cancelled); ++step)
+      {
+        givens.clear();
+        vacants.clear();
+        for(unsigned int index = 0; index < end_index; ++index)
+        {
+          if(!work_board[index/width][index%width].isVacant())
+            givens.push_back(index);
+          else if(!final_board[index/width][index%width].isVacant())
+            vacants.push_back(index);
+        }
+        if(givens.size() < 2 || vacants.empty())
+          return false;
+        SudokuBoard next_board{work_board};
+        for(unsigned int n = 0; n < 2; ++n)
+        {
+          std::swap(givens[n], givens[n + RandomIndex(static_cast<unsigned int>(givens.size()) - n)]);
+          next_board.vacate(givens[n]/width, givens[n]%width);
+        }
+        std::shuffle(vacants.begin(), vacants.end(), RandomEngine());
+        for(unsigned int index : vacants)
+        {
+          next_board.assign(index/width, index%width, static_cast<ValueType>(final_board[index/width][index%width]));
+          if(1 == CountSolutions<SudokuBoard>(next_board, 2, table, stats))
+            break;
+        }
+        DigToMinimal<SudokuBoard>(next_board, num_of_clues, table, stats, cancelled, progress);
+        const unsigned int next_num_of_clues = NumberOfGivens(next_board);
+        if(next_num_of_clues <= num_of_clues && !IsCancelled(cancelled))
+        {
+          work_board = next_board;
+          num_of_clues = next_num_of_clues;
+        }
+      }
+      if(progress)
+        progress->clues.store(num_of_clues, std::memory_order_relaxed);
+      return num_of_clues <= max_clues;
+    }
+
+    /*
+      GenerateMinimalBoard returns a minimal puzzle (see DigToMinimal) with min_clues to
+      max_clues given cells. Minimal 9x9 puzzles mostly have 22 to 26 of them: boards
+      dug a few given cells above the range walk to fewer (see WalkToFewerClues) before
+      a new final board is dug. It only returns, with an empty board, once cancelled
+      is set: a range no board can fall in needs it.
+      stats and progress are as in GenerateSolvableBoard.
+    */
+    template<typename SudokuBoard>
+    SudokuBoard GenerateMinimalBoard(unsigned int min_clues, unsigned int max_clues, SearchStats * stats = nullptr,
+                                     const std::atomic<bool> * cancelled = nullptr,
+                                     GenerationProgress * progress = nullptr)
+    {
+      TRACE_SCOPE("GenerateMinimalBoard");
+      // sub-problems repeat from a board to the next one dug from the same final board.
+      TranspositionTable table(1 << 16);
+      while(!IsCancelled(cancelled))
+      {
+        SudokuBoard final_board = GenerateFinalBoard<SudokuBoard>(stats, cancelled, progress);
+        if(IsCancelled(cancelled))
+          break;
+        // the walk gives back cells of the solution, which jigsaw boards draw again here.
+        PrepareToDig(final_board);
+        // the keys of the table leave the units out, and killer cages or jigsaw regions
+        // are drawn again for each final board.
+        if(!SudokuBoard::has_box_layout)
+          table.clear();
+        SudokuBoard work_board{final_board};
+        if(!DigToMinimal<SudokuBoard>(work_board, max_clues + MINIMAL_WALK_MAX_EXCESS, &table, stats, cancelled,
+                                      progress) ||
+           !WalkToFewerClues<SudokuBoard>(work_board, final_board, max_clues, MINIMAL_WALK_STEPS, &table, stats,
+                                          cancelled, progress))
+          continue;
+        if(NumberOfGivens(work_board) >= min_clues)
+          return work_board;
+      }
+      return SudokuBoard{};
+    }
+
+    // a board with its level, and the DifficultyScore behind it.
+    template<typename SudokuBoard>
+    struct GradedBoard
+    {
+      SudokuBoard board;
+      LEVEL level = LEVEL::NO_SOLUTION;
+      double score = 0.0;
+    };
+
+    /*
+      GenerateBoardWithin is GenerateSolvableBoard with a wall clock budget: once timeout
+      is over, or cancelled is set, it returns the board closest to level (see
+      LevelDistance) among the boards it dug and climbed so far, those with more than
+      minimum_empties vacant cells first. It returns as soon as one has the level.
+      The board being dug at timeout is dropped, unless it is the first one: it is then
+      graded, by a row by row search of LEVEL::SAMURAI forwards at most, which is all
+      the time it may take over timeout. The level of the board returned is NO_SOLUTION
+      if no final board was even filled in time.
+    */
+    template<typename SudokuBoard, typename Duration>
+    GradedBoard<SudokuBoard> GenerateBoardWithin(const LEVEL & level, Duration timeout,
+                                                 const unsigned int & minimum_empties =
+                                                     SudokuBoard::width * SudokuBoard::width / 2.5,
+                                                 SearchStats * stats = nullptr,
+                                                 const std::atomic<bool> * cancelled = nullptr,
+                                                 GenerationProgress * progress = nullptr,
+                                                 Symmetry symmetry = Symmetry::none)
+    {
+      TRACE_SCOPE("GenerateBoardWithin");
+      const DeadlineFlag deadline(std::chrono::steady_clock::now() +
+                                  std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout),
+                                  cancelled);
+      const std::atomic<bool> * is_over = deadline.flag();
+      GradedBoard<SudokuBoard> best;
+      bool has_best_enough_empties = false;
+      double best_distance = 0.0;
+      while(level >= LEVEL::EASY && !IsCancelled(is_over))
+      {
+        SudokuBoard work_board = GenerateFinalBoard<SudokuBoard>(stats, is_over, progress);
+        if(IsCancelled(is_over))
+          break;
+        PrepareToDig(work_board);
+        const SudokuBoard final_board{work_board};
+        const bool is_at_level =
+            DigToLevel<SudokuBoard>(work_board, level, minimum_empties, stats, is_over, progress, symmetry) ||
+            ClimbToLevel<SudokuBoard>(work_board, final_board, level, minimum_empties, LEVEL_CLIMB_STEPS, stats,
+                                      is_over, progress, symmetry);
+
+        // a board cut short by timeout is only worth grading if there is no other.
+        if(IsCancelled(is_over) && LEVEL::NO_SOLUTION != best.level)
+          break;
+        GradedBoard<SudokuBoard> graded;
+        graded.board = work_board;
+        graded.score = DifficultyScore<SudokuBoard>(work_board, stats, &graded.level);
+        const double distance = std::fabs(LevelDistance(graded.score, level));
+        const bool has_enough_empties =
+            work_board.layout().numberOfActiveCells() - NumberOfGivens(work_board) > minimum_empties;
+        if(LEVEL::NO_SOLUTION == best.level || (has_enough_empties && !has_best_enough_empties) ||
+           (has_enough_empties == has_best_enough_empties && distance < best_distance))
+        {
+          best = graded;
+          best_distance = distance;
+          has_best_enough_empties = has_enough_empties;
+        }
+        if(is_at_level)
+          break;
+      }
+      return best;
+    }
+
   /* 
     Made to play with IsSolutionUnique
   */
@@ -565,13 +2229,13 @@ namespace wubinboardgames
       constexpr unsigned int width = SudokuBoard::width;
       constexpr unsigned int end_index = width * width;
 
-      std::srand(std::time(nullptr));
-      unsigned int num_of_empty_cells = std::rand() % end_index;
+      unsigned int num_of_empty_cells = RandomIndex(end_index);
       SudokuBoard work_board = GenerateFinalBoard<SudokuBoard>();
+      PrepareToDig(work_board);
       while(--num_of_empty_cells)
       {
-        unsigned int index = std::rand() % end_index;
-        work_board[index/width][index%width].reset();
+        unsigned int index = RandomIndex(end_index);
+        work_board.vacate(index/width, index%width);
       }
       return work_board;
   }
@@ -4,18 +4,21 @@
 #include <string>
 #include <iostream>
 #include <thread>
-#include <mutex>
 #include <chrono>
+#include <atomic>
+#include <future>
+#include <limits>
 #include <memory> // std::shared_ptr for multi-threading
+#include <poll.h>
+#include <unistd.h>
 
 #include "SudokuEngine.h"
+#include "Generic/FirstResultRace.h"
 
 /* 
   SudokuGame is a set of template functions to implement UI of Sudoku Game. 
 */
 
-static std::mutex writting_board_mutex; //global mutex for multiple threads
-
 namespace wubinboardgames
 {
   namespace sudoku
@@ -31,8 +34,10 @@ namespace wubinboardgames
       std::cin.clear();
       std::cin >> path;
       std::cout << std::endl <<std::endl;
-      if(board.loadFromFile(path))
+      std::string error;
+      if(LoadBoardFile(path, board, &error))
         return true;
+      std::cout << error << std::endl << std::endl;
       return false;
     }
 
@@ -50,106 +55,325 @@ namespace wubinboardgames
     }
 
     /*
-      The RoutineToGenerateBoard is run by four threads. Each thread tries to find
-      a solvable board with a given level. Each thread has a shared_ptr refering to the
-      board to be returned. board is guarded by the mutex lock.
-      The first thread completing the job will change the is_work_done and set the board.
-      Other threads will discard the result and simply exit.
+      GenerationState is shared by the threads of a BoardGeneration. They are detached,
+      so it lives as long as the last of them. The threads race for the board: the
+      first one generated wins it, then ready_pipe gets a byte so that the board can be
+      polled for along with the keyboard. The stop flag of the race tells the other
+      threads to give up. progress adds up the work of all of them.
+    */
+    template<typename GameBoard>
+    struct GenerationState
+    {
+      GenerationState();
+      ~GenerationState();
+      GenerationState(const GenerationState &) = delete;
+      GenerationState & operator=(const GenerationState &) = delete;
+
+      FirstResultRace<GameBoard> race;
+      GenerationProgress progress;
+      // -1 if no pipe could be made: the board is then only waited for through its future.
+      int ready_pipe[2];
+    };
+
+    template<typename GameBoard>
+    GenerationState<GameBoard>::GenerationState()
+    {
+      if(pipe(ready_pipe) < 0)
+        ready_pipe[0] = ready_pipe[1] = -1;
+    }
+
+    template<typename GameBoard>
+    GenerationState<GameBoard>::~GenerationState()
+    {
+      if(ready_pipe[0] >= 0)
+      {
+        close(ready_pipe[0]);
+        close(ready_pipe[1]);
+      }
+    }
+
+    /*
+      The RoutineToGenerateBoard is run by each thread of the race. Each thread tries to find
+      a solvable board with a given level, num_of_trials cells at a time (see
+      DigToLevelInParallel), and offers it to the race. The thread
+      winning it signals the pipe; the stop flag of the race has already cancelled
+      the other threads, which discard their result and simply exit.
     */
     template<typename GameBoard>
-    void RoutineToGenerateBoard(std::shared_ptr<GameBoard> shared_board, std::shared_ptr<bool> is_work_done, LEVEL level)
+    void RoutineToGenerateBoard(GenerationState<GameBoard> & state, LEVEL level, unsigned int num_of_trials)
     {
-      GameBoard work_board{GenerateSolvableBoard<GameBoard>(level)};
-      std::lock_guard<std::mutex> mutex_lock{writting_board_mutex};
-      if(*is_work_done == false)
+      TRACE_SCOPE("RoutineToGenerateBoard");
+      const unsigned int minimum_empties = GameBoard::width * GameBoard::width / 2.5;
+      const std::atomic<bool> & is_stopped = state.race.stopFlag();
+      GameBoard work_board{GenerateSolvableBoard<GameBoard>(level, minimum_empties, nullptr, &is_stopped,
+                                                                       &state.progress, num_of_trials)};
+      if(!IsCancelled(&is_stopped) && state.race.offer(work_board) && state.ready_pipe[1] >= 0)
       {
-        *shared_board = work_board;
-        *is_work_done = true;
+        const char ready = 1;
+        ssize_t written = write(state.ready_pipe[1], &ready, 1);
+        (void)written;
       }
     }
 
+    /*
+      BoardGeneration generates a board of a given level in the background, racing
+      num_of_threads generations. Each of them sets num_of_trials cells vacant at a
+      time, on threads of its own. The caller goes on meanwhile, and takes the board
+      through get() once it is ready. Destroying the generation, or cancel(), stops the threads still
+      at work.
+    */
+    template<typename GameBoard>
+    class BoardGeneration
+    {
+    public:
+      explicit BoardGeneration(LEVEL level, unsigned int num_of_threads = 4, unsigned int num_of_trials = 1);
+      ~BoardGeneration();
+      BoardGeneration(const BoardGeneration &) = delete;
+      BoardGeneration & operator=(const BoardGeneration &) = delete;
+
+      LEVEL level() const;
+      // true once the board is ready, or the generation cancelled.
+      bool isReady() const;
+      // true as soon as isReady(), false after timeout.
+      template<typename Rep, typename Period>
+      bool waitFor(const std::chrono::duration<Rep, Period> & timeout) const;
+      // readable once the board is ready, -1 if there is no such file.
+      int readyFd() const;
+      // updated by the generating threads, readable at any time.
+      const GenerationProgress & progress() const;
+      // the board, waiting for it if needed. Only once, and not after cancel().
+      GameBoard get();
+      void cancel();
+
+    private:
+      LEVEL generation_level;
+      std::shared_ptr<GenerationState<GameBoard>> state;
+      std::future<GameBoard> board_future;
+    };
 
     template<typename GameBoard>
-    bool GenerateNewGame(GameBoard & board)
+    BoardGeneration<GameBoard>::BoardGeneration(LEVEL level, unsigned int num_of_threads, unsigned int num_of_trials)
+      : generation_level(level), state(std::make_shared<GenerationState<GameBoard>>())
     {
+      board_future = state->race.takeFuture();
+      // the threads share state through the race, do not pass any local reference to them.
+      const std::shared_ptr<FirstResultRace<GameBoard>> race(state, &state->race);
+      const std::shared_ptr<GenerationState<GameBoard>> shared_state = state;
+      RunRace(race, num_of_threads, [shared_state, level, num_of_trials](unsigned int, FirstResultRace<GameBoard> &)
+      {
+        RoutineToGenerateBoard(*shared_state, level, num_of_trials);
+      });
+    }
+
+    template<typename GameBoard>
+    BoardGeneration<GameBoard>::~BoardGeneration()
+    {
+      cancel();
+    }
+
+    template<typename GameBoard>
+    inline LEVEL BoardGeneration<GameBoard>::level() const
+    {
+      return generation_level;
+    }
+
+    template<typename GameBoard>
+    inline bool BoardGeneration<GameBoard>::isReady() const
+    {
+      return waitFor(std::chrono::seconds(0));
+    }
+
+    template<typename GameBoard>
+    template<typename Rep, typename Period>
+    inline bool BoardGeneration<GameBoard>::waitFor(const std::chrono::duration<Rep, Period> & timeout) const
+    {
+      return board_future.valid() && std::future_status::ready == board_future.wait_for(timeout);
+    }
+
+    template<typename GameBoard>
+    inline int BoardGeneration<GameBoard>::readyFd() const
+    {
+      return state->ready_pipe[0];
+    }
+
+    template<typename GameBoard>
+    inline const GenerationProgress & BoardGeneration<GameBoard>::progress() const
+    {
+      return state->progress;
+    }
+
+    template<typename GameBoard>
+    inline GameBoard BoardGeneration<GameBoard>::get()
+    {
+      return board_future.get();
+    }
+
+    template<typename GameBoard>
+    inline void BoardGeneration<GameBoard>::cancel()
+    {
+      state->race.cancel();
+    }
+
+    // one line of what the generating threads have done so far.
+    inline void PrintGenerationProgress(const GenerationProgress & progress)
+    {
+      std::cout << "Generating... " << static_cast<unsigned int>(progress.elapsed().count()) << " s: "
+                << progress.clues.load(std::memory_order_relaxed) << " clues, "
+                << GenerationProgress::read(progress.removals) << " cells removed, "
+                << GenerationProgress::read(progress.rejected_removals) << " put back, "
+                << GenerationProgress::read(progress.final_boards) << " final boards, "
+                << GenerationProgress::read(progress.fill_restarts) << " fills restarted, "
+                << static_cast<uint64_t>(progress.searchNodesPerSecond()) << " nodes/s"
+                << std::endl << std::endl;
+    }
+
+    enum class GenerationWait
+    {
+      ready,
+      cancelled,
+      in_background
+    };
+
+    /*
+      Wait for generation, until the board is ready or the player cancels it. The board
+      and the keyboard are polled together, so the board shows up the moment it is
+      done. If can_run_in_background, the player may also go back to the menu while
+      the generation goes on.
+    */
+    template<typename GameBoard>
+    GenerationWait WaitForGeneration(BoardGeneration<GameBoard> & generation, bool can_run_in_background)
+    {
+      // commands are typed lines: input piped in is left to the menus.
+      bool is_keyboard_open = isatty(STDIN_FILENO);
+      if(is_keyboard_open)
+      {
+        // the rest of the line of the option that started the generation.
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        std::cout << "\033[1;33mType c to cancel";
+        if(can_run_in_background)
+          std::cout << ", b to play on while generating";
+        std::cout << ".\033[0m" << std::endl << std::endl;
+      }
+      while(!generation.isReady())
+      {
+        pollfd files[2] = {{generation.readyFd(), POLLIN, 0}, {STDIN_FILENO, POLLIN, 0}};
+        const int num_of_ready_files = poll(files, is_keyboard_open ? 2 : 1, 1000);
+        if(0 == num_of_ready_files)
+        {
+          PrintGenerationProgress(generation.progress());
+          continue;
+        }
+        if(num_of_ready_files < 0 || !files[1].revents)
+          continue;
+        std::string command;
+        if(!std::getline(std::cin, command))
+        {
+          std::cin.clear();
+          is_keyboard_open = false;
+        }
+        else if("c" == command)
+        {
+          generation.cancel();
+          return GenerationWait::cancelled;
+        }
+        else if("b" == command && can_run_in_background)
+          return GenerationWait::in_background;
+      }
+      return GenerationWait::ready;
+    }
+
+    /* ask for a level up to max_level and start generating a board of it. Wide boards
+       pass a lower max_level, as their higher levels take minutes or never end.
+    */
+    template<typename GameBoard>
+    std::unique_ptr<BoardGeneration<GameBoard>> StartNewGame(LEVEL max_level = LEVEL::EXTREME)
+    {
+      const LEVEL levels[] = {LEVEL::EASY, LEVEL::MEDIUM, LEVEL::HARD, LEVEL::SAMURAI, LEVEL::EXTREME};
+      const char * names[] = {"Easy", "Medium", "Hard", "Samurai", "Extreme"};
       std::cout << "\033[1;32mPlease Select The Difficulty Level:\033[0m" <<std::endl << std::endl;
+      unsigned int num_of_levels = 0;
+      for(; num_of_levels < 5 && levels[num_of_levels] <= max_level; ++num_of_levels)
+        std::cout << "\033[1;33m" << num_of_levels << ". " << names[num_of_levels] << " \033[0m" << std::endl << std::endl;
       unsigned int option = 100;
-      std::cout << "\033[1;33m0. Easy \033[0m\033[0m" << std::endl << std::endl;
-      std::cout << "\033[1;33m1. Medium " << std::endl << std::endl;
-      std::cout << "\033[1;33m2. Hard \033[0m" << std::endl << std::endl;
-      std::cout << "\033[1;33m3. Samurai \033[0m" << std::endl<< std::endl;
-      std::cout << "\033[1;33m4. Extreme \033[0m" << std::endl<< std::endl;
-      LEVEL level;
-      std::shared_ptr<GameBoard> shared_board = std::make_shared<GameBoard>();
-      while(option > 4)
+      while(option >= num_of_levels)
       {
         std::cout << "\033[1;32mPlease Select A Valid Option: \033[0m" << std::endl << std::endl;
         std::cin.clear();
         std::cin >> option;
         std::cout << std::endl <<std::endl;
       }
-      switch (option)
+      const LEVEL level = levels[option];
+      // one generation using every core, rather than as many generations doing the same work.
+      const unsigned int num_of_trials = std::max(std::thread::hardware_concurrency(), 1u);
+      std::cout << num_of_trials << " threads start..." << std::endl << std::endl;
+      return std::unique_ptr<BoardGeneration<GameBoard>>(new BoardGeneration<GameBoard>(level, 1, num_of_trials));
+    }
+
+    /*
+      Wait for generation and put its board into board. The generation is over, and
+      reset, unless the player went back to the menu.
+    */
+    template<typename GameBoard>
+    bool WaitForNewGame(std::unique_ptr<BoardGeneration<GameBoard>> & generation, GameBoard & board,
+                        bool can_run_in_background = false)
+    {
+      switch(WaitForGeneration(*generation, can_run_in_background))
       {
-        case 0:
-          level = LEVEL::EASY;
-          break;
-        case 1:
-          level = LEVEL::MEDIUM;
-          break;
-        case 2:
-          level = LEVEL::HARD;
-          break;
-        case 3:
-          level = LEVEL::SAMURAI;
-          break;
-        case 4:
-          level = LEVEL::EXTREME;
+        case GenerationWait::ready:
+          board = generation->get();
+          generation.reset();
+          std::cout << std::endl <<"New Board Is Generated: " << std::endl << std::endl;
+          std::cout << board << std::endl << std::endl;
+          return true;
+        case GenerationWait::in_background:
+          std::cout << "\033[1;32mThe new game is still being generated, it shows up once ready. \033[0m"
+                    << std::endl << std::endl;
+          return false;
+        case GenerationWait::cancelled:
         default:
-          break;
+          generation.reset();
+          std::cout << "\033[1;41mGeneration Cancelled \033[0m" << std::endl << std::endl;
+          return false;
       }
-      // set is_work_done back to false
-      std::shared_ptr<bool> is_work_done_shared = std::make_shared<bool>(false);
+    }
 
-      for(auto i = 0; i < 4; ++i)
-      {
-        // start 4 threads for 4-core cpu.
-        // do not pass any local reference to thread.
-        std::thread(RoutineToGenerateBoard<GameBoard>, shared_board, is_work_done_shared, level).detach();
-      }
-      std::cout <<"Four threads start..." << std::endl << std::endl;
-      unsigned int percent = 0;
-      std::cout <<"Generating..." << percent <<" %" << std::endl << std::endl;
-      while(!(*is_work_done_shared))
-      {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        percent += 10;
-        // update the progress state
-        std::cout <<"Generating..." << percent <<" %" << std::endl << std::endl;
-      }
-      std::cout << std::endl <<"New Board Is Generated: " << std::endl << std::endl;
-      board = *shared_board;
-      // shared_board lives longer than this function execution. It is fine as
-      // it is shared_ptr.
-      std::cout << board << std::endl << std::endl;
-      return true;
+    template<typename GameBoard>
+    bool GenerateNewGame(GameBoard & board, LEVEL max_level = LEVEL::EXTREME)
+    {
+      std::unique_ptr<BoardGeneration<GameBoard>> generation = StartNewGame<GameBoard>(max_level);
+      return WaitForNewGame(generation, board);
     }
 
+    // new games are generated up to max_level, see StartNewGame.
     template<typename GameBoard>
-    void PlaySudokuGame(const std::string & name_of_game_type = "Regular Soduku")
+    void PlaySudokuGame(const std::string & name_of_game_type = "Regular Soduku", LEVEL max_level = LEVEL::EXTREME)
     {
       std::cout << name_of_game_type <<" Play!" <<std::endl << std::endl;
       unsigned int option = 100;
       GameBoard board;
       GameBoard back_up_baord;
+      // a new game being generated while playing on, see WaitForGeneration.
+      std::unique_ptr<BoardGeneration<GameBoard>> generation;
       while(true)
       {
+        if(generation && generation->isReady())
+        {
+          back_up_baord = board;
+          board = generation->get();
+          generation.reset();
+          std::cout << std::endl <<"New Board Is Generated: " << std::endl << std::endl;
+          std::cout << board << std::endl << std::endl;
+        }
         std::cout << std::endl;
         std::cout << "\033[1;32mOperation Selection: \033[0m" << std::endl << std::endl;
         std::cout << "\033[1;33m0. Load Game From File \033[0m" << std::endl << std::endl;
         std::cout << "\033[1;33m1. Solve Game \033[0m" << std::endl << std::endl;
         std::cout << "\033[1;33m2. Check Solutions \033[0m" << std::endl << std::endl;
         std::cout << "\033[1;33m3. Evaluate The Game \033[0m" << std::endl << std::endl;
-        std::cout << "\033[1;33m4. Generate A New Game \033[0m" << std::endl<< std::endl;
+        if(generation)
+          std::cout << "\033[1;33m4. Wait For The New Game \033[0m" << std::endl<< std::endl;
+        else
+          std::cout << "\033[1;33m4. Generate A New Game \033[0m" << std::endl<< std::endl;
         std::cout << "\033[1;33m5. Write Game To File \033[0m" << std::endl << std::endl;
         std::cout << "\033[1;33m6. Print Current Game \033[0m" << std::endl << std::endl;
         std::cout << "\033[1;33m7. Reset Current Game \033[0m" << std::endl << std::endl;
@@ -182,7 +406,7 @@ namespace wubinboardgames
           case 2:
           {
             // check solution does not fill the board.
-            std::vector<GameBoard> solutions = SearchSolution<GameBoard>(board);
+            std::vector<GameBoard> solutions = SearchSolutionPortfolio<GameBoard>(board);
             if(1 == solutions.size())
             {
               std::cout <<"The board has a unique solution: " << std::endl << std::endl;
@@ -236,8 +460,14 @@ namespace wubinboardgames
           }
           case 4:
           {
-            back_up_baord = board;
-            GenerateNewGame<GameBoard>(board);
+            if(!generation)
+              generation = StartNewGame<GameBoard>(max_level);
+            GameBoard new_board;
+            if(WaitForNewGame(generation, new_board, true))
+            {
+              back_up_baord = board;
+              board = new_board;
+            }
             break;
           }
           case 5:
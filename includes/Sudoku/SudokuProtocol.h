@@ -0,0 +1,264 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "SudokuEngine.h"
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    /* Binary protocol of the solver daemon (see SudokuDaemon.h). Every message is a
+       frame: its length as a 32 bit little endian number, then that many bytes.
+
+         request:  id (u32), operation, kind, level, 0, then the cells
+         response: id (u32), status, level, 0, 0, then the cells
+
+       Numbers are little endian, the other fields one byte each. Cells are one byte
+       each, row by row: 0 for a vacant cell, 1 to width otherwise. Samurai boards only
+       send their active cells. Responses carry the id of their request, and may come
+       back in any order.
+       The response to progress holds the counters of DaemonProgress instead of cells,
+       each a 64 bit little endian number.
+    */
+    enum class DaemonOperation : uint8_t
+    {
+      solve = 1,    // cells of the board -> cells of its solution
+      grade = 2,    // cells of the board -> its level
+      generate = 3, // level -> cells of a new board
+      progress = 4  // -> what the generators of the daemon have done so far
+    };
+
+    enum class BoardKind : uint8_t
+    {
+      regular,
+      extended,
+      giant,
+      colossal,
+      samurai,
+      diagonal,
+      windoku,
+      mini,
+      octo,
+      dozen,
+      number_of_kinds
+    };
+
+    enum class DaemonStatus : uint8_t
+    {
+      ok,
+      no_solution,
+      not_unique,    // solve: cells hold one of the solutions.
+      bad_request,
+      unsupported,   // a level the daemon does not generate for this kind, say.
+      over_budget    // the search ran out of time or nodes. solve: cells hold a solution if one was found.
+    };
+
+    constexpr std::size_t DAEMON_HEADER_LENGTH = 8;
+    // the biggest board is 36x36, anything much longer is not a frame.
+    constexpr std::size_t DAEMON_MAX_FRAME_LENGTH = 1 << 16;
+
+    struct DaemonRequest
+    {
+      uint32_t id = 0;
+      DaemonOperation operation = DaemonOperation::solve;
+      BoardKind kind = BoardKind::regular;
+      // see LevelCode: 0 for EASY up to 4 for EXTREME.
+      uint8_t level = 0;
+      std::vector<uint8_t> cells;
+    };
+
+    struct DaemonResponse
+    {
+      uint32_t id = 0;
+      DaemonStatus status = DaemonStatus::ok;
+      uint8_t level = 0;
+      std::vector<uint8_t> cells;
+    };
+
+    // levels of the protocol, in the order of their codes.
+    constexpr LEVEL DAEMON_LEVELS[] = {LEVEL::EASY, LEVEL::MEDIUM, LEVEL::HARD, LEVEL::SAMURAI, LEVEL::EXTREME};
+    constexpr uint8_t DAEMON_NUMBER_OF_LEVELS = sizeof(DAEMON_LEVELS) / sizeof(DAEMON_LEVELS[0]);
+
+    inline uint8_t LevelCode(LEVEL level)
+    {
+      unsigned int code = 0;
+      while(code < DAEMON_NUMBER_OF_LEVELS - 1u && DAEMON_LEVELS[code] < level)
+        ++code;
+      return static_cast<uint8_t>(code);
+    }
+
+    inline void AppendUint32(std::vector<uint8_t> & out, uint32_t value)
+    {
+      for(unsigned int shift = 0; shift < 32; shift += 8)
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+
+    inline uint32_t ReadUint32(const uint8_t * in)
+    {
+      return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+             static_cast<uint32_t>(in[2]) << 16 | static_cast<uint32_t>(in[3]) << 24;
+    }
+
+    inline void AppendUint64(std::vector<uint8_t> & out, uint64_t value)
+    {
+      AppendUint32(out, static_cast<uint32_t>(value));
+      AppendUint32(out, static_cast<uint32_t>(value >> 32));
+    }
+
+    inline uint64_t ReadUint64(const uint8_t * in)
+    {
+      return static_cast<uint64_t>(ReadUint32(in)) | static_cast<uint64_t>(ReadUint32(in + 4)) << 32;
+    }
+
+    // the counters of GenerationProgress, in the order they are sent.
+    struct DaemonProgress
+    {
+      uint64_t final_boards = 0;
+      uint64_t fill_restarts = 0;
+      uint64_t removals = 0;
+      uint64_t rejected_removals = 0;
+      uint64_t clues = 0;
+      uint64_t search_nodes = 0;
+      uint64_t elapsed_milliseconds = 0;
+    };
+
+    constexpr std::size_t DAEMON_PROGRESS_LENGTH = 7 * 8;
+
+    inline void EncodeProgress(const GenerationProgress & progress, std::vector<uint8_t> & out)
+    {
+      AppendUint64(out, GenerationProgress::read(progress.final_boards));
+      AppendUint64(out, GenerationProgress::read(progress.fill_restarts));
+      AppendUint64(out, GenerationProgress::read(progress.removals));
+      AppendUint64(out, GenerationProgress::read(progress.rejected_removals));
+      AppendUint64(out, progress.clues.load(std::memory_order_relaxed));
+      AppendUint64(out, GenerationProgress::read(progress.search_nodes));
+      AppendUint64(out, static_cast<uint64_t>(progress.elapsed().count() * 1000));
+    }
+
+    inline bool DecodeProgress(const std::vector<uint8_t> & cells, DaemonProgress & progress)
+    {
+      if(cells.size() != DAEMON_PROGRESS_LENGTH)
+        return false;
+      const uint8_t * in = cells.data();
+      progress.final_boards = ReadUint64(in);
+      progress.fill_restarts = ReadUint64(in + 8);
+      progress.removals = ReadUint64(in + 16);
+      progress.rejected_removals = ReadUint64(in + 24);
+      progress.clues = ReadUint64(in + 32);
+      progress.search_nodes = ReadUint64(in + 40);
+      progress.elapsed_milliseconds = ReadUint64(in + 48);
+      return true;
+    }
+
+    // append the frame of request to out.
+    inline void EncodeRequest(const DaemonRequest & request, std::vector<uint8_t> & out)
+    {
+      AppendUint32(out, static_cast<uint32_t>(DAEMON_HEADER_LENGTH + request.cells.size()));
+      AppendUint32(out, request.id);
+      out.push_back(static_cast<uint8_t>(request.operation));
+      out.push_back(static_cast<uint8_t>(request.kind));
+      out.push_back(request.level);
+      out.push_back(0);
+      out.insert(out.end(), request.cells.begin(), request.cells.end());
+    }
+
+    inline void EncodeResponse(const DaemonResponse & response, std::vector<uint8_t> & out)
+    {
+      AppendUint32(out, static_cast<uint32_t>(DAEMON_HEADER_LENGTH + response.cells.size()));
+      AppendUint32(out, response.id);
+      out.push_back(static_cast<uint8_t>(response.status));
+      out.push_back(response.level);
+      out.push_back(0);
+      out.push_back(0);
+      out.insert(out.end(), response.cells.begin(), response.cells.end());
+    }
+
+    /* Length of the first frame of the available bytes at data, length field included.
+       0 if it is not all there yet. Frames over DAEMON_MAX_FRAME_LENGTH are returned
+       as they are, for the caller to drop the connection.
+    */
+    inline std::size_t FrameLength(const uint8_t * data, std::size_t available)
+    {
+      if(available < 4)
+        return 0;
+      const std::size_t length = 4 + static_cast<std::size_t>(ReadUint32(data));
+      if(length - 4 > DAEMON_MAX_FRAME_LENGTH)
+        return length;
+      return (length <= available) ? length : 0;
+    }
+
+    // decode a whole frame, as measured by FrameLength. False if it is not a request.
+    inline bool DecodeRequest(const uint8_t * frame, std::size_t length, DaemonRequest & request)
+    {
+      if(length < 4 + DAEMON_HEADER_LENGTH || length != 4 + ReadUint32(frame))
+        return false;
+      const uint8_t * header = frame + 4;
+      request.id = ReadUint32(header);
+      request.operation = static_cast<DaemonOperation>(header[4]);
+      request.kind = static_cast<BoardKind>(header[5]);
+      request.level = header[6];
+      request.cells.assign(header + DAEMON_HEADER_LENGTH, frame + length);
+      return true;
+    }
+
+    inline bool DecodeResponse(const uint8_t * frame, std::size_t length, DaemonResponse & response)
+    {
+      if(length < 4 + DAEMON_HEADER_LENGTH || length != 4 + ReadUint32(frame))
+        return false;
+      const uint8_t * header = frame + 4;
+      response.id = ReadUint32(header);
+      response.status = static_cast<DaemonStatus>(header[4]);
+      response.level = header[5];
+      response.cells.assign(header + DAEMON_HEADER_LENGTH, frame + length);
+      return true;
+    }
+
+    // the cells of board in the protocol, active cells only.
+    template<typename SudokuBoard>
+    void BoardToCells(const SudokuBoard & board, std::vector<uint8_t> & cells)
+    {
+      typedef typename SudokuBoard::Cell Cell;
+      typedef typename Cell::ValueType ValueType;
+      constexpr unsigned int width = SudokuBoard::width;
+      const auto & layout = board.layout();
+      cells.clear();
+      for(unsigned int index = 0; index < width * width; ++index)
+      {
+        if(!layout.isActive(index))
+          continue;
+        const Cell & cell = board[index / width][index % width];
+        cells.push_back(cell.isVacant() ? 0 :
+            static_cast<uint8_t>(static_cast<ValueType>(cell) - Cell::minimum_value + 1));
+      }
+    }
+
+    // false, and board unchanged, unless cells are the active cells of a board of this type.
+    template<typename SudokuBoard>
+    bool CellsToBoard(const std::vector<uint8_t> & cells, SudokuBoard & board)
+    {
+      typedef typename SudokuBoard::Cell Cell;
+      typedef typename Cell::ValueType ValueType;
+      constexpr unsigned int width = SudokuBoard::width;
+      SudokuBoard new_board;
+      const auto & layout = new_board.layout();
+      if(cells.size() != layout.numberOfActiveCells())
+        return false;
+      unsigned int active_index = 0;
+      for(unsigned int index = 0; index < width * width; ++index)
+      {
+        if(!layout.isActive(index))
+          continue;
+        const uint8_t digit = cells[active_index++];
+        if(digit > Cell::values_length)
+          return false;
+        new_board[index / width][index % width] = static_cast<ValueType>(Cell::minimum_value - 1 + digit);
+      }
+      new_board.rehash();
+      board = new_board;
+      return true;
+    }
+  }
+}
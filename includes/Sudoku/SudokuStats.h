@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <atomic>
+
+/* SearchStats is the telemetry of the searches and generators in SudokuEngine.h.
+   Pass a SearchStats pointer to fill it. Counters add up over every search made
+   with the same object, so clear() it between runs when needed.
+   Define _no_search_stats to compile every recording out but the node count, which
+   GenerationProgress reports its search nodes from.
+   GenerationProgress is the progress of generators, for other threads to follow.
+*/
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    struct SearchStats
+    {
+      // states entered by the search (cells pushed or recursion steps)
+      uint64_t nodes = 0;
+      // values put on a cell
+      uint64_t forwards = 0;
+      // cells given up because no value fits any more
+      uint64_t backtracks = 0;
+      // cells filled because a single value was left for them
+      uint64_t propagations = 0;
+      unsigned int max_depth = 0;
+      // measured from the start of the outermost instrumented call
+      std::chrono::nanoseconds time_to_first_solution{0};
+      std::chrono::nanoseconds time_to_second_solution{0};
+      std::chrono::nanoseconds wall_time{0};
+      // number of instrumented calls running. Nested calls (the searches made by a
+      // generator) only add to the counters.
+      unsigned int open_calls = 0;
+
+      void clear()
+      {
+        *this = SearchStats{};
+      }
+
+      // add the counters of other, filled by searches made apart (on another thread, say).
+      void addCounters(const SearchStats & other)
+      {
+        nodes += other.nodes;
+        forwards += other.forwards;
+        backtracks += other.backtracks;
+        propagations += other.propagations;
+        if(other.max_depth > max_depth)
+          max_depth = other.max_depth;
+      }
+    };
+
+    /* GenerationProgress is published by the generators of SudokuEngine.h as they
+       go, and read by other threads at any time without locks: every member is a
+       relaxed atomic, so a reader sees each counter up to date on its own, not a
+       snapshot of all of them. Generators sharing one add up their counts.
+    */
+    struct GenerationProgress
+    {
+      // final boards drawn to dig puzzles from, the first one included.
+      std::atomic<uint64_t> final_boards{0};
+      // fills of a final board started over, stuck in a dead branch.
+      std::atomic<uint64_t> fill_restarts{0};
+      // cells set vacant for good, and cells put back as the solution was no longer unique.
+      std::atomic<uint64_t> removals{0};
+      std::atomic<uint64_t> rejected_removals{0};
+      // given cells of the board being dug, as last set by any generator.
+      std::atomic<unsigned int> clues{0};
+      // nodes of the searches made on the boards being dug.
+      std::atomic<uint64_t> search_nodes{0};
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+      static void add(std::atomic<uint64_t> & counter, uint64_t n = 1)
+      {
+        counter.fetch_add(n, std::memory_order_relaxed);
+      }
+
+      static uint64_t read(const std::atomic<uint64_t> & counter)
+      {
+        return counter.load(std::memory_order_relaxed);
+      }
+
+      std::chrono::duration<double> elapsed() const
+      {
+        return std::chrono::steady_clock::now() - start;
+      }
+
+      double searchNodesPerSecond() const
+      {
+        const double seconds = elapsed().count();
+        return (seconds > 0) ? static_cast<double>(read(search_nodes)) / seconds : 0;
+      }
+    };
+
+#ifndef _no_search_stats
+    /* StatsRecorder is created at the start of an instrumented call. It does nothing
+       but a null check when no SearchStats is given.
+    */
+    class StatsRecorder
+    {
+    public:
+      explicit StatsRecorder(SearchStats * search_stats) : stats(search_stats), solutions(0), outermost(false)
+      {
+        if(stats)
+        {
+          outermost = (0 == stats->open_calls++);
+          if(outermost)
+            start = std::chrono::steady_clock::now();
+        }
+      }
+
+      ~StatsRecorder()
+      {
+        if(stats)
+        {
+          --stats->open_calls;
+          if(outermost)
+            stats->wall_time += std::chrono::steady_clock::now() - start;
+        }
+      }
+
+      StatsRecorder(const StatsRecorder & another) = delete;
+      StatsRecorder & operator=(const StatsRecorder & another) = delete;
+
+      SearchStats * get() const
+      {
+        return stats;
+      }
+
+      void node(unsigned int depth)
+      {
+        if(stats)
+        {
+          ++stats->nodes;
+          if(depth > stats->max_depth)
+            stats->max_depth = depth;
+        }
+      }
+
+      void forward()
+      {
+        if(stats)
+          ++stats->forwards;
+      }
+
+      void backtrack()
+      {
+        if(stats)
+          ++stats->backtracks;
+      }
+
+      void propagation(unsigned int num_of_cells = 1)
+      {
+        if(stats)
+          stats->propagations += num_of_cells;
+      }
+
+      void solution()
+      {
+        if(stats && outermost)
+        {
+          ++solutions;
+          if(1 == solutions)
+            stats->time_to_first_solution = std::chrono::steady_clock::now() - start;
+          else if(2 == solutions)
+            stats->time_to_second_solution = std::chrono::steady_clock::now() - start;
+        }
+      }
+
+    private:
+      SearchStats * stats;
+      unsigned int solutions;
+      bool outermost;
+      std::chrono::steady_clock::time_point start;
+    };
+#else
+    class StatsRecorder
+    {
+    public:
+      explicit StatsRecorder(SearchStats * search_stats) : stats(search_stats) {}
+      SearchStats * get() const { return stats; }
+      void node(unsigned int) { if(stats) ++stats->nodes; }
+      void forward() {}
+      void backtrack() {}
+      void propagation(unsigned int = 1) {}
+      void solution() {}
+
+    private:
+      SearchStats * stats;
+    };
+#endif
+  }
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+
+#include "Generic/RegionLayout.h"
+
+/* UnavoidableSets are sets of cells of a solved board whose values can be permuted
+   into another solved board. A puzzle of that board with no given cell in one of its
+   sets has both boards as solutions, so the digging loops of SudokuEngine.h reject
+   the removals emptying a set without searching.
+   The sets made of two values are found up front: for a pair of values a and b, the
+   cells holding a and b in a unit must be swapped together, and the connected groups
+   of cells so linked can each be swapped on their own. A group with a cell in a unit
+   with a sum holding only one of the two values cannot, as the sum would change.
+   Others are learnt as the puzzle is dug: each removal found to break uniqueness
+   comes with another solution, and the cells where it differs are a set.
+*/
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    template<typename SudokuBoard>
+    class UnavoidableSets
+    {
+    public:
+      static constexpr unsigned int width = SudokuBoard::width;
+      static constexpr unsigned int end_index = width * width;
+      typedef typename SudokuBoard::Cell Cell;
+      typedef typename Cell::ValueType ValueType;
+      static constexpr unsigned int values_length = Cell::values_length;
+
+      // the sets of solution, a solved board whose active cells are all given.
+      explicit UnavoidableSets(const SudokuBoard & solution);
+
+      unsigned int size() const;
+      // the cells of a set.
+      std::vector<unsigned int> cellsOf(unsigned int set) const;
+      // false if setting index vacant would leave a set without any given cell.
+      bool canRemove(unsigned int index) const;
+      // the same for setting index and other vacant together.
+      bool canRemove(unsigned int index, unsigned int other) const;
+      // index was set vacant for good.
+      void remove(unsigned int index);
+      // index, set vacant before, was given back.
+      void restore(unsigned int index);
+      // learn the set of cells where other_solution differs, board being the puzzle dug so far.
+      void learn(const SudokuBoard & other_solution, const SudokuBoard & board);
+
+    private:
+      void addSet(const std::vector<uint16_t> & cells, unsigned int num_of_givens);
+      void addSetsOf(const RegionLayout & layout, unsigned int a, unsigned int b);
+
+      // value offsets of the solution.
+      std::vector<uint8_t> values;
+      std::vector<uint32_t> set_offsets{0};
+      std::vector<uint16_t> set_cells;
+      // given cells left in each set.
+      std::vector<uint16_t> givens_left;
+      // the sets of each cell.
+      std::vector<std::vector<uint32_t>> sets_of_cell;
+    };
+
+    template<typename SudokuBoard>
+    UnavoidableSets<SudokuBoard>::UnavoidableSets(const SudokuBoard & solution)
+      : values(end_index, 0), sets_of_cell(end_index)
+    {
+      const RegionLayout & layout = solution.layout();
+      for(unsigned int index = 0; index < end_index; ++index)
+      {
+        if(layout.isActive(index))
+          values[index] = static_cast<uint8_t>(static_cast<ValueType>(solution[index/width][index%width]) -
+                                               Cell::minimum_value);
+      }
+      for(unsigned int a = 0; a < values_length; ++a)
+      {
+        for(unsigned int b = a + 1; b < values_length; ++b)
+          addSetsOf(layout, a, b);
+      }
+    }
+
+    template<typename SudokuBoard>
+    void UnavoidableSets<SudokuBoard>::addSet(const std::vector<uint16_t> & cells, unsigned int num_of_givens)
+    {
+      const uint32_t set = static_cast<uint32_t>(size());
+      for(uint16_t index : cells)
+        sets_of_cell[index].push_back(set);
+      set_cells.insert(set_cells.end(), cells.begin(), cells.end());
+      set_offsets.push_back(static_cast<uint32_t>(set_cells.size()));
+      givens_left.push_back(static_cast<uint16_t>(num_of_givens));
+    }
+
+    template<typename SudokuBoard>
+    void UnavoidableSets<SudokuBoard>::addSetsOf(const RegionLayout & layout, unsigned int a, unsigned int b)
+    {
+      // union-find on the cells holding a or b.
+      std::vector<uint16_t> group(end_index);
+      std::iota(group.begin(), group.end(), 0);
+      auto root = [&group](unsigned int index)
+      {
+        while(group[index] != index)
+          index = group[index] = group[group[index]];
+        return index;
+      };
+      std::vector<uint8_t> is_fixed(end_index, 0);
+      for(unsigned int unit = 0; unit < layout.numberOfUnits(); ++unit)
+      {
+        unsigned int cell_of_a = end_index, cell_of_b = end_index;
+        const uint16_t * cells = layout.unitCells(unit);
+        for(unsigned int n = 0; n < layout.unitSize(unit); ++n)
+        {
+          if(a == values[cells[n]])
+            cell_of_a = cells[n];
+          else if(b == values[cells[n]])
+            cell_of_b = cells[n];
+        }
+        if(cell_of_a < end_index && cell_of_b < end_index)
+          group[root(cell_of_a)] = static_cast<uint16_t>(root(cell_of_b));
+        // a cage holding only one of them fixes it: swapping would change its sum.
+        else if(layout.unitSum(unit) && (cell_of_a < end_index || cell_of_b < end_index))
+          is_fixed[(cell_of_a < end_index) ? cell_of_a : cell_of_b] = 1;
+      }
+
+      std::vector<std::vector<uint16_t>> groups(end_index);
+      std::vector<uint8_t> is_group_fixed(end_index, 0);
+      for(unsigned int index = 0; index < end_index; ++index)
+      {
+        if(!layout.isActive(index) || (a != values[index] && b != values[index]))
+          continue;
+        const unsigned int group_root = root(index);
+        groups[group_root].push_back(static_cast<uint16_t>(index));
+        is_group_fixed[group_root] |= is_fixed[index];
+      }
+      for(unsigned int group_root = 0; group_root < end_index; ++group_root)
+      {
+        if(!groups[group_root].empty() && !is_group_fixed[group_root])
+          addSet(groups[group_root], static_cast<unsigned int>(groups[group_root].size()));
+      }
+    }
+
+    template<typename SudokuBoard>
+    inline unsigned int UnavoidableSets<SudokuBoard>::size() const
+    {
+      return static_cast<unsigned int>(set_offsets.size() - 1);
+    }
+
+    template<typename SudokuBoard>
+    std::vector<unsigned int> UnavoidableSets<SudokuBoard>::cellsOf(unsigned int set) const
+    {
+      return std::vector<unsigned int>(set_cells.begin() + set_offsets[set], set_cells.begin() + set_offsets[set + 1]);
+    }
+
+    template<typename SudokuBoard>
+    inline bool UnavoidableSets<SudokuBoard>::canRemove(unsigned int index) const
+    {
+      for(uint32_t set : sets_of_cell[index])
+      {
+        if(givens_left[set] <= 1)
+          return false;
+      }
+      return true;
+    }
+
+    template<typename SudokuBoard>
+    bool UnavoidableSets<SudokuBoard>::canRemove(unsigned int index, unsigned int other) const
+    {
+      if(index == other)
+        return canRemove(index);
+      // sets are numbered in order, so the sets of a cell are sorted.
+      const std::vector<uint32_t> & sets_of_other = sets_of_cell[other];
+      for(uint32_t set : sets_of_cell[index])
+      {
+        const bool has_other = std::binary_search(sets_of_other.begin(), sets_of_other.end(), set);
+        if(givens_left[set] <= (has_other ? 2u : 1u))
+          return false;
+      }
+      return canRemove(other);
+    }
+
+    template<typename SudokuBoard>
+    inline void UnavoidableSets<SudokuBoard>::remove(unsigned int index)
+    {
+      for(uint32_t set : sets_of_cell[index])
+        --givens_left[set];
+    }
+
+    template<typename SudokuBoard>
+    inline void UnavoidableSets<SudokuBoard>::restore(unsigned int index)
+    {
+      for(uint32_t set : sets_of_cell[index])
+        ++givens_left[set];
+    }
+
+    template<typename SudokuBoard>
+    void UnavoidableSets<SudokuBoard>::learn(const SudokuBoard & other_solution, const SudokuBoard & board)
+    {
+      const RegionLayout & layout = board.layout();
+      std::vector<uint16_t> cells;
+      unsigned int num_of_givens = 0;
+      for(unsigned int index = 0; index < end_index; ++index)
+      {
+        const Cell & cell = other_solution[index/width][index%width];
+        if(!layout.isActive(index) || cell.isVacant() ||
+           values[index] == static_cast<ValueType>(cell) - Cell::minimum_value)
+          continue;
+        cells.push_back(static_cast<uint16_t>(index));
+        num_of_givens += !board[index/width][index%width].isVacant();
+      }
+      if(!cells.empty())
+        addSet(cells, num_of_givens);
+    }
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+
+#include "Generic/GenericBoard.h"
+#include "Generic/RegionLayout.h"
+#include "SudokuCell.h"
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    /* GenericVariantBoard is a sudoku board with units on top of its rows, columns
+       and boxes, all fixed by the rule RULE. RULE::units(width, box_height, box_width)
+       returns every unit of the board, and is compiled once into the peer and unit tables of RegionLayout,
+       which the solvers in SudokuEngine.h read instead of the row, column and box
+       arithmetic of classic boards.
+       Files are the same as those of classic boards.
+    */
+    template<typename CELL, typename RULE, unsigned int WIDTH = CELL::values_length>
+    class GenericVariantBoard : public GenericBoard<CELL, WIDTH>
+    {
+    public:
+      typedef GenericBoard<CELL, WIDTH> BaseBoard;
+      typedef RULE Rule;
+      using BaseBoard::width;
+      using BaseBoard::box_height;
+      using BaseBoard::box_width;
+      static constexpr bool has_box_layout = false;
+
+      GenericVariantBoard() = default;
+      using BaseBoard::BaseBoard;
+
+      const RegionLayout & layout() const;
+    };
+
+    template<typename CELL, typename RULE, unsigned int WIDTH>
+    inline const RegionLayout & GenericVariantBoard<CELL,RULE,WIDTH>::layout() const
+    {
+      static const RegionLayout variant_layout(width, RULE::units(width, box_height, box_width));
+      return variant_layout;
+    }
+
+    // X sudoku: the two main diagonals hold every value too.
+    struct DiagonalRule
+    {
+      static std::vector<std::vector<unsigned int>> units(unsigned int width, unsigned int box_height, unsigned int box_width)
+      {
+        std::vector<std::vector<unsigned int>> units = BoxUnits(width, box_height, box_width);
+        std::vector<std::vector<unsigned int>> diagonals = DiagonalUnits(width);
+        units.insert(units.end(), diagonals.begin(), diagonals.end());
+        return units;
+      }
+    };
+
+    // windoku: the boxes between the boxes (see WindowUnits) hold every value too.
+    struct WindokuRule
+    {
+      static std::vector<std::vector<unsigned int>> units(unsigned int width, unsigned int box_height, unsigned int box_width)
+      {
+        std::vector<std::vector<unsigned int>> units = BoxUnits(width, box_height, box_width);
+        std::vector<std::vector<unsigned int>> windows = WindowUnits(width, box_height, box_width);
+        units.insert(units.end(), windows.begin(), windows.end());
+        return units;
+      }
+    };
+
+    typedef GenericVariantBoard<SudokuCell, DiagonalRule> DiagonalSudokuBoard;
+    typedef GenericVariantBoard<SudokuCell, WindokuRule> WindokuBoard;
+  }
+}
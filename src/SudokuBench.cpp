@@ -0,0 +1,363 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+
+#include "Sudoku/SudokuEngine.h"
+#include "Sudoku/SudokuBoard.h"
+#include "Sudoku/SamuraiBoard.h"
+#include "Sudoku/KillerEngine.h"
+#include "Sudoku/JigsawEngine.h"
+#include "Sudoku/VariantBoard.h"
+#include "Generic/DeadlineFlag.h"
+
+/*
+  Benchmark harness of the sudoku engine.
+  Every bundled board file is loaded with the board type matching its content and
+  parsing and formatting it, IsBoardValid, SearchSolution and LevelEvaluate are
+  timed on it. GenerateFinalBoard
+  and GenerateSolvableBoard (per LEVEL) are timed for every board type, and
+  GenerateMinimalBoard and rotationally symmetric EXTREME boards for 9x9 boards.
+  The report gives min, median and p99 latency and the throughput of each case. With
+  --csv the same numbers are appended to a file, labelled with --label (the makefile
+  passes the git commit) so runs of different commits can be compared.
+*/
+
+using namespace wubinboardgames::sudoku;
+using wubinboardgames::ReadTextFile;
+using wubinboardgames::BoardFormat;
+using wubinboardgames::MaxFormattedLength;
+using wubinboardgames::DeadlineFlag;
+
+namespace
+{
+  struct BenchOptions
+  {
+    unsigned int iterations = 50;
+    unsigned int generate_iterations = 3;
+    // a case stops taking samples once it has spent that long, and a sample running
+    // past it is cancelled.
+    double time_limit_seconds = 10.0;
+    // the highest level generated for 9x9 boards, and for larger boards and variants.
+    LEVEL max_level = LEVEL::EXTREME;
+    LEVEL max_extended_level = LEVEL::EASY;
+    std::string label = "local";
+    std::string csv_path;
+    std::string trace_path;
+    std::vector<std::string> board_files;
+  };
+
+  struct BenchResult
+  {
+    std::string benchmark;
+    std::string board_type;
+    std::string input;
+    std::vector<double> samples_us;
+  };
+
+  // results are accumulated here so the compiler cannot drop the timed calls.
+  unsigned long long bench_sink = 0;
+
+  /* Measure times routine, given the flag cancelling it at the time limit, up to
+     iterations times. A sample cancelled so is only kept if it is the first one, and
+     the input is then marked as timed out.
+  */
+  template<typename Routine>
+  BenchResult Measure(const std::string & benchmark, const std::string & board_type,
+                      const std::string & input, unsigned int iterations,
+                      double time_limit_seconds, Routine routine)
+  {
+    BenchResult result{benchmark, board_type, input, {}};
+    const DeadlineFlag deadline(std::chrono::steady_clock::now() +
+                                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double>(time_limit_seconds)));
+    double spent_us = 0.0;
+    for(unsigned int i = 0; i < iterations; ++i)
+    {
+      auto start = std::chrono::steady_clock::now();
+      routine(deadline.flag());
+      auto end = std::chrono::steady_clock::now();
+      const bool is_timed_out = deadline.flag()->load();
+      if(is_timed_out && !result.samples_us.empty())
+        break;
+      double sample_us = std::chrono::duration<double, std::micro>(end - start).count();
+      result.samples_us.push_back(sample_us);
+      spent_us += sample_us;
+      if(is_timed_out)
+        result.input += " (timed out)";
+      if(is_timed_out || spent_us > time_limit_seconds * 1e6)
+        break;
+    }
+    return result;
+  }
+
+  double Percentile(const std::vector<double> & sorted_samples, double ratio)
+  {
+    std::size_t rank = static_cast<std::size_t>(ratio * sorted_samples.size() + 0.999999);
+    rank = std::max<std::size_t>(rank, 1);
+    return sorted_samples[std::min(rank, sorted_samples.size()) - 1];
+  }
+
+  void Report(const std::vector<BenchResult> & results, const BenchOptions & options)
+  {
+    std::ofstream csv;
+    if(!options.csv_path.empty())
+    {
+      bool is_new_file = !std::ifstream(options.csv_path).good();
+      csv.open(options.csv_path, std::ofstream::app);
+      if(is_new_file)
+        csv << "label,benchmark,board_type,input,samples,min_us,median_us,p99_us,mean_us,ops_per_sec\n";
+    }
+    std::cout << std::left << std::setw(24) << "benchmark" << std::setw(26) << "board type"
+              << std::setw(28) << "input" << std::right << std::setw(8) << "samples"
+              << std::setw(14) << "min(us)" << std::setw(14) << "median(us)"
+              << std::setw(14) << "p99(us)" << std::setw(14) << "ops/s" << std::endl;
+    for(const auto & result : results)
+    {
+      std::vector<double> samples{result.samples_us};
+      std::sort(samples.begin(), samples.end());
+      double mean = 0.0;
+      for(double sample : samples)
+        mean += sample;
+      mean /= samples.size();
+      double throughput = mean > 0.0 ? 1e6 / mean : 0.0;
+      std::cout << std::left << std::setw(24) << result.benchmark << std::setw(26) << result.board_type
+                << std::setw(28) << result.input << std::right << std::setw(8) << samples.size()
+                << std::fixed << std::setprecision(2)
+                << std::setw(14) << samples.front() << std::setw(14) << Percentile(samples, 0.5)
+                << std::setw(14) << Percentile(samples, 0.99) << std::setw(14) << throughput << std::endl;
+      if(csv)
+      {
+        csv << options.label << ',' << result.benchmark << ',' << result.board_type << ','
+            << result.input << ',' << samples.size() << ',' << samples.front() << ','
+            << Percentile(samples, 0.5) << ',' << Percentile(samples, 0.99) << ','
+            << mean << ',' << throughput << '\n';
+      }
+    }
+  }
+
+  template<typename GameBoard>
+  void BenchBoardFile(const std::string & type_name, const std::string & path,
+                      const BenchOptions & options, std::vector<BenchResult> & results)
+  {
+    GameBoard board;
+    std::string text, error;
+    if(!ReadTextFile(path, text) || !ParseBoardText(text.data(), text.data() + text.size(), board, &error))
+    {
+      std::cerr << "Skip " << path << ": " << (error.empty() ? "cannot be read" : error) << std::endl;
+      return;
+    }
+    std::string input = path.substr(path.find_last_of('/') + 1);
+    results.push_back(Measure("ParseBoard", type_name, input, options.iterations * 100,
+                              options.time_limit_seconds,
+                              [&](const std::atomic<bool> *){ GameBoard parsed_board;
+                                   bench_sink += ParseBoardText(text.data(), text.data() + text.size(), parsed_board); }));
+    std::vector<char> formatted(MaxFormattedLength<GameBoard>(BoardFormat::grid));
+    results.push_back(Measure("FormatBoard", type_name, input, options.iterations * 100,
+                              options.time_limit_seconds,
+                              [&](const std::atomic<bool> *){ bench_sink += FormatBoard(board, BoardFormat::grid, formatted.data(), formatted.size()); }));
+    results.push_back(Measure("IsBoardValid", type_name, input, options.iterations * 100,
+                              options.time_limit_seconds,
+                              [&](const std::atomic<bool> *){ bench_sink += IsBoardValid<GameBoard>(board); }));
+    results.push_back(Measure("SearchSolution", type_name, input, options.iterations,
+                              options.time_limit_seconds,
+                              [&](const std::atomic<bool> *){ bench_sink += SearchSolution<GameBoard>(board).size(); }));
+    results.push_back(Measure("LevelEvaluate", type_name, input, options.iterations,
+                              options.time_limit_seconds,
+                              [&](const std::atomic<bool> *){ bench_sink += LevelEvaluate<GameBoard>(board); }));
+  }
+
+  template<typename GameBoard>
+  void BenchGeneration(const std::string & type_name, LEVEL max_level,
+                       const BenchOptions & options, std::vector<BenchResult> & results)
+  {
+    results.push_back(Measure("GenerateFinalBoard", type_name, "-", options.iterations,
+                              options.time_limit_seconds,
+                              [&](const std::atomic<bool> * cancelled){ bench_sink += GenerateFinalBoard<GameBoard>(nullptr, cancelled)[0][0].isValid(); }));
+    const std::vector<std::pair<LEVEL, std::string>> levels{
+      {LEVEL::EASY, "EASY"}, {LEVEL::MEDIUM, "MEDIUM"}, {LEVEL::HARD, "HARD"},
+      {LEVEL::SAMURAI, "SAMURAI"}, {LEVEL::EXTREME, "EXTREME"}};
+    for(const auto & level : levels)
+    {
+      if(level.first > max_level)
+        break;
+      results.push_back(Measure("GenerateSolvableBoard", type_name, level.second,
+                                options.generate_iterations, options.time_limit_seconds,
+                                [&](const std::atomic<bool> * cancelled)
+                                { bench_sink += GenerateSolvableBoard<GameBoard>(level.first, GameBoard::width * GameBoard::width / 2.5,
+                                                                                 nullptr, cancelled)[0][0].isValid(); }));
+    }
+  }
+
+  /* Board files carry no type. Count the cells and look for letters to pick the board
+     type: 81 cells are 9x9, 256 cells are 16x16, 369 cells are the five grids of a
+     samurai board, letters mean an alphabet board. A 9x9 jigsaw board has 81 values
+     and 81 region numbers, a 9x9 killer board has 81 values, 81 cage numbers and the
+     sums of its cages. X sudoku and windoku files look like 9x9 ones and are not told
+     apart. A board on one line has one cell per character.
+  */
+  void BenchBoardFileByContent(const std::string & path, const BenchOptions & options,
+                               std::vector<BenchResult> & results)
+  {
+    std::string text;
+    ReadTextFile(path, text);
+    unsigned int num_of_tokens = 0, token_length = 0, longest_token = 0;
+    bool has_letters = false;
+    for(char c : text)
+    {
+      if(std::isspace(static_cast<unsigned char>(c)))
+      {
+        token_length = 0;
+        continue;
+      }
+      if(0 == token_length++)
+        ++num_of_tokens;
+      longest_token = std::max(longest_token, token_length);
+      has_letters = has_letters || std::isalpha(static_cast<unsigned char>(c));
+    }
+    if(1 == num_of_tokens)
+      num_of_tokens = longest_token;
+    if(81 == num_of_tokens && has_letters)
+      BenchBoardFile<AlphaSudokuBoard>("AlphaSudokuBoard", path, options, results);
+    else if(81 == num_of_tokens)
+      BenchBoardFile<SudokuBoard>("SudokuBoard", path, options, results);
+    else if(256 == num_of_tokens && has_letters)
+      BenchBoardFile<ExtendedAlphaSudokuBoard>("ExtendedAlphaSudokuBoard", path, options, results);
+    else if(256 == num_of_tokens)
+      BenchBoardFile<ExtendedSudokuBoard>("ExtendedSudokuBoard", path, options, results);
+    else if(2 * 81 == num_of_tokens)
+      BenchBoardFile<JigsawBoard>("JigsawBoard", path, options, results);
+    else if(num_of_tokens > 2 * 81 && num_of_tokens <= 3 * 81)
+      BenchBoardFile<KillerBoard>("KillerBoard", path, options, results);
+    else if(369 == num_of_tokens)
+      BenchBoardFile<SamuraiBoard>("SamuraiBoard", path, options, results);
+    else
+      std::cerr << "Skip " << path << ": unknown board type" << std::endl;
+  }
+
+  // false if name is none of the levels, level is then unchanged.
+  bool ParseLevel(const std::string & name, LEVEL & level)
+  {
+    const std::vector<std::pair<std::string, LEVEL>> levels{
+      {"easy", LEVEL::EASY}, {"medium", LEVEL::MEDIUM}, {"hard", LEVEL::HARD},
+      {"samurai", LEVEL::SAMURAI}, {"extreme", LEVEL::EXTREME}};
+    for(const auto & named_level : levels)
+    {
+      if(named_level.first == name)
+      {
+        level = named_level.second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void PrintUsage()
+  {
+    std::cout << "Usage: sudoku_bench [options] board_files..." << std::endl
+              << "  --iterations N            samples per solving case (default 50)" << std::endl
+              << "  --generate-iterations N   samples per generation case (default 3)" << std::endl
+              << "  --time-limit SECONDS      stop sampling a case after that long (default 10)" << std::endl
+              << "  --max-level LEVEL         highest level generated for 9x9 boards (default extreme)" << std::endl
+              << "  --max-extended-level LEVEL  highest level generated for other than 9x9 boards (default easy)" << std::endl
+              << "  LEVEL is one of easy, medium, hard, samurai and extreme" << std::endl
+              << "  --label NAME              label of the run in the csv output" << std::endl
+              << "  --csv PATH                append machine-readable results to PATH" << std::endl
+              << "  --trace PATH              write a Chrome trace of the generation phases to PATH" << std::endl
+              << "                            (built with -D_tracing only)" << std::endl;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  BenchOptions options;
+  for(int i = 1; i < argc; ++i)
+  {
+    std::string arg{argv[i]};
+    bool has_value = (i + 1 < argc);
+    if("--iterations" == arg && has_value)
+      options.iterations = std::max(1, std::atoi(argv[++i]));
+    else if("--generate-iterations" == arg && has_value)
+      options.generate_iterations = std::max(1, std::atoi(argv[++i]));
+    else if("--time-limit" == arg && has_value)
+      options.time_limit_seconds = std::atof(argv[++i]);
+    else if(("--max-level" == arg || "--max-extended-level" == arg) && has_value)
+    {
+      if(!ParseLevel(argv[++i], ("--max-level" == arg) ? options.max_level : options.max_extended_level))
+      {
+        std::cerr << "Unknown level " << argv[i] << std::endl;
+        PrintUsage();
+        return 1;
+      }
+    }
+    else if("--label" == arg && has_value)
+      options.label = argv[++i];
+    else if("--csv" == arg && has_value)
+      options.csv_path = argv[++i];
+    else if("--trace" == arg && has_value)
+    {
+#ifndef _tracing
+      std::cerr << "--trace needs a build with -D_tracing" << std::endl;
+      return 1;
+#endif
+      options.trace_path = argv[++i];
+    }
+    else if("--help" == arg || 0 == arg.compare(0, 2, "--"))
+    {
+      PrintUsage();
+      return ("--help" == arg) ? 0 : 1;
+    }
+    else
+      options.board_files.push_back(arg);
+  }
+
+  std::vector<BenchResult> results;
+  for(const auto & path : options.board_files)
+    BenchBoardFileByContent(path, options, results);
+
+  BenchGeneration<SudokuBoard>("SudokuBoard", options.max_level, options, results);
+  // minimal 9x9 puzzles of any number of givens, and of the low-clue range.
+  results.push_back(Measure("GenerateMinimalBoard", "SudokuBoard", "any", options.generate_iterations,
+                            options.time_limit_seconds,
+                            [&](const std::atomic<bool> * cancelled)
+                            { bench_sink += NumberOfGivens(GenerateMinimalBoard<SudokuBoard>(0, 81, nullptr, cancelled)); }));
+  results.push_back(Measure("GenerateMinimalBoard", "SudokuBoard", "17-22", options.generate_iterations,
+                            options.time_limit_seconds,
+                            [&](const std::atomic<bool> * cancelled)
+                            { bench_sink += NumberOfGivens(GenerateMinimalBoard<SudokuBoard>(17, 22, nullptr, cancelled)); }));
+  if(LEVEL::EXTREME <= options.max_level)
+    results.push_back(Measure("GenerateSolvableBoard", "SudokuBoard", "EXTREME rotational",
+                              options.generate_iterations, options.time_limit_seconds,
+                              [&](const std::atomic<bool> * cancelled)
+                              { bench_sink += GenerateSolvableBoard<SudokuBoard>(LEVEL::EXTREME, 81 / 2.5, nullptr, cancelled,
+                                                    nullptr, 1, Symmetry::rotational)[0][0].isValid(); }));
+  BenchGeneration<AlphaSudokuBoard>("AlphaSudokuBoard", options.max_level, options, results);
+  BenchGeneration<PunctuationSudokuBoard>("PunctuationSudokuBoard", options.max_level, options, results);
+  BenchGeneration<KillerBoard>("KillerBoard", options.max_level, options, results);
+  BenchGeneration<DiagonalSudokuBoard>("DiagonalSudokuBoard", options.max_extended_level, options, results);
+  BenchGeneration<WindokuBoard>("WindokuBoard", options.max_extended_level, options, results);
+  BenchGeneration<JigsawBoard>("JigsawBoard", options.max_extended_level, options, results);
+  BenchGeneration<MiniSudokuBoard>("MiniSudokuBoard", options.max_extended_level, options, results);
+  BenchGeneration<OctoSudokuBoard>("OctoSudokuBoard", options.max_extended_level, options, results);
+  BenchGeneration<DozenSudokuBoard>("DozenSudokuBoard", options.max_extended_level, options, results);
+  BenchGeneration<ExtendedSudokuBoard>("ExtendedSudokuBoard", options.max_extended_level, options, results);
+  BenchGeneration<ExtendedAlphaSudokuBoard>("ExtendedAlphaSudokuBoard", options.max_extended_level, options, results);
+  BenchGeneration<SamuraiBoard>("SamuraiBoard", options.max_extended_level, options, results);
+  // above EASY the giant and colossal boards take minutes, so they stop there as in the daemon.
+  BenchGeneration<GiantSudokuBoard>("GiantSudokuBoard", std::min(options.max_extended_level, LEVEL::EASY),
+                                    options, results);
+  BenchGeneration<ColossalSudokuBoard>("ColossalSudokuBoard", std::min(options.max_extended_level, LEVEL::EASY),
+                                       options, results);
+
+  Report(results, options);
+  if(!options.trace_path.empty() && !wubinboardgames::trace::DumpChromeTrace(options.trace_path))
+    std::cerr << "Cannot write the trace to " << options.trace_path << std::endl;
+  std::cout << "checksum: " << bench_sink << std::endl;
+  return 0;
+}
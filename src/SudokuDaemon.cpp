@@ -0,0 +1,697 @@
+#include <map>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <stdexcept>
+#include <unordered_map>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "Generic/WorkerPool.h"
+#include "Generic/FirstResultRace.h"
+#include "Sudoku/SudokuEngine.h"
+#include "Sudoku/SudokuBoard.h"
+#include "Sudoku/SamuraiBoard.h"
+#include "Sudoku/VariantBoard.h"
+#include "Sudoku/SudokuDaemon.h"
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    namespace
+    {
+      // write end of the pipe waking up the event loop of RunSolverDaemon, -1 when it is not running.
+      std::atomic<int> stop_pipe_fd{-1};
+
+      void HandleStopSignal(int /* signal */)
+      {
+        StopSolverDaemon();
+      }
+
+      // visitor.visit<Board>() with the board type of kind.
+      template<typename Visitor>
+      DaemonResponse VisitBoardKind(BoardKind kind, const Visitor & visitor)
+      {
+        switch(kind)
+        {
+          case BoardKind::regular:
+            return visitor.template visit<SudokuBoard>();
+          case BoardKind::extended:
+            return visitor.template visit<ExtendedSudokuBoard>();
+          case BoardKind::giant:
+            return visitor.template visit<GiantSudokuBoard>();
+          case BoardKind::colossal:
+            return visitor.template visit<ColossalSudokuBoard>();
+          case BoardKind::samurai:
+            return visitor.template visit<SamuraiBoard>();
+          case BoardKind::diagonal:
+            return visitor.template visit<DiagonalSudokuBoard>();
+          case BoardKind::windoku:
+            return visitor.template visit<WindokuBoard>();
+          case BoardKind::mini:
+            return visitor.template visit<MiniSudokuBoard>();
+          case BoardKind::octo:
+            return visitor.template visit<OctoSudokuBoard>();
+          case BoardKind::dozen:
+            return visitor.template visit<DozenSudokuBoard>();
+          case BoardKind::number_of_kinds:
+          default:
+            return visitor.reply(DaemonStatus::bad_request);
+        }
+      }
+
+      struct RequestVisitor
+      {
+        const DaemonRequest & request;
+        GenerationProgress * progress;
+        const std::atomic<bool> * cancelled;
+        SolveBudget budget;
+
+        DaemonResponse reply(DaemonStatus status) const
+        {
+          DaemonResponse response;
+          response.id = request.id;
+          response.status = status;
+          return response;
+        }
+
+        template<typename Board>
+        DaemonResponse visit() const;
+      };
+
+      template<typename Board>
+      DaemonResponse RequestVisitor::visit() const
+      {
+        DaemonResponse response = reply(DaemonStatus::ok);
+        if(DaemonOperation::generate == request.operation)
+        {
+          const unsigned int minimum_empties = Board::width * Board::width / 2.5;
+          BoardToCells(GenerateSolvableBoard<Board>(DAEMON_LEVELS[request.level], minimum_empties, nullptr, cancelled,
+                                                    progress),
+                       response.cells);
+          response.level = request.level;
+          return response;
+        }
+
+        Board board;
+        if(!CellsToBoard(request.cells, board))
+          return reply(DaemonStatus::bad_request);
+        if(!IsBoardValid(board))
+          return reply(DaemonStatus::no_solution);
+        // the budget bounds the search of any board, as odd as it is.
+        const SolveResult<Board> result = SolveWithinBudget<Board>(board, budget, cancelled);
+        switch(result.status)
+        {
+          case SolveStatus::no_solution:
+            return reply(DaemonStatus::no_solution);
+          case SolveStatus::budget_exceeded:
+            return reply(DaemonStatus::over_budget);
+          case SolveStatus::solved:
+            response.status = DaemonStatus::over_budget;
+            break;
+          case SolveStatus::multiple:
+            response.status = DaemonStatus::not_unique;
+            break;
+          case SolveStatus::unique:
+          default:
+            break;
+        }
+        if(DaemonOperation::solve == request.operation)
+          BoardToCells(result.solutions[0], response.cells);
+        else if(DaemonStatus::ok == response.status)
+        {
+          // grading a unique board takes LEVEL::SAMURAI forwards of the row by row search at most.
+          unsigned int num_of_retries = 0;
+          if(!SearchesMostConstrainedCell<Board>())
+            SearchSolution<Board>(board, &num_of_retries, nullptr, std::false_type(), cancelled, 1, LEVEL::SAMURAI);
+          response.level = LevelCode(LevelOfUniqueBoard<Board>(board, num_of_retries));
+        }
+        return response;
+      }
+
+      // ok if request can be answered, the status of the refusal otherwise.
+      DaemonStatus CheckDaemonRequest(const DaemonRequest & request)
+      {
+        // progress is about the whole daemon, whatever the kind.
+        if(DaemonOperation::progress == request.operation)
+          return DaemonStatus::ok;
+        if(request.kind >= BoardKind::number_of_kinds)
+          return DaemonStatus::bad_request;
+        switch(request.operation)
+        {
+          case DaemonOperation::solve:
+          case DaemonOperation::grade:
+            return DaemonStatus::ok;
+          case DaemonOperation::generate:
+            if(request.level >= DAEMON_NUMBER_OF_LEVELS)
+              return DaemonStatus::bad_request;
+            return (DAEMON_LEVELS[request.level] <= MaxGeneratedLevel(request.kind)) ?
+                DaemonStatus::ok : DaemonStatus::unsupported;
+          default:
+            return DaemonStatus::bad_request;
+        }
+      }
+
+      /* PuzzlePools keeps up to pool_size generated puzzles for each kind and level
+         asked for, so that generate requests are answered without waiting for the
+         generator. The workers of the daemon call refillOne() between requests.
+         A request finding its pool empty generates its puzzle itself, racing the
+         refills of that pool: whichever puzzle comes first answers it.
+         stop() cancels every generation, refills and requests alike, so the workers
+         can be joined without waiting for one.
+      */
+      class PuzzlePools
+      {
+      public:
+        PuzzlePools(std::size_t size, GenerationProgress & generation_progress)
+          : pool_size(size), progress(generation_progress) {}
+
+        // start keeping puzzles of kind and level.
+        void open(BoardKind kind, uint8_t level);
+        // a ready puzzle into cells, false if there is none. Opens the pool of kind and level.
+        bool take(BoardKind kind, uint8_t level, std::vector<uint8_t> & cells);
+        // answer a generate request whose pool is empty. False once stopped, with no answer.
+        bool generate(const DaemonRequest & request, DaemonResponse & response);
+        // generate one puzzle for the emptiest pool. False if every pool is full, or once stopped.
+        bool refillOne();
+        void stop();
+
+      private:
+        typedef std::pair<BoardKind, uint8_t> Key;
+        typedef FirstResultRace<std::vector<uint8_t>> PuzzleRace;
+        struct Pool
+        {
+          std::deque<std::vector<uint8_t>> puzzles;
+          // puzzles being generated for the pool.
+          std::size_t num_of_pending = 0;
+          // requests generating their own puzzle, which refills offer theirs to first.
+          std::vector<std::shared_ptr<PuzzleRace>> waiting;
+        };
+
+        const std::size_t pool_size;
+        GenerationProgress & progress;
+        std::atomic<bool> is_stopped{false};
+        std::mutex pools_mutex;
+        std::map<Key, Pool> pools;
+      };
+
+      void PuzzlePools::open(BoardKind kind, uint8_t level)
+      {
+        std::lock_guard<std::mutex> lock(pools_mutex);
+        if(pool_size)
+          pools[Key(kind, level)];
+      }
+
+      bool PuzzlePools::take(BoardKind kind, uint8_t level, std::vector<uint8_t> & cells)
+      {
+        std::lock_guard<std::mutex> lock(pools_mutex);
+        if(0 == pool_size)
+          return false;
+        Pool & pool = pools[Key(kind, level)];
+        if(pool.puzzles.empty())
+          return false;
+        cells.swap(pool.puzzles.front());
+        pool.puzzles.pop_front();
+        return true;
+      }
+
+      bool PuzzlePools::generate(const DaemonRequest & request, DaemonResponse & response)
+      {
+        const std::shared_ptr<PuzzleRace> race = std::make_shared<PuzzleRace>();
+        std::future<std::vector<uint8_t>> puzzle = race->takeFuture();
+        const Key key(request.kind, request.level);
+        {
+          // waiting even without refills, for stop() to cancel it.
+          std::lock_guard<std::mutex> lock(pools_mutex);
+          pools[key].waiting.push_back(race);
+          if(is_stopped)
+            race->cancel();
+        }
+        response = HandleDaemonRequest(request, &progress, &race->stopFlag());
+        // lost if a refill got there first, and then stopped the generation, or if stopped.
+        race->offer(std::move(response.cells));
+        {
+          std::lock_guard<std::mutex> lock(pools_mutex);
+          std::vector<std::shared_ptr<PuzzleRace>> & waiting = pools[key].waiting;
+          waiting.erase(std::find(waiting.begin(), waiting.end(), race));
+        }
+        try
+        {
+          response.cells = puzzle.get();
+        }
+        catch(const std::runtime_error &)
+        {
+          // cancelled by stop().
+          return false;
+        }
+        return true;
+      }
+
+      void PuzzlePools::stop()
+      {
+        std::lock_guard<std::mutex> lock(pools_mutex);
+        is_stopped = true;
+        for(auto & key_pool : pools)
+        {
+          for(const std::shared_ptr<PuzzleRace> & race : key_pool.second.waiting)
+            race->cancel();
+        }
+      }
+
+      bool PuzzlePools::refillOne()
+      {
+        DaemonRequest request;
+        request.operation = DaemonOperation::generate;
+        Pool * emptiest = nullptr;
+        {
+          std::lock_guard<std::mutex> lock(pools_mutex);
+          if(is_stopped)
+            return false;
+          std::size_t min_size = pool_size;
+          for(auto & key_pool : pools)
+          {
+            const std::size_t size = key_pool.second.puzzles.size() + key_pool.second.num_of_pending;
+            if(size < min_size)
+            {
+              min_size = size;
+              request.kind = key_pool.first.first;
+              request.level = key_pool.first.second;
+              emptiest = &key_pool.second;
+            }
+          }
+          if(!emptiest)
+            return false;
+          ++emptiest->num_of_pending;
+        }
+        // pools are never erased, emptiest stays valid.
+        DaemonResponse response = HandleDaemonRequest(request, &progress, &is_stopped);
+        std::lock_guard<std::mutex> lock(pools_mutex);
+        --emptiest->num_of_pending;
+        // the puzzle of a cancelled generation is meaningless.
+        if(is_stopped)
+          return false;
+        for(const std::shared_ptr<PuzzleRace> & race : emptiest->waiting)
+        {
+          if(race->offer(response.cells))
+            return true;
+        }
+        emptiest->puzzles.push_back(std::move(response.cells));
+        return true;
+      }
+
+      struct Connection
+      {
+        explicit Connection(int socket_fd) : fd(socket_fd) {}
+        ~Connection()
+        {
+          close(fd);
+        }
+        Connection(const Connection &) = delete;
+        Connection & operator=(const Connection &) = delete;
+
+        const int fd;
+        // bytes of frames not read in full yet. Event loop only.
+        std::vector<uint8_t> read_buffer;
+        // one batch writes to the connection at a time.
+        std::mutex write_mutex;
+      };
+
+      // held by the queued requests, so the socket outlives the client hanging up.
+      typedef std::shared_ptr<Connection> ConnectionPointer;
+
+      struct DaemonJob
+      {
+        ConnectionPointer connection;
+        DaemonRequest request;
+        // a generate request which found its pool empty, queued again to be generated on its own.
+        bool is_pool_miss = false;
+      };
+
+      bool SendAll(int fd, const uint8_t * data, std::size_t length)
+      {
+        while(length)
+        {
+          // MSG_NOSIGNAL: a client gone is an error here, not a SIGPIPE.
+          const ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+          if(sent < 0 && EINTR == errno)
+            continue;
+          if(sent <= 0)
+            return false;
+          data += sent;
+          length -= static_cast<std::size_t>(sent);
+        }
+        return true;
+      }
+
+      /* Write frames to connection. A client not reading its replies times out the
+         send (see DaemonOptions::send_timeout) and is hung up on, as a frame may have
+         been cut. The event loop then drops the connection.
+      */
+      void SendReplies(Connection & connection, const std::vector<uint8_t> & frames)
+      {
+        std::lock_guard<std::mutex> lock(connection.write_mutex);
+        if(!SendAll(connection.fd, frames.data(), frames.size()))
+          shutdown(connection.fd, SHUT_RDWR);
+      }
+
+      /* Answer a batch of requests. Requests of the batch asking the same board are
+         solved or graded once. Generated puzzles come from the pools when they have
+         some. The responses to each connection go in a single write.
+         A generate request finding its pool empty could take seconds, so it does not
+         hold the other replies: it is queued again as a job of its own, and generated
+         once the replies of the batch it then comes in are sent.
+      */
+      void AnswerBatch(std::vector<DaemonJob> & batch, PuzzlePools & pools, GenerationProgress & progress,
+                       WorkerPool<DaemonJob> & workers, const DaemonOptions & options)
+      {
+        std::unordered_map<std::string, DaemonResponse> answered;
+        std::vector<std::pair<Connection *, std::vector<uint8_t>>> replies;
+        std::vector<const DaemonJob *> pool_misses;
+        bool has_taken_puzzles = false;
+        for(DaemonJob & job : batch)
+        {
+          const DaemonRequest & request = job.request;
+          DaemonResponse response;
+          response.id = request.id;
+          response.status = CheckDaemonRequest(request);
+          if(DaemonStatus::ok == response.status && DaemonOperation::generate == request.operation)
+          {
+            if(pools.take(request.kind, request.level, response.cells))
+            {
+              response.level = request.level;
+              has_taken_puzzles = true;
+            }
+            else
+            {
+              if(job.is_pool_miss)
+                pool_misses.push_back(&job);
+              else
+              {
+                job.is_pool_miss = true;
+                workers.submit(std::move(job));
+              }
+              continue;
+            }
+          }
+          else if(DaemonStatus::ok == response.status && DaemonOperation::progress == request.operation)
+            response = HandleDaemonRequest(request, &progress);
+          else if(DaemonStatus::ok == response.status)
+          {
+            std::string key(1, static_cast<char>(request.operation));
+            key += static_cast<char>(request.kind);
+            key.append(request.cells.begin(), request.cells.end());
+            auto found = answered.find(key);
+            if(found == answered.end())
+              found = answered.emplace(key, HandleDaemonRequest(request, nullptr, nullptr,
+                                                                SolveBudget::within(options.solve_timeout,
+                                                                                    options.solve_node_budget))).first;
+            response = found->second;
+            response.id = request.id;
+          }
+
+          Connection * connection = job.connection.get();
+          auto reply = std::find_if(replies.begin(), replies.end(),
+                                    [connection](const std::pair<Connection *, std::vector<uint8_t>> & pending)
+                                    {
+                                      return pending.first == connection;
+                                    });
+          if(reply == replies.end())
+            reply = replies.insert(replies.end(), std::make_pair(connection, std::vector<uint8_t>()));
+          EncodeResponse(response, reply->second);
+        }
+        if(has_taken_puzzles)
+          workers.wakeUp();
+        for(auto & reply : replies)
+          SendReplies(*reply.first, reply.second);
+        for(const DaemonJob * job : pool_misses)
+        {
+          DaemonResponse response;
+          if(!pools.generate(job->request, response))
+            continue;
+          std::vector<uint8_t> frame;
+          EncodeResponse(response, frame);
+          SendReplies(*job->connection, frame);
+        }
+      }
+
+      // queue the whole frames of connection's read buffer. False if the client sent garbage.
+      bool SubmitFrames(const ConnectionPointer & connection, WorkerPool<DaemonJob> & workers)
+      {
+        std::vector<uint8_t> & buffer = connection->read_buffer;
+        std::size_t offset = 0;
+        std::size_t length = 0;
+        while(0 < (length = FrameLength(buffer.data() + offset, buffer.size() - offset)))
+        {
+          DaemonJob job;
+          job.connection = connection;
+          if(length - 4 > DAEMON_MAX_FRAME_LENGTH || !DecodeRequest(buffer.data() + offset, length, job.request))
+            return false;
+          workers.submit(std::move(job));
+          offset += length;
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+        return true;
+      }
+
+      bool SocketAddress(const std::string & path, sockaddr_un & address)
+      {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if(path.empty() || path.size() >= sizeof(address.sun_path))
+          return false;
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+        return true;
+      }
+    }
+
+    LEVEL MaxGeneratedLevel(BoardKind kind)
+    {
+      switch(kind)
+      {
+        case BoardKind::regular:
+          return LEVEL::EXTREME;
+        case BoardKind::diagonal:
+        case BoardKind::windoku:
+        case BoardKind::mini:
+        case BoardKind::octo:
+          return LEVEL::HARD;
+        case BoardKind::extended:
+        case BoardKind::samurai:
+        case BoardKind::dozen:
+          return LEVEL::MEDIUM;
+        case BoardKind::giant:
+        case BoardKind::colossal:
+          return LEVEL::EASY;
+        case BoardKind::number_of_kinds:
+        default:
+          return LEVEL::NO_SOLUTION;
+      }
+    }
+
+    DaemonResponse HandleDaemonRequest(const DaemonRequest & request, GenerationProgress * progress,
+                                       const std::atomic<bool> * cancelled, const SolveBudget & budget)
+    {
+      const RequestVisitor visitor{request, progress, cancelled, budget};
+      const DaemonStatus status = CheckDaemonRequest(request);
+      if(DaemonStatus::ok != status)
+        return visitor.reply(status);
+      if(DaemonOperation::progress == request.operation)
+      {
+        if(!progress)
+          return visitor.reply(DaemonStatus::unsupported);
+        DaemonResponse response = visitor.reply(DaemonStatus::ok);
+        EncodeProgress(*progress, response.cells);
+        return response;
+      }
+      return VisitBoardKind(request.kind, visitor);
+    }
+
+    bool RunSolverDaemon(const DaemonOptions & options)
+    {
+      sockaddr_un address;
+      if(!SocketAddress(options.socket_path, address))
+        return false;
+      const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      if(listener < 0)
+        return false;
+      // a socket file left by a daemon that did not stop cleanly.
+      unlink(options.socket_path.c_str());
+      int stop_pipe[2];
+      if(bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 ||
+         listen(listener, SOMAXCONN) < 0 || pipe(stop_pipe) < 0)
+      {
+        close(listener);
+        return false;
+      }
+      stop_pipe_fd = stop_pipe[1];
+      struct sigaction stop_action;
+      struct sigaction old_int_action;
+      struct sigaction old_term_action;
+      std::memset(&stop_action, 0, sizeof(stop_action));
+      stop_action.sa_handler = HandleStopSignal;
+      sigemptyset(&stop_action.sa_mask);
+      sigaction(SIGINT, &stop_action, &old_int_action);
+      sigaction(SIGTERM, &stop_action, &old_term_action);
+
+      {
+        // of every generation of the daemon, pools and requests alike.
+        GenerationProgress progress;
+        PuzzlePools pools(options.pool_size, progress);
+        for(uint8_t level = 0; DAEMON_LEVELS[level] <= LEVEL::HARD; ++level)
+          pools.open(BoardKind::regular, level);
+        WorkerPool<DaemonJob> * worker_pool = nullptr;
+        WorkerPool<DaemonJob> workers(options.num_of_workers, options.max_batch,
+                                      [&pools, &progress, &worker_pool, &options](std::vector<DaemonJob> & batch)
+                                      {
+                                        AnswerBatch(batch, pools, progress, *worker_pool, options);
+                                      },
+                                      [&pools]
+                                      {
+                                        return pools.refillOne();
+                                      });
+        // set before the first request is submitted, under the lock of the queue.
+        worker_pool = &workers;
+
+        std::vector<ConnectionPointer> connections;
+        std::vector<pollfd> poll_fds;
+        std::vector<uint8_t> buffer(DAEMON_MAX_FRAME_LENGTH);
+        while(true)
+        {
+          poll_fds.clear();
+          poll_fds.push_back(pollfd{stop_pipe[0], POLLIN, 0});
+          poll_fds.push_back(pollfd{listener, POLLIN, 0});
+          for(const auto & connection : connections)
+            poll_fds.push_back(pollfd{connection->fd, POLLIN, 0});
+          if(poll(poll_fds.data(), poll_fds.size(), -1) < 0)
+          {
+            if(EINTR == errno)
+              continue;
+            break;
+          }
+          if(poll_fds[0].revents)
+            break;
+
+          // connections first: the indexes of poll_fds follow them.
+          for(std::size_t n = connections.size(); n-- > 0;)
+          {
+            if(!poll_fds[n + 2].revents)
+              continue;
+            const ssize_t length = recv(connections[n]->fd, buffer.data(), buffer.size(), 0);
+            if(length < 0 && EINTR == errno)
+              continue;
+            bool is_open = length > 0;
+            if(is_open)
+            {
+              std::vector<uint8_t> & read_buffer = connections[n]->read_buffer;
+              read_buffer.insert(read_buffer.end(), buffer.begin(), buffer.begin() + length);
+              is_open = SubmitFrames(connections[n], workers);
+            }
+            if(!is_open)
+            {
+              shutdown(connections[n]->fd, SHUT_RDWR);
+              connections.erase(connections.begin() + static_cast<std::ptrdiff_t>(n));
+            }
+          }
+          if(poll_fds[1].revents & POLLIN)
+          {
+            const int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if(fd >= 0)
+            {
+              timeval send_timeout;
+              send_timeout.tv_sec = static_cast<time_t>(options.send_timeout.count() / 1000);
+              send_timeout.tv_usec = static_cast<suseconds_t>(options.send_timeout.count() % 1000 * 1000);
+              setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+              connections.push_back(std::make_shared<Connection>(fd));
+            }
+          }
+        }
+        // the workers are joined next, none of them must be stuck in a generation.
+        pools.stop();
+      }
+
+      sigaction(SIGINT, &old_int_action, nullptr);
+      sigaction(SIGTERM, &old_term_action, nullptr);
+      stop_pipe_fd = -1;
+      close(stop_pipe[0]);
+      close(stop_pipe[1]);
+      close(listener);
+      unlink(options.socket_path.c_str());
+      return true;
+    }
+
+    void StopSolverDaemon()
+    {
+      const int fd = stop_pipe_fd;
+      if(fd >= 0)
+      {
+        const char stop = 1;
+        // nothing to do if the pipe is full: the loop is stopping anyway.
+        ssize_t written = write(fd, &stop, 1);
+        (void)written;
+      }
+    }
+
+    bool SendDaemonRequests(const std::string & path, const std::vector<DaemonRequest> & requests,
+                            std::vector<DaemonResponse> & responses)
+    {
+      sockaddr_un address;
+      if(!SocketAddress(path, address))
+        return false;
+      const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      if(fd < 0)
+        return false;
+      std::vector<uint8_t> frames;
+      std::unordered_map<uint32_t, std::size_t> index_of_id;
+      for(std::size_t n = 0; n < requests.size(); ++n)
+      {
+        EncodeRequest(requests[n], frames);
+        index_of_id[requests[n].id] = n;
+      }
+      bool is_done = connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0 &&
+                     SendAll(fd, frames.data(), frames.size());
+
+      responses.assign(requests.size(), DaemonResponse());
+      std::size_t num_of_responses = 0;
+      std::vector<uint8_t> received;
+      uint8_t buffer[4096];
+      while(is_done && num_of_responses < requests.size())
+      {
+        const ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+        if(length < 0 && EINTR == errno)
+          continue;
+        if(length <= 0)
+        {
+          is_done = false;
+          break;
+        }
+        received.insert(received.end(), buffer, buffer + length);
+        std::size_t offset = 0;
+        std::size_t frame_length = 0;
+        while(is_done && 0 < (frame_length = FrameLength(received.data() + offset, received.size() - offset)))
+        {
+          DaemonResponse response;
+          is_done = DecodeResponse(received.data() + offset, frame_length, response) &&
+                    index_of_id.count(response.id);
+          if(is_done)
+          {
+            responses[index_of_id[response.id]] = std::move(response);
+            ++num_of_responses;
+          }
+          offset += frame_length;
+        }
+        received.erase(received.begin(), received.begin() + static_cast<std::ptrdiff_t>(offset));
+      }
+      close(fd);
+      return is_done;
+    }
+  }
+}
@@ -2,7 +2,12 @@
 
 #include "Sudoku/SudokuEngine.h"
 #include "Sudoku/SudokuBoard.h"
+#include "Sudoku/SamuraiBoard.h"
+#include "Sudoku/KillerEngine.h"
+#include "Sudoku/JigsawEngine.h"
+#include "Sudoku/VariantBoard.h"
 #include "Sudoku/SudokuGame.h"
+#include "Sudoku/SudokuDaemon.h"
 
 using namespace wubinboardgames::sudoku;
 
@@ -21,9 +26,19 @@ namespace wubinboardgames
         std::cout << "\033[1;33m0. Regular Sudoku 9x9 \033[0m" << std::endl << std::endl;
         std::cout << "\033[1;33m1. Alphabet Sudoku 9x9 \033[0m" << std::endl << std::endl;
         std::cout << "\033[1;33m2. Extended Sudoku 16x16 \033[0m" << std::endl << std::endl;
-        std::cout << "\033[1;33m3. Exit \033[0m" << std::endl <<std::endl;
+        std::cout << "\033[1;33m3. Giant Sudoku 25x25 \033[0m" << std::endl << std::endl;
+        std::cout << "\033[1;33m4. Colossal Sudoku 36x36 \033[0m" << std::endl << std::endl;
+        std::cout << "\033[1;33m5. Samurai Sudoku 21x21 (five grids) \033[0m" << std::endl << std::endl;
+        std::cout << "\033[1;33m6. Killer Sudoku 9x9 \033[0m" << std::endl << std::endl;
+        std::cout << "\033[1;33m7. X Sudoku 9x9 (diagonals) \033[0m" << std::endl << std::endl;
+        std::cout << "\033[1;33m8. Windoku 9x9 (four extra boxes) \033[0m" << std::endl << std::endl;
+        std::cout << "\033[1;33m9. Jigsaw Sudoku 9x9 \033[0m" << std::endl << std::endl;
+        std::cout << "\033[1;33m10. Mini Sudoku 6x6 (2x3 boxes) \033[0m" << std::endl << std::endl;
+        std::cout << "\033[1;33m11. Octo Sudoku 8x8 (2x4 boxes) \033[0m" << std::endl << std::endl;
+        std::cout << "\033[1;33m12. Dozen Sudoku 12x12 (3x4 boxes) \033[0m" << std::endl << std::endl;
+        std::cout << "\033[1;33m13. Exit \033[0m" << std::endl <<std::endl;
 
-        while(option > 3)
+        while(option > 13)
         {
           std::cout << "\033[1;32mPlease Select A Valid Option: \033[0m" << std::endl << std::endl;
           std::cin.clear();
@@ -42,6 +57,37 @@ namespace wubinboardgames
             PlaySudokuGame<ExtendedSudokuBoard>("ExtendedSudoku");
             break;
           case 3:
+            // the levels the daemon generates: higher ones do not finish in time.
+            PlaySudokuGame<GiantSudokuBoard>("Giant Sudoku", MaxGeneratedLevel(BoardKind::giant));
+            break;
+          case 4:
+            PlaySudokuGame<ColossalSudokuBoard>("Colossal Sudoku", MaxGeneratedLevel(BoardKind::colossal));
+            break;
+          case 5:
+            PlaySudokuGame<SamuraiBoard>("Samurai Sudoku");
+            break;
+          case 6:
+            PlaySudokuGame<KillerBoard>("Killer Sudoku");
+            break;
+          case 7:
+            PlaySudokuGame<DiagonalSudokuBoard>("X Sudoku");
+            break;
+          case 8:
+            PlaySudokuGame<WindokuBoard>("Windoku");
+            break;
+          case 9:
+            PlaySudokuGame<JigsawBoard>("Jigsaw Sudoku");
+            break;
+          case 10:
+            PlaySudokuGame<MiniSudokuBoard>("Mini Sudoku");
+            break;
+          case 11:
+            PlaySudokuGame<OctoSudokuBoard>("Octo Sudoku");
+            break;
+          case 12:
+            PlaySudokuGame<DozenSudokuBoard>("Dozen Sudoku");
+            break;
+          case 13:
           default:
             return;
         }
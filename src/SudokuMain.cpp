@@ -1,9 +1,46 @@
+#include <string>
+#include <cstdlib>
+
 #include "Sudoku/SudokuEngine.h"
 #include "Sudoku/SudokuBoard.h"
 #include "Sudoku/SudokuGame.h"
+#include "Sudoku/SudokuDaemon.h"
 
 using namespace wubinboardgames::sudoku;
 
+// sudoku_Linux --daemon SOCKET [--workers N] [--batch N] [--pool-size N] [--solve-timeout MS] [--solve-nodes N]
+static int RunDaemonFromArguments(int argc, char ** argv)
+{
+  DaemonOptions options;
+  options.socket_path = argv[2];
+  for(int n = 3; n + 1 < argc; n += 2)
+  {
+    const std::string option = argv[n];
+    const unsigned long value = std::strtoul(argv[n + 1], nullptr, 10);
+    if("--workers" == option)
+      options.num_of_workers = static_cast<unsigned int>(value);
+    else if("--batch" == option)
+      options.max_batch = value;
+    else if("--pool-size" == option)
+      options.pool_size = value;
+    else if("--solve-timeout" == option)
+      options.solve_timeout = std::chrono::milliseconds(value);
+    else if("--solve-nodes" == option)
+      options.solve_node_budget = value;
+    else
+    {
+      std::cerr << "unknown option " << option << std::endl;
+      return 1;
+    }
+  }
+  if(!RunSolverDaemon(options))
+  {
+    std::cerr << "cannot listen on " << options.socket_path << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
 int main(int argc, char ** argv)
 {
 
@@ -11,7 +48,9 @@ int main(int argc, char ** argv)
     SudokuBoard board;
     GenerateNewGame<SudokuBoard>(board);
 #else
+    if(argc > 2 && std::string("--daemon") == argv[1])
+      return RunDaemonFromArguments(argc, argv);
     DisplayOptionsMenu();
 #endif
     return 0;
-}
\ No newline at end of file
+}
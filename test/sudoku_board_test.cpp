@@ -2,6 +2,10 @@
 
 #include "gtest/gtest.h"
 #include "Sudoku/SudokuBoard.h"
+#include "Sudoku/SamuraiBoard.h"
+#include "Sudoku/KillerBoard.h"
+#include "Sudoku/JigsawBoard.h"
+#include "Sudoku/VariantBoard.h"
 
 
 namespace wubinboardgames
@@ -21,6 +25,28 @@ namespace wubinboardgames
         }
       }
     }
+    TEST(SudokuBoardUnitTest, rectangular_boxes)
+    {
+      ASSERT_TRUE(MiniSudokuBoard::box_height == 2);
+      ASSERT_TRUE(MiniSudokuBoard::box_width == 3);
+      ASSERT_TRUE(DozenSudokuBoard::box_height == 3);
+      ASSERT_TRUE(DozenSudokuBoard::box_width == 4);
+      // a 2x3 box of a 6x6 board: (0, 0) to (1, 2).
+      const RegionLayout & layout = MiniSudokuBoard{}.layout();
+      ASSERT_EQ(layout.numberOfUnits(), 18u);
+      ASSERT_EQ(layout.unitSize(12), 6u);
+      ASSERT_EQ(layout.unitCells(12)[5], 1u * 6 + 2);
+      // 5 in the row, 5 in the column, 2 more in the box.
+      ASSERT_EQ(layout.numberOfPeers(0), 12u);
+
+      MiniSudokuBoard board;
+      board.assign(5, 5, 6);
+      std::stringstream ss;
+      ss << board;
+      MiniSudokuBoard another_board;
+      ss >> another_board;
+      ASSERT_EQ(board, another_board);
+    }
     TEST(SudokuBoardUnitTest, assignment)
     {
       SudokuBoard board;
@@ -94,14 +120,304 @@ namespace wubinboardgames
       {
         for(unsigned int col = 0; col < 9; ++col)
         {
-          board[row][col] = row ^ col;
+          board[row][col] = (row ^ col) % 10;
+        }
+      }
+      board.writeToFile("Gtest_board");
+      SudokuBoard another_board;
+      ASSERT_TRUE(another_board.loadFromFile("Gtest_board"));
+      std::remove("Gtest_board");
+      ASSERT_EQ(board, another_board);
+    }
+    TEST(SudokuBoardUnitTest, parse_formats)
+    {
+      const std::string one_line =
+          "53..7....6..195....98....6.8...6...34..8.3..17...2...6.6....28....419..5....8..79";
+      SudokuBoard board;
+      ASSERT_TRUE(ParseBoardText(one_line.data(), one_line.data() + one_line.size(), board));
+      ASSERT_EQ(static_cast<unsigned int>(board[0][0]), 5u);
+      ASSERT_TRUE(board[0][2].isVacant());
+      ASSERT_EQ(static_cast<unsigned int>(board[8][8]), 9u);
+      ASSERT_EQ(board.hash(), board.rehash());
+      // the same board in the .board format.
+      std::stringstream ss;
+      ss << board;
+      SudokuBoard another_board;
+      ss >> another_board;
+      ASSERT_FALSE(ss.fail());
+      ASSERT_EQ(board, another_board);
+
+      // letters are 1 to 9 on alphabet boards, and read the same into numeric cells.
+      std::string alphabet(one_line);
+      for(char & c : alphabet)
+        c = ('.' == c) ? '0' : static_cast<char>('a' + (c - '1'));
+      AlphaSudokuBoard alpha_board;
+      ASSERT_TRUE(ParseBoardText(alphabet.data(), alphabet.data() + alphabet.size(), alpha_board));
+      ASSERT_TRUE(alpha_board[0][0] == 'e');
+      ASSERT_TRUE(ParseBoardText(alphabet.data(), alphabet.data() + alphabet.size(), another_board));
+      ASSERT_EQ(board, another_board);
+
+      // a 16x16 board on one line, letters going on after 9.
+      std::string extended(256, '.');
+      extended[0] = '1';
+      extended[1] = 'A';
+      extended[255] = 'g';
+      ExtendedSudokuBoard extended_board;
+      ASSERT_TRUE(ParseBoardText(extended.data(), extended.data() + extended.size(), extended_board));
+      ASSERT_EQ(static_cast<unsigned int>(extended_board[0][1]), 10u);
+      ASSERT_EQ(static_cast<unsigned int>(extended_board[15][15]), 16u);
+    }
+    TEST(SudokuBoardUnitTest, format_board)
+    {
+      const std::string one_line =
+          "53..7....6..195....98....6.8...6...34..8.3..17...2...6.6....28....419..5....8..79";
+      SudokuBoard board;
+      ASSERT_TRUE(ParseBoardText(one_line.data(), one_line.data() + one_line.size(), board));
+      char text[MaxFormattedLength<SudokuBoard>(BoardFormat::grid)];
+      std::size_t length = FormatBoard(board, BoardFormat::one_line, text, sizeof(text));
+      ASSERT_EQ(std::string(text, length), one_line + "\n");
+      length = FormatBoard(board, BoardFormat::csv, text, sizeof(text));
+      ASSERT_EQ(std::string(text, 18), "5,3,0,0,7,0,0,0,0,");
+      ASSERT_EQ(text[length - 1], '\n');
+      length = FormatBoard(board, BoardFormat::grid, text, sizeof(text));
+      ASSERT_EQ(std::string(text, 31), " 5  3  0   0  7  0   0  0  0\n 6");
+      ASSERT_EQ(FormatBoard(board, BoardFormat::grid, text, 100), 0u);
+
+      // every format reads back, one board after the other.
+      BoardBatchWriter writer(0);
+      writer.add(board, BoardFormat::grid);
+      writer.add(board, BoardFormat::one_line);
+      writer.add(board, BoardFormat::csv);
+      ExtendedSudokuBoard extended_board;
+      extended_board.assign(15, 15, 16);
+      writer.add(extended_board, BoardFormat::one_line);
+      ASSERT_TRUE(writer.writeToFile("Gtest_board"));
+      ASSERT_EQ(writer.size(), 0u);
+      std::string file_text;
+      ASSERT_TRUE(ReadTextFile("Gtest_board", file_text));
+      std::remove("Gtest_board");
+      BoardTextReader reader(file_text);
+      for(unsigned int format = 0; format < 3; ++format)
+      {
+        SudokuBoard another_board;
+        ASSERT_TRUE(another_board.parse(reader)) << reader.error();
+        ASSERT_EQ(board, another_board);
+      }
+      ExtendedSudokuBoard another_extended_board;
+      ASSERT_TRUE(another_extended_board.parse(reader)) << reader.error();
+      ASSERT_EQ(extended_board, another_extended_board);
+      ASSERT_TRUE(reader.atEnd());
+    }
+    TEST(SudokuBoardUnitTest, parse_errors)
+    {
+      SudokuBoard board;
+      board.assign(0, 0, 1);
+      std::string error;
+      const std::string short_board = "1 2 3\n4 5 6\n";
+      ASSERT_FALSE(ParseBoardText(short_board.data(), short_board.data() + short_board.size(), board, &error));
+      ASSERT_EQ(error, "line 3, column 1: expected 81 cells, found 6");
+      // unchanged on failure.
+      ASSERT_EQ(static_cast<unsigned int>(board[0][0]), 1u);
+
+      std::string bad_cell(81, '0');
+      bad_cell[9 + 4] = '?';
+      bad_cell.insert(9, "\n");
+      BoardTextReader reader(bad_cell);
+      uint8_t digits[81];
+      ASSERT_FALSE(reader.readCells(9, digits, 81));
+      ASSERT_EQ(reader.errorLine(), 2u);
+      ASSERT_EQ(reader.errorColumn(), 5u);
+
+      ExtendedSudokuBoard extended_board;
+      std::stringstream ss;
+      ss << extended_board;
+      std::string extended = ss.str();
+      extended.replace(extended.find('0'), 1, "17");
+      ASSERT_FALSE(ParseBoardText(extended.data(), extended.data() + extended.size(), extended_board, &error));
+      ASSERT_EQ(error, "line 1, column 2: cell value out of range 0 to 16");
+
+      std::string trailing(81, '0');
+      trailing += " 5";
+      ASSERT_FALSE(ParseBoardText(trailing.data(), trailing.data() + trailing.size(), board, &error));
+      ASSERT_EQ(error, "line 1, column 83: unexpected text after the board");
+      ASSERT_EQ(static_cast<unsigned int>(board[0][0]), 1u);
+      ASSERT_FALSE(board.loadFromFile("no_such.board"));
+    }
+    TEST(SudokuBoardUnitTest, stream_of_boards)
+    {
+      SudokuBoard first, second;
+      first.assign(0, 0, 1);
+      second.assign(8, 8, 9);
+      std::stringstream ss;
+      // a grid board, then a one-line board.
+      ss << first << "\n" << std::string(80, '.') << "9\n";
+      SudokuBoard board;
+      ASSERT_TRUE(ss >> board);
+      ASSERT_EQ(board, first);
+      ASSERT_TRUE(ss >> board);
+      ASSERT_EQ(board, second);
+      ASSERT_FALSE(ss >> board);
+      ASSERT_EQ(board, second);
+
+      // text after a board on its last line fails, and leaves the board unchanged.
+      std::stringstream trailing(std::string(81, '0') + " 5\n");
+      ASSERT_FALSE(trailing >> board);
+      ASSERT_EQ(board, second);
+    }
+    TEST(SudokuBoardUnitTest, zobrist_hash)
+    {
+      SudokuBoard board;
+      ASSERT_EQ(board.hash(), 0u);
+      board.assign(0, 0, 5);
+      board.assign(4, 7, 2);
+      uint64_t incremental = board.hash();
+      ASSERT_NE(incremental, 0u);
+      ASSERT_EQ(incremental, board.rehash());
+      // overwriting a value XORs the old key out
+      board.assign(4, 7, 3);
+      ASSERT_NE(board.hash(), incremental);
+      ASSERT_EQ(board.hash(), board.rehash());
+      board.assign(4, 7, 2);
+      ASSERT_EQ(board.hash(), incremental);
+      board.backup();
+      board.vacate(0, 0);
+      ASSERT_EQ(board.hash(), board.rehash());
+      board.reset();
+      ASSERT_EQ(board.hash(), incremental);
+      board.clear();
+      ASSERT_EQ(board.hash(), 0u);
+    }
+    TEST(SudokuBoardUnitTest, zobrist_hash_after_loading)
+    {
+      SudokuBoard board;
+      for(unsigned int row = 0; row < 9; ++row)
+      {
+        for(unsigned int col = 0; col < 9; ++col)
+        {
+          board.assign(row, col, (row * 3 + row / 3 + col) % 9 + 1);
         }
       }
       board.writeToFile("Gtest_board");
       SudokuBoard another_board;
       another_board.loadFromFile("Gtest_board");
       std::remove("Gtest_board");
+      ASSERT_EQ(board.hash(), another_board.hash());
+    }
+    TEST(SudokuBoardUnitTest, samurai_layout)
+    {
+      SamuraiBoard board;
+      const RegionLayout & layout = board.layout();
+      // 5 grids of 27 units, 4 boxes shared by two grids.
+      ASSERT_EQ(layout.numberOfUnits(), 131u);
+      ASSERT_EQ(layout.numberOfActiveCells(), 369u);
+      ASSERT_FALSE(layout.isActive(9));
+      ASSERT_TRUE(layout.isActive(6 * 21 + 6));
+      // a cell of a shared box sees two rows, two columns and its box.
+      ASSERT_EQ(layout.unitsPerCell(), 5u);
+      ASSERT_EQ(layout.numberOfPeers(6 * 21 + 6), 32u);
+      ASSERT_EQ(layout.numberOfPeers(0), 20u);
+      ASSERT_EQ(layout.numberOfPeers(9), 0u);
+    }
+    TEST(SudokuBoardUnitTest, samurai_write_and_read)
+    {
+      SamuraiBoard board;
+      for(unsigned int grid = 0; grid < SamuraiBoard::number_of_grids; ++grid)
+      {
+        board.assign(SamuraiBoard::gridRow(grid), SamuraiBoard::gridCol(grid) + 1, grid + 1);
+      }
+      board.writeToFile("Gtest_board");
+      SamuraiBoard another_board;
+      another_board.loadFromFile("Gtest_board");
+      std::remove("Gtest_board");
+      ASSERT_EQ(board, another_board);
+      ASSERT_EQ(board.hash(), another_board.hash());
+      ASSERT_EQ(static_cast<unsigned int>(another_board.subBoard(2)[0][1]), 3u);
+    }
+    TEST(SudokuBoardUnitTest, cage_combinations)
+    {
+      // digits 1 to 9 as bits 0 to 8.
+      ASSERT_EQ(CageCombinations(2, 3), 0x3u);
+      ASSERT_EQ(CageCombinations(3, 6), 0x7u);
+      ASSERT_EQ(CageCombinations(2, 10), 0x1efu);
+      ASSERT_EQ(CageCombinations(4, 30), 0x1e0u);
+      ASSERT_EQ(CageCombinations(9, 45), 0x1ffu);
+      ASSERT_EQ(CageCombinations(2, 18), 0u);
+      ASSERT_EQ(CageCombinations(10, 45), 0u);
+      ASSERT_EQ(CageCombinations(1, -1), 0u);
+    }
+    TEST(SudokuBoardUnitTest, killer_write_and_read)
+    {
+      KillerBoard board;
+      board.assign(0, 0, 3);
+      ASSERT_TRUE(board.setCages({{3, {0, 1}}, {17, {80, 79}}}));
+      // two units with a sum on top of the 27 of the grid.
+      ASSERT_EQ(board.layout().numberOfUnits(), 29u);
+      ASSERT_EQ(board.layout().unitSum(board.layout().sumUnitOf(79)), 17u);
+      ASSERT_TRUE(RegionLayout::no_sum == board.layout().sumUnitOf(2));
+      // a cell in two cages, and a sum two cells cannot make.
+      ASSERT_FALSE(board.setCages({{3, {0, 1}}, {10, {1, 2}}}));
+      ASSERT_FALSE(board.setCages({{18, {0, 1}}}));
+      ASSERT_EQ(board.cages().size(), 2u);
+
+      board.writeToFile("Gtest_board");
+      KillerBoard another_board;
+      ASSERT_TRUE(another_board.loadFromFile("Gtest_board"));
+      std::remove("Gtest_board");
+      ASSERT_EQ(board, another_board);
+      ASSERT_EQ(another_board.cages().size(), 2u);
+      ASSERT_EQ(another_board.cages()[1].sum, 17u);
+      ASSERT_EQ(another_board.cages()[1].cells, std::vector<unsigned int>({79, 80}));
+
+      // two cells cannot add up to 18.
+      std::stringstream ss;
+      ss << board;
+      std::string text = ss.str();
+      text.replace(text.rfind("17"), 2, "18");
+      std::string error;
+      ASSERT_FALSE(ParseBoardText(text.data(), text.data() + text.size(), another_board, &error));
+      ASSERT_NE(error.find("no distinct digits"), std::string::npos);
+      ASSERT_EQ(another_board.cages()[1].sum, 17u);
+    }
+    TEST(SudokuBoardUnitTest, variant_layouts)
+    {
+      // 27 units and two diagonals. The center cell is on both, which add 16 cells
+      // minus the 4 in its box.
+      const RegionLayout & diagonal_layout = DiagonalSudokuBoard{}.layout();
+      ASSERT_EQ(diagonal_layout.numberOfUnits(), 29u);
+      ASSERT_EQ(diagonal_layout.numberOfPeers(4 * 9 + 4), 20u + 12u);
+      ASSERT_EQ(diagonal_layout.numberOfPeers(0), 20u + 6u);
+      // 27 units and four windows. The first window adds (2, 3), (3, 2) and (3, 3)
+      // to the peers of (1, 1).
+      const RegionLayout & windoku_layout = WindokuBoard{}.layout();
+      ASSERT_EQ(windoku_layout.numberOfUnits(), 31u);
+      ASSERT_EQ(windoku_layout.numberOfPeers(1 * 9 + 1), 20u + 3u);
+      ASSERT_EQ(windoku_layout.numberOfPeers(0), 20u);
+    }
+    TEST(SudokuBoardUnitTest, jigsaw_write_and_read)
+    {
+      JigsawBoard board;
+      // square boxes until new regions are set.
+      ASSERT_EQ(board.layout().numberOfPeers(0), 20u);
+      std::vector<std::vector<unsigned int>> regions(board.regions());
+      // exchange (2, 2) of the first box and (2, 3) of the second one.
+      std::replace(regions[0].begin(), regions[0].end(), 2u * 9 + 2, 2u * 9 + 3);
+      std::replace(regions[1].begin(), regions[1].end(), 2u * 9 + 3, 2u * 9 + 2);
+      ASSERT_TRUE(board.setRegions(regions));
+      regions[0].pop_back();
+      ASSERT_FALSE(board.setRegions(regions));
+      board.assign(2, 3, 5);
+
+      board.writeToFile("Gtest_board");
+      JigsawBoard another_board;
+      ASSERT_TRUE(another_board.loadFromFile("Gtest_board"));
+      std::remove("Gtest_board");
       ASSERT_EQ(board, another_board);
+      ASSERT_EQ(another_board.regions(), board.regions());
+      // (2, 3) now sees (0, 0) in its region, but no longer (0, 4).
+      const RegionLayout & layout = another_board.layout();
+      const uint16_t * peers = layout.peers(2 * 9 + 3);
+      ASSERT_NE(std::find(peers, peers + layout.numberOfPeers(2 * 9 + 3), 0), peers + layout.numberOfPeers(2 * 9 + 3));
+      ASSERT_EQ(std::find(peers, peers + layout.numberOfPeers(2 * 9 + 3), 4), peers + layout.numberOfPeers(2 * 9 + 3));
     }
   }
 }
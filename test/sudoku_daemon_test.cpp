@@ -0,0 +1,283 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "Generic/WorkerPool.h"
+#include "Sudoku/SudokuEngine.h"
+#include "Sudoku/SudokuBoard.h"
+#include "Sudoku/SamuraiBoard.h"
+#include "Sudoku/SudokuDaemon.h"
+
+namespace wubinboardgames
+{
+  namespace sudoku
+  {
+    TEST(SudokuDaemonUnitTesting, frames)
+    {
+      DaemonRequest request;
+      request.id = 0x01020304;
+      request.operation = DaemonOperation::grade;
+      request.kind = BoardKind::samurai;
+      request.level = 2;
+      request.cells = {0, 1, 9};
+      std::vector<uint8_t> bytes;
+      EncodeRequest(request, bytes);
+      ASSERT_EQ(bytes.size(), 4 + DAEMON_HEADER_LENGTH + 3);
+      EXPECT_EQ(bytes[4], 0x04);
+      EXPECT_EQ(0u, FrameLength(bytes.data(), bytes.size() - 1));
+      ASSERT_EQ(bytes.size(), FrameLength(bytes.data(), bytes.size()));
+      DaemonRequest decoded;
+      ASSERT_TRUE(DecodeRequest(bytes.data(), bytes.size(), decoded));
+      EXPECT_EQ(decoded.id, request.id);
+      EXPECT_TRUE(DaemonOperation::grade == decoded.operation);
+      EXPECT_TRUE(BoardKind::samurai == decoded.kind);
+      EXPECT_EQ(decoded.level, 2);
+      EXPECT_EQ(decoded.cells, request.cells);
+
+      DaemonResponse response;
+      response.id = 7;
+      response.status = DaemonStatus::not_unique;
+      EncodeResponse(response, bytes);
+      DaemonResponse decoded_response;
+      const std::size_t first_length = FrameLength(bytes.data(), bytes.size());
+      ASSERT_TRUE(DecodeResponse(bytes.data() + first_length, bytes.size() - first_length, decoded_response));
+      EXPECT_EQ(decoded_response.id, 7u);
+      EXPECT_TRUE(DaemonStatus::not_unique == decoded_response.status);
+      EXPECT_TRUE(decoded_response.cells.empty());
+      EXPECT_FALSE(DecodeResponse(bytes.data(), 6, decoded_response));
+
+      EXPECT_EQ(LevelCode(LEVEL::EASY), 0);
+      EXPECT_EQ(LevelCode(LEVEL::SAMURAI), 3);
+      EXPECT_EQ(LevelCode(LEVEL::EXTREME), 4);
+    }
+
+    TEST(SudokuDaemonUnitTesting, cells)
+    {
+      SudokuBoard board;
+      board.loadFromFile("unsolved.board");
+      std::vector<uint8_t> cells;
+      BoardToCells(board, cells);
+      ASSERT_EQ(cells.size(), 81u);
+      SudokuBoard copy;
+      ASSERT_TRUE(CellsToBoard(cells, copy));
+      EXPECT_TRUE(copy == board);
+      EXPECT_EQ(copy.hash(), board.hash());
+      cells[0] = 10;
+      EXPECT_FALSE(CellsToBoard(cells, copy));
+      EXPECT_TRUE(copy == board);
+
+      // samurai boards only send their active cells.
+      SamuraiBoard samurai_board;
+      BoardToCells(samurai_board, cells);
+      EXPECT_EQ(cells.size(), samurai_board.layout().numberOfActiveCells());
+      EXPECT_TRUE(CellsToBoard(cells, samurai_board));
+      cells.push_back(0);
+      EXPECT_FALSE(CellsToBoard(cells, samurai_board));
+    }
+
+    TEST(SudokuDaemonUnitTesting, requests)
+    {
+      SudokuBoard board;
+      board.loadFromFile("unsolved.board");
+      DaemonRequest request;
+      request.id = 3;
+      BoardToCells(board, request.cells);
+      DaemonResponse response = HandleDaemonRequest(request);
+      EXPECT_EQ(response.id, 3u);
+      ASSERT_TRUE(DaemonStatus::ok == response.status);
+      SudokuBoard solution;
+      ASSERT_TRUE(CellsToBoard(response.cells, solution));
+      EXPECT_TRUE(solution == SearchSolution<SudokuBoard>(board)[0]);
+
+      request.operation = DaemonOperation::grade;
+      response = HandleDaemonRequest(request);
+      ASSERT_TRUE(DaemonStatus::ok == response.status);
+      EXPECT_EQ(response.level, LevelCode(LevelEvaluate(board)));
+      SolveBudget budget;
+      budget.max_nodes = 1;
+      EXPECT_TRUE(DaemonStatus::over_budget == HandleDaemonRequest(request, nullptr, nullptr, budget).status);
+
+      request.operation = DaemonOperation::solve;
+      BoardToCells(SudokuBoard{}, request.cells);
+      EXPECT_TRUE(DaemonStatus::not_unique == HandleDaemonRequest(request).status);
+      request.cells[0] = request.cells[1] = 5;
+      EXPECT_TRUE(DaemonStatus::no_solution == HandleDaemonRequest(request).status);
+      request.cells.pop_back();
+      EXPECT_TRUE(DaemonStatus::bad_request == HandleDaemonRequest(request).status);
+      request.kind = BoardKind::number_of_kinds;
+      EXPECT_TRUE(DaemonStatus::bad_request == HandleDaemonRequest(request).status);
+
+      request.operation = DaemonOperation::generate;
+      request.kind = BoardKind::giant;
+      request.level = LevelCode(LEVEL::HARD);
+      EXPECT_TRUE(DaemonStatus::unsupported == HandleDaemonRequest(request).status);
+      request.kind = BoardKind::mini;
+      request.level = LevelCode(LEVEL::EASY);
+      response = HandleDaemonRequest(request);
+      ASSERT_TRUE(DaemonStatus::ok == response.status);
+      MiniSudokuBoard mini_board;
+      ASSERT_TRUE(CellsToBoard(response.cells, mini_board));
+      EXPECT_TRUE(IsSolutionUnique(mini_board));
+
+      GenerationProgress progress;
+      EXPECT_TRUE(DaemonStatus::ok == HandleDaemonRequest(request, &progress).status);
+      request.operation = DaemonOperation::progress;
+      EXPECT_TRUE(DaemonStatus::unsupported == HandleDaemonRequest(request).status);
+      response = HandleDaemonRequest(request, &progress);
+      ASSERT_TRUE(DaemonStatus::ok == response.status);
+      DaemonProgress daemon_progress;
+      ASSERT_TRUE(DecodeProgress(response.cells, daemon_progress));
+      EXPECT_EQ(daemon_progress.final_boards, GenerationProgress::read(progress.final_boards));
+      EXPECT_GE(daemon_progress.final_boards, 1u);
+      EXPECT_EQ(daemon_progress.removals, GenerationProgress::read(progress.removals));
+      EXPECT_EQ(daemon_progress.clues, progress.clues.load());
+    }
+
+    TEST(SudokuDaemonUnitTesting, workerpool)
+    {
+      std::promise<void> release;
+      std::shared_future<void> released = release.get_future().share();
+      std::mutex sizes_mutex;
+      std::vector<std::size_t> batch_sizes;
+      std::atomic<unsigned int> num_of_idle_runs{0};
+      {
+        WorkerPool<int> workers(1, 8,
+                                [&](std::vector<int> & batch)
+                                {
+                                  released.wait();
+                                  std::lock_guard<std::mutex> lock(sizes_mutex);
+                                  batch_sizes.push_back(batch.size());
+                                },
+                                [&num_of_idle_runs]
+                                {
+                                  ++num_of_idle_runs;
+                                  return false;
+                                });
+        workers.submit(0);
+        // the first job keeps the only worker busy while the others queue up.
+        while(workers.numberOfQueuedJobs())
+          std::this_thread::yield();
+        for(int job = 1; job <= 10; ++job)
+          workers.submit(job);
+        release.set_value();
+        while(workers.numberOfQueuedJobs())
+          std::this_thread::yield();
+      }
+      ASSERT_EQ(batch_sizes.size(), 3u);
+      EXPECT_EQ(batch_sizes[0], 1u);
+      EXPECT_EQ(batch_sizes[1], 8u);
+      EXPECT_EQ(batch_sizes[2], 2u);
+      // a single worker is never taken by the idle task.
+      EXPECT_EQ(num_of_idle_runs, 0u);
+
+      WorkerPool<int> idle_workers(2, 8, [](std::vector<int> &) {}, [&num_of_idle_runs]
+      {
+        return ++num_of_idle_runs < 5;
+      });
+      while(num_of_idle_runs < 5)
+        std::this_thread::yield();
+    }
+
+    TEST(SudokuDaemonUnitTesting, socket)
+    {
+      DaemonOptions options;
+      options.socket_path = "/tmp/sudoku_daemon_test_" + std::to_string(getpid()) + ".sock";
+      options.num_of_workers = 2;
+      options.pool_size = 2;
+      std::thread daemon([&options] { EXPECT_TRUE(RunSolverDaemon(options)); });
+
+      SudokuBoard board;
+      board.loadFromFile("unsolved.board");
+      std::vector<DaemonRequest> requests(3);
+      for(uint32_t n = 0; n < requests.size(); ++n)
+        requests[n].id = 100 + n;
+      BoardToCells(board, requests[0].cells);
+      requests[1] = requests[0];
+      requests[1].id = 101;
+      requests[1].operation = DaemonOperation::grade;
+      requests[2].operation = DaemonOperation::generate;
+      requests[2].level = LevelCode(LEVEL::MEDIUM);
+
+      std::vector<DaemonResponse> responses;
+      bool is_answered = false;
+      for(unsigned int attempt = 0; attempt < 200 && !is_answered; ++attempt)
+      {
+        is_answered = SendDaemonRequests(options.socket_path, requests, responses);
+        if(!is_answered)
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      // generations of the pools and of the requests add up in the progress of the daemon.
+      std::vector<DaemonRequest> progress_request(1);
+      progress_request[0].operation = DaemonOperation::progress;
+      std::vector<DaemonResponse> progress_response;
+      const bool is_progress_answered = is_answered &&
+          SendDaemonRequests(options.socket_path, progress_request, progress_response);
+      StopSolverDaemon();
+      daemon.join();
+      ASSERT_TRUE(is_answered);
+      ASSERT_TRUE(is_progress_answered);
+      DaemonProgress daemon_progress;
+      ASSERT_TRUE(DecodeProgress(progress_response[0].cells, daemon_progress));
+      EXPECT_GE(daemon_progress.final_boards, 1u);
+      EXPECT_GT(daemon_progress.search_nodes, 0u);
+      ASSERT_EQ(responses.size(), 3u);
+      EXPECT_EQ(responses[0].id, 100u);
+      EXPECT_TRUE(DaemonStatus::ok == responses[0].status);
+      SudokuBoard solution;
+      ASSERT_TRUE(CellsToBoard(responses[0].cells, solution));
+      EXPECT_TRUE(IsBoardSolved(solution));
+      EXPECT_EQ(responses[1].level, LevelCode(LevelEvaluate(board)));
+      EXPECT_TRUE(DaemonStatus::ok == responses[2].status);
+      SudokuBoard generated;
+      ASSERT_TRUE(CellsToBoard(responses[2].cells, generated));
+      EXPECT_TRUE(LEVEL::MEDIUM == LevelEvaluate(generated));
+      EXPECT_NE(0, access(options.socket_path.c_str(), F_OK));
+    }
+
+    TEST(SudokuDaemonUnitTesting, stopduringgeneration)
+    {
+      DaemonOptions options;
+      options.socket_path = "/tmp/sudoku_daemon_stop_test_" + std::to_string(getpid()) + ".sock";
+      options.num_of_workers = 2;
+      options.pool_size = 0;
+      std::thread daemon([&options] { EXPECT_TRUE(RunSolverDaemon(options)); });
+
+      // generations of the widest boards, queued on both workers.
+      std::vector<DaemonRequest> requests(8);
+      for(uint32_t n = 0; n < requests.size(); ++n)
+      {
+        requests[n].id = n;
+        requests[n].kind = BoardKind::colossal;
+        requests[n].operation = DaemonOperation::generate;
+      }
+      std::atomic<bool> is_stopped{false};
+      std::thread client([&options, &requests, &is_stopped]
+      {
+        // no answer comes: the daemon hangs up once stopped.
+        std::vector<DaemonResponse> responses;
+        while(!is_stopped && !SendDaemonRequests(options.socket_path, requests, responses))
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      });
+      while(0 != access(options.socket_path.c_str(), F_OK))
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+      // the generations in progress are cancelled, the workers do not finish them.
+      const auto start = std::chrono::steady_clock::now();
+      is_stopped = true;
+      StopSolverDaemon();
+      daemon.join();
+      EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+      client.join();
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
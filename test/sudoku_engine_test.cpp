@@ -1,5 +1,14 @@
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
 #include "gtest/gtest.h"
 #include "Sudoku/SudokuEngine.h"
+#include "Sudoku/SamuraiBoard.h"
+#include "Sudoku/KillerEngine.h"
+#include "Sudoku/JigsawEngine.h"
+#include "Sudoku/VariantBoard.h"
 #include "Sudoku/SudokuBoard.h"
 #include "Sudoku/SudokuGame.h"
 
@@ -134,6 +143,734 @@ namespace wubinboardgames
         EXPECT_TRUE(IsSolutionUnique<SudokuBoard>(sudoku_board));
         EXPECT_EQ(LevelEvaluate<SudokuBoard>(sudoku_board), LEVEL::MEDIUM);
     }
+    TEST(SudokuEngineUnitTesting, countsolutions)
+    {
+      SudokuBoard sudoku_board;
+      sudoku_board.loadFromFile("unsolved.board");
+      EXPECT_EQ(CountSolutions<SudokuBoard>(sudoku_board), 1u);
+      sudoku_board.loadFromFile("unsolvable.board");
+      EXPECT_EQ(CountSolutions<SudokuBoard>(sudoku_board, 2), 2u);
+      sudoku_board[0][0] = 1;
+      sudoku_board[0][1] = 1;
+      EXPECT_EQ(CountSolutions<SudokuBoard>(sudoku_board), 0u);
+    }
+    TEST(SudokuEngineUnitTesting, countsolutionswithtranspositiontable)
+    {
+      // there are 288 valid 4x4 sudoku grids.
+      typedef GenericBoard<GenericCell<unsigned int, 1, 4>> MiniBoard;
+      MiniBoard mini_board;
+      TranspositionTable table(1 << 10);
+      EXPECT_EQ(CountSolutions<MiniBoard>(mini_board), 288u);
+      EXPECT_EQ(CountSolutions<MiniBoard>(mini_board, 288, &table), 288u);
+      EXPECT_EQ(CountSolutions<MiniBoard>(mini_board, 10, &table), 10u);
+
+      SudokuBoard sudoku_board;
+      sudoku_board.loadFromFile("unsolvable.board");
+      uint64_t count = CountSolutions<SudokuBoard>(sudoku_board);
+      TranspositionTable sudoku_table;
+      EXPECT_EQ(CountSolutions<SudokuBoard>(sudoku_board, TranspositionTable::max_count, &sudoku_table), count);
+      // second run is answered from the table
+      EXPECT_EQ(CountSolutions<SudokuBoard>(sudoku_board, TranspositionTable::max_count, &sudoku_table), count);
+    }
+    TEST(SudokuEngineUnitTesting, gradedifficulty)
+    {
+      SudokuBoard sudoku_board;
+      sudoku_board.loadFromFile("solved.board");
+      DifficultyGrade solved_grade = GradeDifficulty<SudokuBoard>(sudoku_board);
+      EXPECT_EQ(solved_grade.level, LEVEL::EASY);
+
+      sudoku_board.loadFromFile("unsolved.board");
+      DifficultyGrade grade = GradeDifficulty<SudokuBoard>(sudoku_board);
+      EXPECT_TRUE(grade.within_budget);
+      EXPECT_GT(grade.score, solved_grade.score);
+      EXPECT_EQ(grade.level, LEVEL::MEDIUM);
+      EXPECT_GT(grade.propagation_depth, 0u);
+      EXPECT_EQ(grade.nodes, 9u);
+
+      // out of budget boards are graded EXTREME
+      DifficultyGrade budget_grade = GradeDifficulty<SudokuBoard>(sudoku_board, grade.nodes - 1);
+      EXPECT_FALSE(budget_grade.within_budget);
+      EXPECT_EQ(budget_grade.level, LEVEL::EXTREME);
+      EXPECT_TRUE(GradeDifficulty<SudokuBoard>(sudoku_board, grade.nodes).within_budget);
+
+      sudoku_board.loadFromFile("unsolvable.board");
+      EXPECT_EQ(GradeDifficulty<SudokuBoard>(sudoku_board).level, LEVEL::NO_UNIQUE_SOLUTION);
+      sudoku_board[0][0] = 1;
+      sudoku_board[0][1] = 1;
+      EXPECT_EQ(GradeDifficulty<SudokuBoard>(sudoku_board).level, LEVEL::NO_SOLUTION);
+    }
+    TEST(SudokuEngineUnitTesting, searchstats)
+    {
+      SudokuBoard sudoku_board;
+      sudoku_board.loadFromFile("unsolved.board");
+      SearchStats stats;
+      unsigned int num_of_retries = 0;
+      SearchSolution<SudokuBoard>(sudoku_board, &num_of_retries, &stats);
+      EXPECT_GE(stats.forwards, num_of_retries);
+      EXPECT_GT(stats.backtracks, 0u);
+      EXPECT_GE(stats.nodes, stats.forwards);
+      EXPECT_LE(stats.max_depth, 81u);
+      EXPECT_GT(stats.time_to_first_solution.count(), 0);
+      EXPECT_EQ(stats.time_to_second_solution.count(), 0);
+      EXPECT_GE(stats.wall_time, stats.time_to_first_solution);
+      EXPECT_EQ(stats.open_calls, 0u);
+
+      stats.clear();
+      sudoku_board.loadFromFile("unsolvable.board");
+      EXPECT_EQ(CountSolutions<SudokuBoard>(sudoku_board, 2, nullptr, &stats), 2u);
+      EXPECT_GT(stats.time_to_second_solution, stats.time_to_first_solution);
+
+      stats.clear();
+      GenerateSolvableBoard<SudokuBoard>(LEVEL::EASY, 32, &stats);
+      EXPECT_GT(stats.nodes, 0u);
+      EXPECT_GT(stats.wall_time.count(), 0);
+    }
+    TEST(SudokuEngineUnitTesting, tracegeneration)
+    {
+      std::thread worker([]{ GenerateSolvableBoard<SudokuBoard>(LEVEL::EASY); });
+      worker.join();
+      // the buffer of the finished thread is still dumped.
+      std::stringstream trace_json;
+      trace::DumpChromeTrace(trace_json);
+      std::string content = trace_json.str();
+      EXPECT_EQ(content.find("{\"traceEvents\":["), 0u);
+      EXPECT_NE(content.find("\"name\":\"GenerateSolvableBoard\""), std::string::npos);
+      EXPECT_NE(content.find("\"name\":\"GenerateFinalBoard\""), std::string::npos);
+      EXPECT_NE(content.find("\"name\":\"UniquenessAndLevel\""), std::string::npos);
+    }
+    TEST(SudokuEngineUnitTesting, wideboards)
+    {
+      GiantSudokuBoard giant_board = GenerateFinalBoard<GiantSudokuBoard>();
+      EXPECT_TRUE(IsBoardSolved<GiantSudokuBoard>(giant_board));
+      EXPECT_EQ(giant_board.hash(), GiantSudokuBoard{giant_board}.rehash());
+
+      GiantSudokuBoard giant_game = GenerateSolvableBoard<GiantSudokuBoard>(LEVEL::EASY);
+      EXPECT_TRUE(IsBoardValid<GiantSudokuBoard>(giant_game));
+      EXPECT_EQ(SearchSolution<GiantSudokuBoard>(giant_game).size(), 1u);
+      EXPECT_EQ(LevelEvaluate<GiantSudokuBoard>(giant_game), LEVEL::EASY);
+
+      ColossalSudokuBoard colossal_board = GenerateFinalBoard<ColossalSudokuBoard>();
+      EXPECT_TRUE(IsBoardSolved<ColossalSudokuBoard>(colossal_board));
+      ColossalSudokuBoard colossal_game{colossal_board};
+      colossal_game[0][0].reset();
+      colossal_game[35][35].reset();
+      std::vector<ColossalSudokuBoard> solutions = SearchSolution<ColossalSudokuBoard>(colossal_game);
+      ASSERT_EQ(solutions.size(), 1u);
+      EXPECT_TRUE(solutions[0] == colossal_board);
+      // same value twice in the last box
+      colossal_game[35][35] = static_cast<unsigned int>(colossal_board[30][30]);
+      EXPECT_FALSE(IsBoardValid<ColossalSudokuBoard>(colossal_game));
+    }
+    // generate an EASY board, giving up after time_limit. True if it is done in time.
+    template<typename GameBoard>
+    bool GeneratesInTime(std::chrono::seconds time_limit)
+    {
+      DeadlineFlag deadline(std::chrono::steady_clock::now() + time_limit);
+      GameBoard board = GenerateSolvableBoard<GameBoard>(LEVEL::EASY, GameBoard::width * GameBoard::width / 2.5,
+                                                         nullptr, deadline.flag());
+      return !deadline.flag()->load() && LEVEL::EASY == LevelEvaluate<GameBoard>(board);
+    }
+    TEST(SudokuEngineUnitTesting, generateeachsize)
+    {
+      // the uniqueness proofs of the wide boards used to take minutes now and then.
+      const std::chrono::seconds time_limit(30);
+      EXPECT_TRUE(GeneratesInTime<MiniSudokuBoard>(time_limit));
+      EXPECT_TRUE(GeneratesInTime<OctoSudokuBoard>(time_limit));
+      EXPECT_TRUE(GeneratesInTime<SudokuBoard>(time_limit));
+      EXPECT_TRUE(GeneratesInTime<DozenSudokuBoard>(time_limit));
+      EXPECT_TRUE(GeneratesInTime<ExtendedSudokuBoard>(time_limit));
+      EXPECT_TRUE(GeneratesInTime<SamuraiBoard>(time_limit));
+      EXPECT_TRUE(GeneratesInTime<GiantSudokuBoard>(time_limit));
+      for(unsigned int attempt = 0; attempt < 3; ++attempt)
+        EXPECT_TRUE(GeneratesInTime<ColossalSudokuBoard>(time_limit));
+    }
+    TEST(SudokuEngineUnitTesting, rectangularboxes)
+    {
+      MiniSudokuBoard mini_game = GenerateSolvableBoard<MiniSudokuBoard>(LEVEL::EASY);
+      EXPECT_EQ(LevelEvaluate<MiniSudokuBoard>(mini_game), LEVEL::EASY);
+      ASSERT_EQ(SearchSolution<MiniSudokuBoard>(mini_game).size(), 1u);
+      EXPECT_TRUE(IsBoardSolved<MiniSudokuBoard>(SearchSolution<MiniSudokuBoard>(mini_game)[0]));
+
+      OctoSudokuBoard octo_board = GenerateFinalBoard<OctoSudokuBoard>();
+      EXPECT_TRUE(IsBoardSolved<OctoSudokuBoard>(octo_board));
+
+      DozenSudokuBoard dozen_game = GenerateSolvableBoard<DozenSudokuBoard>(LEVEL::MEDIUM);
+      EXPECT_EQ(LevelEvaluate<DozenSudokuBoard>(dozen_game), LEVEL::MEDIUM);
+      EXPECT_EQ(CountSolutions<DozenSudokuBoard>(dozen_game, 2), 1u);
+
+      // (0, 0) and (1, 2) share a 2x3 box, (0, 0) and (2, 1) do not.
+      MiniSudokuBoard mini_board;
+      mini_board[0][0] = 4;
+      MiniSudokuCell cell;
+      cell = 4;
+      cell.setPosition(1, 2);
+      EXPECT_FALSE(IsCellEligible<MiniSudokuBoard>(mini_board, cell));
+      cell.setPosition(2, 1);
+      EXPECT_TRUE(IsCellEligible<MiniSudokuBoard>(mini_board, cell));
+      mini_board[1][2] = 4;
+      EXPECT_FALSE(IsBoardValid<MiniSudokuBoard>(mini_board));
+    }
+    TEST(SudokuEngineUnitTesting, samurai)
+    {
+      SamuraiBoard final_board = GenerateFinalBoard<SamuraiBoard>();
+      EXPECT_TRUE(IsBoardSolved<SamuraiBoard>(final_board));
+      for(unsigned int grid = 0; grid < SamuraiBoard::number_of_grids; ++grid)
+        EXPECT_TRUE(IsBoardSolved<SudokuBoard>(final_board.subBoard(grid)));
+
+      SamuraiBoard game = GenerateSolvableBoard<SamuraiBoard>(LEVEL::EASY);
+      EXPECT_EQ(LevelEvaluate<SamuraiBoard>(game), LEVEL::EASY);
+      std::vector<SamuraiBoard> solutions = SearchSolution<SamuraiBoard>(game);
+      ASSERT_EQ(solutions.size(), 1u);
+      EXPECT_TRUE(IsBoardSolved<SamuraiBoard>(solutions[0]));
+      EXPECT_EQ(CountSolutions<SamuraiBoard>(game, 2), 1u);
+
+      // (6, 6) is in the top left and center grids, (14, 6) in the center and bottom
+      // left grids. They only meet in the first column of the center grid.
+      SamuraiBoard shared_board;
+      shared_board[6][6] = 4;
+      EXPECT_TRUE(IsBoardValid<SamuraiBoard>(shared_board));
+      shared_board[14][6] = 4;
+      EXPECT_FALSE(IsBoardValid<SamuraiBoard>(shared_board));
+      SudokuCell cell;
+      // (6, 14) meets (6, 6) in the first row of the center grid.
+      cell.setPosition(6, 14);
+      cell = 4;
+      EXPECT_FALSE(IsCellEligible<SamuraiBoard>(shared_board, cell));
+    }
+    TEST(SudokuEngineUnitTesting, killer)
+    {
+      KillerBoard game = GenerateSolvableBoard<KillerBoard>(LEVEL::MEDIUM);
+      ASSERT_FALSE(game.cages().empty());
+      EXPECT_EQ(LevelEvaluate<KillerBoard>(game), LEVEL::MEDIUM);
+      std::vector<KillerBoard> solutions = SearchSolution<KillerBoard>(game);
+      ASSERT_EQ(solutions.size(), 1u);
+      EXPECT_TRUE(IsBoardSolved<KillerBoard>(solutions[0]));
+      for(const auto & cage : game.cages())
+      {
+        unsigned int sum = 0;
+        for(unsigned int index : cage.cells)
+          sum += static_cast<unsigned int>(solutions[0][index / 9][index % 9]);
+        EXPECT_EQ(sum, cage.sum);
+      }
+
+      // cages of a single cell give their digit away, without any given cell.
+      KillerBoard empty_board;
+      std::vector<KillerBoard::Cage> cages;
+      for(unsigned int index = 0; index < 81; ++index)
+        cages.push_back({static_cast<unsigned int>(solutions[0][index / 9][index % 9]), {index}});
+      ASSERT_TRUE(empty_board.setCages(cages));
+      EXPECT_EQ(CountSolutions<KillerBoard>(empty_board, 2), 1u);
+
+      KillerBoard sum_board;
+      ASSERT_TRUE(sum_board.setCages({{4, {0, 1}}}));
+      sum_board[0][0] = 1;
+      EXPECT_TRUE(IsBoardValid<KillerBoard>(sum_board));
+      SudokuCell cell;
+      cell.setPosition(0, 1);
+      cell = 2;
+      EXPECT_FALSE(IsCellEligible<KillerBoard>(sum_board, cell));
+      cell = 3;
+      EXPECT_TRUE(IsCellEligible<KillerBoard>(sum_board, cell));
+      sum_board[0][1] = 2;
+      EXPECT_FALSE(IsBoardValid<KillerBoard>(sum_board));
+      sum_board[0][1] = 3;
+      EXPECT_TRUE(IsBoardValid<KillerBoard>(sum_board));
+      EXPECT_EQ(CountSolutions<KillerBoard>(sum_board, 2), 2u);
+    }
+    template<typename VariantBoard>
+    void ExpectUniqueGame(const VariantBoard & game, const LEVEL & level)
+    {
+      EXPECT_EQ(LevelEvaluate<VariantBoard>(game), level);
+      std::vector<VariantBoard> solutions = SearchSolution<VariantBoard>(game);
+      ASSERT_EQ(solutions.size(), 1u);
+      EXPECT_TRUE(IsBoardSolved<VariantBoard>(solutions[0]));
+      EXPECT_EQ(CountSolutions<VariantBoard>(game, 2), 1u);
+    }
+    TEST(SudokuEngineUnitTesting, variants)
+    {
+      DiagonalSudokuBoard diagonal_game = GenerateSolvableBoard<DiagonalSudokuBoard>(LEVEL::MEDIUM);
+      ExpectUniqueGame(diagonal_game, LEVEL::MEDIUM);
+      DiagonalSudokuBoard diagonal_board;
+      diagonal_board[0][0] = 7;
+      diagonal_board[8][8] = 7;
+      EXPECT_FALSE(IsBoardValid<DiagonalSudokuBoard>(diagonal_board));
+
+      WindokuBoard windoku_game = GenerateSolvableBoard<WindokuBoard>(LEVEL::MEDIUM);
+      ExpectUniqueGame(windoku_game, LEVEL::MEDIUM);
+      WindokuBoard windoku_board;
+      windoku_board[1][1] = 7;
+      SudokuCell cell;
+      // (3, 3) is in the first window with (1, 1), not in its box.
+      cell.setPosition(3, 3);
+      cell = 7;
+      EXPECT_FALSE(IsCellEligible<WindokuBoard>(windoku_board, cell));
+      cell.setPosition(4, 4);
+      EXPECT_TRUE(IsCellEligible<WindokuBoard>(windoku_board, cell));
+
+      JigsawBoard jigsaw_game = GenerateSolvableBoard<JigsawBoard>(LEVEL::MEDIUM);
+      ExpectUniqueGame(jigsaw_game, LEVEL::MEDIUM);
+      std::vector<JigsawBoard> solutions = SearchSolution<JigsawBoard>(jigsaw_game);
+      ASSERT_FALSE(solutions.empty());
+      for(const auto & region : jigsaw_game.regions())
+      {
+        unsigned int values = 0;
+        for(unsigned int index : region)
+          values |= 1u << static_cast<unsigned int>(solutions[0][index / 9][index % 9]);
+        EXPECT_EQ(values, 0x3feu);
+      }
+    }
+
+    TEST(SudokuEngineUnitTesting, cancelgeneration)
+    {
+      std::atomic<bool> cancelled{true};
+      DozenSudokuBoard board = GenerateSolvableBoard<DozenSudokuBoard>(LEVEL::EASY, 57, nullptr, &cancelled);
+      EXPECT_TRUE(board == DozenSudokuBoard{});
+
+      // hard dozen boards are not found in any reasonable time, cancelling stops the search.
+      cancelled = false;
+      std::thread canceller([&cancelled]
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        cancelled = true;
+      });
+      const auto start = std::chrono::steady_clock::now();
+      board = GenerateSolvableBoard<DozenSudokuBoard>(LEVEL::EXTREME, 57, nullptr, &cancelled);
+      canceller.join();
+      EXPECT_TRUE(board == DozenSudokuBoard{});
+      EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    }
+    TEST(SudokuEngineUnitTesting, generationprogress)
+    {
+      GenerationProgress progress;
+      SudokuBoard board = GenerateSolvableBoard<SudokuBoard>(LEVEL::EASY, 32, nullptr, nullptr, &progress);
+      unsigned int num_of_clues = 0;
+      for(unsigned int index = 0; index < 81; ++index)
+        num_of_clues += !board[index / 9][index % 9].isVacant();
+      EXPECT_GE(GenerationProgress::read(progress.final_boards), 1u);
+      EXPECT_GE(GenerationProgress::read(progress.removals), 81u - num_of_clues);
+      EXPECT_EQ(progress.clues.load(), num_of_clues);
+      EXPECT_GT(GenerationProgress::read(progress.search_nodes), 0u);
+      EXPECT_GT(progress.searchNodesPerSecond(), 0.0);
+    }
+    TEST(SudokuEngineUnitTesting, paralleldigging)
+    {
+      // every cell of a final board can be set vacant alone.
+      SudokuBoard final_board = GenerateFinalBoard<SudokuBoard>();
+      RemovalTrials<SudokuBoard> trials(4);
+      ASSERT_EQ(trials.size(), 4u);
+      for(unsigned int trial = 0; trial < trials.size(); ++trial)
+        trials[trial].index = trial * 20;
+      trials.run(final_board, 3, true);
+      for(unsigned int trial = 0; trial < 3; ++trial)
+      {
+        EXPECT_EQ(trials[trial].num_of_solutions, 1u);
+        EXPECT_TRUE(LEVEL::EASY == trials[trial].level);
+        EXPECT_GT(trials[trial].stats.nodes, 0u);
+      }
+      EXPECT_EQ(trials[3].num_of_solutions, 0u);
+      EXPECT_TRUE(IsBoardSolved(final_board));
+      // cancelled rounds find nothing.
+      std::atomic<bool> cancelled{true};
+      trials.run(final_board, 3, true, &cancelled);
+      for(unsigned int trial = 0; trial < 3; ++trial)
+        EXPECT_EQ(trials[trial].num_of_solutions, 0u);
+
+      GenerationProgress progress;
+      SearchStats stats;
+      SudokuBoard board = GenerateSolvableBoard<SudokuBoard>(LEVEL::MEDIUM, 32, &stats, nullptr, &progress, 4);
+      EXPECT_TRUE(LEVEL::MEDIUM == LevelEvaluate<SudokuBoard>(board));
+      EXPECT_TRUE(IsSolutionUnique(board));
+      unsigned int num_of_clues = 0;
+      for(unsigned int index = 0; index < 81; ++index)
+        num_of_clues += !board[index / 9][index % 9].isVacant();
+      EXPECT_LT(num_of_clues, 81u - 32u);
+      EXPECT_EQ(progress.clues.load(), num_of_clues);
+      EXPECT_GT(stats.nodes, 0u);
+      EXPECT_LE(GenerationProgress::read(progress.search_nodes), stats.nodes);
+
+      // generations of the game use them too.
+      BoardGeneration<SudokuBoard> generation(LEVEL::EASY, 1, 3);
+      ASSERT_TRUE(generation.waitFor(std::chrono::seconds(60)));
+      EXPECT_TRUE(LEVEL::EASY == LevelEvaluate<SudokuBoard>(generation.get()));
+
+      // cancelled, the rounds in progress stop too.
+      DeadlineFlag soon(std::chrono::steady_clock::now() + std::chrono::milliseconds(50));
+      const auto start = std::chrono::steady_clock::now();
+      board = GenerateSolvableBoard<SudokuBoard>(LEVEL::EXTREME, 32, nullptr, soon.flag(), nullptr, 4);
+      EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    }
+    TEST(SudokuEngineUnitTesting, minimalgeneration)
+    {
+      GenerationProgress progress;
+      SudokuBoard board = GenerateMinimalBoard<SudokuBoard>(17, 22, nullptr, nullptr, &progress);
+      const unsigned int num_of_givens = NumberOfGivens(board);
+      EXPECT_GE(num_of_givens, 17u);
+      EXPECT_LE(num_of_givens, 22u);
+      EXPECT_EQ(progress.clues.load(), num_of_givens);
+      ASSERT_EQ(1u, CountSolutions(board, 2));
+      // no given cell can be set vacant.
+      for(unsigned int index = 0; index < 81; ++index)
+      {
+        if(board[index / 9][index % 9].isVacant())
+          continue;
+        SudokuBoard smaller_board{board};
+        smaller_board[index / 9][index % 9].reset();
+        EXPECT_EQ(2u, CountSolutions(smaller_board, 2));
+      }
+
+      SudokuBoard final_board = GenerateFinalBoard<SudokuBoard>();
+      SudokuBoard dug_board{final_board};
+      EXPECT_FALSE(DigToMinimal(dug_board, 10));
+      dug_board = final_board;
+      ASSERT_TRUE(DigToMinimal(dug_board, 81));
+      EXPECT_TRUE(SearchSolution(dug_board)[0] == final_board);
+
+      std::atomic<bool> cancelled{true};
+      EXPECT_TRUE(GenerateMinimalBoard<SudokuBoard>(0, 10, nullptr, &cancelled) == SudokuBoard{});
+    }
+    template<typename GameBoard>
+    void ExpectUnavoidable(const GameBoard & final_board, const UnavoidableSets<GameBoard> & sets)
+    {
+      constexpr unsigned int width = GameBoard::width;
+      for(unsigned int set = 0; set < sets.size(); ++set)
+      {
+        GameBoard board{final_board};
+        for(unsigned int index : sets.cellsOf(set))
+          board[index / width][index % width].reset();
+        EXPECT_EQ(2u, CountSolutions(board, 2));
+      }
+    }
+
+    TEST(SudokuEngineUnitTesting, unavoidablesets)
+    {
+      SudokuBoard final_board = GenerateFinalBoard<SudokuBoard>();
+      UnavoidableSets<SudokuBoard> sets(final_board);
+      // every pair of values makes a set at least.
+      ASSERT_GE(sets.size(), 36u);
+      ExpectUnavoidable(final_board, sets);
+
+      // the last given cell of a set cannot be set vacant.
+      std::vector<unsigned int> cells = sets.cellsOf(0);
+      for(unsigned int n = 0; n + 1 < cells.size(); ++n)
+      {
+        EXPECT_TRUE(sets.canRemove(cells[n]));
+        sets.remove(cells[n]);
+      }
+      EXPECT_FALSE(sets.canRemove(cells.back()));
+
+      // the second solution of a board tells a new set.
+      SudokuBoard board{final_board};
+      for(unsigned int index : cells)
+        board[index / 9][index % 9].reset();
+      std::vector<SudokuBoard> solutions = SearchSolution(board);
+      ASSERT_EQ(2u, solutions.size());
+      const unsigned int num_of_sets = sets.size();
+      sets.learn(solutions[0], board);
+      sets.learn(solutions[1], board);
+      EXPECT_EQ(num_of_sets + 1, sets.size());
+
+      // cages holding only one of two values keep their sum from being swapped. Most
+      // cages hold neither; the engine test is built with -D_GLIBCXX_ASSERTIONS so that
+      // marking a cell for them fails here.
+      KillerBoard killer_board = GenerateFinalBoard<KillerBoard>();
+      PrepareToDig(killer_board);
+      UnavoidableSets<KillerBoard> killer_sets(killer_board);
+      ExpectUnavoidable(killer_board, killer_sets);
+
+      SamuraiBoard samurai_board = GenerateFinalBoard<SamuraiBoard>();
+      UnavoidableSets<SamuraiBoard> samurai_sets(samurai_board);
+      EXPECT_GT(samurai_sets.size(), 0u);
+      ExpectUnavoidable(samurai_board, samurai_sets);
+    }
+    TEST(SudokuEngineUnitTesting, symmetricgeneration)
+    {
+      EXPECT_EQ(SymmetricIndex(0, 9, Symmetry::rotational), 80u);
+      EXPECT_EQ(SymmetricIndex(1, 9, Symmetry::diagonal), 9u);
+      EXPECT_EQ(SymmetricIndex(1, 9, Symmetry::horizontal), 73u);
+      EXPECT_EQ(SymmetricIndex(1, 9, Symmetry::vertical), 7u);
+      EXPECT_EQ(SymmetricIndex(40, 9, Symmetry::rotational), 40u);
+      for(Symmetry symmetry : {Symmetry::rotational, Symmetry::diagonal, Symmetry::horizontal, Symmetry::vertical})
+      {
+        for(unsigned int num_of_trials : {1u, 3u})
+        {
+          SudokuBoard board = GenerateSolvableBoard<SudokuBoard>(LEVEL::HARD, 81 / 2.5, nullptr, nullptr, nullptr,
+                                                                 num_of_trials, symmetry);
+          EXPECT_TRUE(LEVEL::HARD == LevelEvaluate(board));
+          for(unsigned int index = 0; index < 81; ++index)
+          {
+            const unsigned int image = SymmetricIndex(index, 9, symmetry);
+            EXPECT_EQ(board[index / 9][index % 9].isVacant(), board[image / 9][image % 9].isVacant());
+          }
+        }
+      }
+
+      // the given cells are those of the mask.
+      const std::vector<bool> clue_mask = ClueMaskOf(GenerateSolvableBoard<SudokuBoard>(LEVEL::EASY));
+      GenerationProgress progress;
+      SudokuBoard board = GenerateBoardFromMask<SudokuBoard>(clue_mask, LEVEL::EASY, nullptr, nullptr, &progress);
+      EXPECT_TRUE(ClueMaskOf(board) == clue_mask);
+      EXPECT_TRUE(LEVEL::EASY == LevelEvaluate(board));
+      EXPECT_EQ(progress.clues.load(), NumberOfGivens(board));
+      EXPECT_TRUE(GenerateBoardFromMask<SudokuBoard>(std::vector<bool>(80, true)) == SudokuBoard{});
+      std::atomic<bool> cancelled{true};
+      EXPECT_TRUE(GenerateBoardFromMask<SudokuBoard>(std::vector<bool>(81), LEVEL::EASY, nullptr, &cancelled) ==
+                  SudokuBoard{});
+    }
+    TEST(SudokuEngineUnitTesting, levelclimbing)
+    {
+      EXPECT_EQ(0.0, LevelDistance(3.0, LEVEL::EASY));
+      EXPECT_GT(LevelDistance(std::log10(3000.0), LEVEL::EASY), 0.0);
+      EXPECT_EQ(0.0, LevelDistance(std::log10(3000.0), LEVEL::MEDIUM));
+      EXPECT_LT(LevelDistance(2.0, LEVEL::HARD), 0.0);
+      EXPECT_EQ(0.0, LevelDistance(9.0, LEVEL::EXTREME));
+
+      SudokuBoard board;
+      board.loadFromFile("unsolved.board");
+      EXPECT_TRUE(LevelEvaluate(board) == LevelOfRetries(static_cast<unsigned int>(std::pow(10.0, DifficultyScore(board)) + 0.5)));
+
+      // a minimal board climbs to the level, keeping its solution and its symmetry.
+      bool is_climbed = false;
+      for(unsigned int attempt = 0; attempt < 20 && !is_climbed; ++attempt)
+      {
+        const SudokuBoard final_board = GenerateFinalBoard<SudokuBoard>();
+        board = final_board;
+        DigToLevel(board, LEVEL::EXTREME, 81, nullptr, nullptr, nullptr, Symmetry::rotational);
+        is_climbed = ClimbToLevel(board, final_board, LEVEL::SAMURAI, 40, LEVEL_CLIMB_STEPS, nullptr, nullptr,
+                                  nullptr, Symmetry::rotational);
+        if(!is_climbed)
+          continue;
+        EXPECT_TRUE(LEVEL::SAMURAI == LevelEvaluate(board));
+        EXPECT_LT(NumberOfGivens(board), 41u);
+        EXPECT_TRUE(SearchSolution(board)[0] == final_board);
+        for(unsigned int index = 0; index < 81; ++index)
+          EXPECT_EQ(board[index / 9][index % 9].isVacant(), board[8 - index / 9][8 - index % 9].isVacant());
+      }
+      EXPECT_TRUE(is_climbed);
+    }
+    TEST(SudokuEngineUnitTesting, budgetedsolve)
+    {
+      SudokuBoard board;
+      board.loadFromFile("unsolved.board");
+      SolveResult<SudokuBoard> result = SolveWithinBudget(board, SolveBudget());
+      EXPECT_TRUE(SolveStatus::unique == result.status);
+      ASSERT_EQ(1u, result.solutions.size());
+      EXPECT_TRUE(result.solutions[0] == SearchSolution(board)[0]);
+      EXPECT_TRUE(SolveStatus::multiple == SolveWithinBudget(SudokuBoard{}, SolveBudget()).status);
+      SudokuBoard wrong_board{board};
+      wrong_board[0][0] = wrong_board[0][1] = wrong_board[0][2] = 1;
+      EXPECT_TRUE(SolveStatus::no_solution == SolveWithinBudget(wrong_board, SolveBudget()).status);
+
+      SolveBudget budget;
+      budget.max_nodes = 1;
+      result = SolveWithinBudget(board, budget);
+      EXPECT_TRUE(SolveStatus::budget_exceeded == result.status);
+      EXPECT_TRUE(result.solutions.empty());
+      EXPECT_TRUE(SolveStatus::budget_exceeded ==
+                  SolveWithinBudget(board, SolveBudget::within(std::chrono::milliseconds(-1))).status);
+      std::atomic<bool> cancelled{true};
+      EXPECT_TRUE(SolveStatus::budget_exceeded == SolveWithinBudget(board, SolveBudget(), &cancelled).status);
+
+      // a budget running out between the two solutions of a board leaves it solved.
+      SolveStatus status = SolveStatus::budget_exceeded;
+      for(budget.max_nodes = 1; SolveStatus::budget_exceeded == status && budget.max_nodes < 1000; ++budget.max_nodes)
+        status = SolveWithinBudget(SudokuBoard{}, budget).status;
+      EXPECT_TRUE(SolveStatus::solved == status);
+
+      // the most constrained cell keeps a nearly empty wide board from tying the search up.
+      ExtendedSudokuBoard extended_board;
+      extended_board[0][0] = extended_board[1][4] = 1;
+      const SolveResult<ExtendedSudokuBoard> extended_result =
+          SolveWithinBudget(extended_board, SolveBudget::within(std::chrono::seconds(10)));
+      EXPECT_TRUE(SolveStatus::multiple == extended_result.status);
+
+      // the row by row search stops after max_forwards forwards.
+      unsigned int num_of_retries = 0;
+      SearchSolution(SudokuBoard{}, &num_of_retries, nullptr, std::false_type(), nullptr, 2, 10);
+      EXPECT_EQ(num_of_retries, 10u);
+    }
+    TEST(SudokuEngineUnitTesting, anytimegeneration)
+    {
+      std::atomic<bool> followed{false};
+      {
+        DeadlineFlag deadline(std::chrono::steady_clock::now() + std::chrono::hours(1), &followed);
+        EXPECT_FALSE(deadline.flag()->load());
+        followed = true;
+        while(!deadline.flag()->load())
+          std::this_thread::yield();
+      }
+      DeadlineFlag past_deadline(std::chrono::steady_clock::now());
+      while(!past_deadline.flag()->load())
+        std::this_thread::yield();
+
+      GradedBoard<SudokuBoard> graded = GenerateBoardWithin<SudokuBoard>(LEVEL::EASY, std::chrono::minutes(1));
+      EXPECT_TRUE(LEVEL::EASY == graded.level);
+      EXPECT_TRUE(LEVEL::EASY == LevelEvaluate(graded.board));
+      EXPECT_EQ(0.0, LevelDistance(graded.score, LEVEL::EASY));
+
+      // out of time, the board closest to the level comes back, graded.
+      const auto start = std::chrono::steady_clock::now();
+      graded = GenerateBoardWithin<SudokuBoard>(LEVEL::EXTREME, std::chrono::milliseconds(20));
+      EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+      EXPECT_TRUE(IsSolutionUnique(graded.board));
+      EXPECT_TRUE(graded.level == LevelEvaluate(graded.board));
+
+      std::atomic<bool> cancelled{true};
+      graded = GenerateBoardWithin<SudokuBoard>(LEVEL::EXTREME, std::chrono::minutes(1), 32, nullptr, &cancelled);
+      EXPECT_TRUE(LEVEL::NO_SOLUTION == graded.level);
+    }
+    TEST(SudokuEngineUnitTesting, solutionenumeration)
+    {
+      SudokuBoard board;
+      board.loadFromFile("unsolved.board");
+      // the first band left vacant on the solution: a few ways to fill it in.
+      board = SearchSolution(board)[0];
+      for(unsigned int index = 0; index < 27; ++index)
+        board[index / 9][index % 9].reset();
+      std::vector<SudokuBoard> solutions;
+      const uint64_t num_of_solutions = EnumerateSolutions(board, [&solutions](const SudokuBoard & solution)
+      {
+        EXPECT_TRUE(IsBoardSolved(solution));
+        solutions.push_back(solution);
+        return true;
+      });
+      EXPECT_GT(num_of_solutions, 1u);
+      EXPECT_EQ(num_of_solutions, CountSolutions(board));
+      ASSERT_EQ(num_of_solutions, solutions.size());
+      for(std::size_t n = 1; n < solutions.size(); ++n)
+        EXPECT_FALSE(solutions[n] == solutions[n - 1]);
+
+      // the visitor stops the enumeration.
+      SudokuBoard first_solution;
+      EXPECT_EQ(1u, EnumerateSolutions(board, [&first_solution](const SudokuBoard & solution)
+      {
+        first_solution = solution;
+        return false;
+      }));
+      EXPECT_TRUE(first_solution == SearchSolution(board, nullptr, nullptr, std::true_type())[0]);
+      std::atomic<bool> cancelled{true};
+      EXPECT_EQ(0u, EnumerateSolutions(board, [](const SudokuBoard &) { return true; }, nullptr, &cancelled));
+
+      board.loadFromFile("unsolvable.board");
+      EXPECT_EQ(CountSolutions(board), EnumerateSolutions(board, [](const SudokuBoard &) { return true; }));
+      unsigned int num_of_visits = 0;
+      EXPECT_EQ(100u, EnumerateSolutions(SudokuBoard{}, [&num_of_visits](const SudokuBoard &)
+      {
+        return ++num_of_visits < 100;
+      }));
+    }
+    TEST(SudokuEngineUnitTesting, asyncgeneration)
+    {
+      BoardGeneration<SudokuBoard> generation(LEVEL::EASY);
+      EXPECT_TRUE(LEVEL::EASY == generation.level());
+      ASSERT_TRUE(generation.waitFor(std::chrono::seconds(60)));
+      EXPECT_TRUE(generation.isReady());
+      // the pipe is written right after the board is set.
+      pollfd ready_file{generation.readyFd(), POLLIN, 0};
+      EXPECT_EQ(1, poll(&ready_file, 1, 1000));
+      SudokuBoard board = generation.get();
+      EXPECT_TRUE(LEVEL::EASY == LevelEvaluate<SudokuBoard>(board));
+      EXPECT_GE(GenerationProgress::read(generation.progress().final_boards), 1u);
+
+      // a cancelled generation is over at once, without a board.
+      BoardGeneration<ColossalSudokuBoard> cancelled_generation(LEVEL::EXTREME);
+      cancelled_generation.cancel();
+      ASSERT_TRUE(cancelled_generation.isReady());
+      EXPECT_THROW(cancelled_generation.get(), std::runtime_error);
+    }
+
+    TEST(SudokuEngineUnitTesting, firstresultrace)
+    {
+      // the first offer wins, and stops the others.
+      FirstResultRace<int> race;
+      std::future<int> result = race.takeFuture();
+      EXPECT_FALSE(race.isOver());
+      EXPECT_FALSE(race.stopFlag().load());
+      EXPECT_TRUE(race.offer(1));
+      EXPECT_FALSE(race.offer(2));
+      race.cancel();
+      EXPECT_TRUE(race.isOver());
+      EXPECT_TRUE(race.stopFlag().load());
+      EXPECT_EQ(1, result.get());
+
+      // runners racing: only one of them wins.
+      std::shared_ptr<FirstResultRace<unsigned int>> runners_race = std::make_shared<FirstResultRace<unsigned int>>();
+      std::future<unsigned int> winner = runners_race->takeFuture();
+      std::shared_ptr<std::atomic<unsigned int>> num_of_wins = std::make_shared<std::atomic<unsigned int>>(0);
+      std::shared_ptr<std::atomic<unsigned int>> num_of_done = std::make_shared<std::atomic<unsigned int>>(0);
+      RunRace(runners_race, 8, [num_of_wins, num_of_done](unsigned int runner, FirstResultRace<unsigned int> & runner_race)
+      {
+        if(runner_race.offer(runner))
+          ++*num_of_wins;
+        ++*num_of_done;
+      });
+      EXPECT_LT(winner.get(), 8u);
+      // the future is ready before the winner counts its win: wait for every runner.
+      while(num_of_done->load() < 8)
+        std::this_thread::yield();
+      EXPECT_EQ(1u, num_of_wins->load());
+
+      // runners all done without a result.
+      std::shared_ptr<FirstResultRace<int>> lost_race = std::make_shared<FirstResultRace<int>>();
+      std::future<int> nothing = lost_race->takeFuture();
+      RunRace(lost_race, 3, [](unsigned int, FirstResultRace<int> &) {});
+      EXPECT_THROW(nothing.get(), std::runtime_error);
+    }
+
+    TEST(SudokuEngineUnitTesting, portfoliosearch)
+    {
+      SudokuBoard board;
+      board.loadFromFile("unsolved.board");
+      std::vector<SudokuBoard> solutions = SearchSolutionPortfolio<SudokuBoard>(board);
+      ASSERT_EQ(1u, solutions.size());
+      EXPECT_TRUE(solutions[0] == SearchSolution<SudokuBoard>(board)[0]);
+      EXPECT_EQ(2u, SearchSolutionPortfolio<SudokuBoard>(SudokuBoard{}).size());
+      SudokuBoard invalid_board{board};
+      invalid_board[0][0] = invalid_board[0][1] = 5;
+      EXPECT_TRUE(SearchSolutionPortfolio<SudokuBoard>(invalid_board).empty());
+
+      // both searches give up once cancelled.
+      std::atomic<bool> cancelled{true};
+      EXPECT_TRUE(SearchSolution<SudokuBoard>(SudokuBoard{}, nullptr, nullptr, std::false_type(), &cancelled).empty());
+      EXPECT_TRUE(SearchSolution<SudokuBoard>(board, nullptr, nullptr, std::true_type(), &cancelled).empty());
+
+      // wide boards are searched on the most constrained cell only.
+      GiantSudokuBoard giant_board;
+      EXPECT_EQ(2u, SearchSolutionPortfolio<GiantSudokuBoard>(giant_board).size());
+    }
+    TEST(SudokuEngineUnitTesting, generatedboardhash)
+    {
+      // the hash kept on the way must be the one of the cells handed out.
+      auto expect_hash_kept = [](const SudokuBoard & board)
+      {
+        SudokuBoard copy{board};
+        EXPECT_EQ(board.hash(), copy.rehash());
+      };
+      SudokuBoard board = GenerateSolvableBoard<SudokuBoard>(LEVEL::MEDIUM);
+      expect_hash_kept(board);
+      expect_hash_kept(GenerateSolvableBoard<SudokuBoard>(LEVEL::HARD, 81 / 2.5, nullptr, nullptr, nullptr, 3,
+                                                          Symmetry::rotational));
+      expect_hash_kept(GenerateBoardFromMask<SudokuBoard>(std::vector<bool>(81, true), LEVEL::EASY));
+      expect_hash_kept(GenerateMinimalBoard<SudokuBoard>(17, 24));
+      expect_hash_kept(GenerateBoardWithin<SudokuBoard>(LEVEL::HARD, std::chrono::seconds(10)).board);
+      for(const SudokuBoard & solution : SearchSolution<SudokuBoard>(board, nullptr, nullptr, std::false_type()))
+        expect_hash_kept(solution);
+      for(const SudokuBoard & solution : SearchSolution<SudokuBoard>(board, nullptr, nullptr, std::true_type()))
+        expect_hash_kept(solution);
+      for(const SudokuBoard & solution : SolveWithinBudget(board, SolveBudget()).solutions)
+        expect_hash_kept(solution);
+      EnumerateSolutions(board, [&expect_hash_kept](const SudokuBoard & solution)
+      {
+        expect_hash_kept(solution);
+        return true;
+      });
+
+      const SudokuBoard final_board = GenerateFinalBoard<SudokuBoard>();
+      board = final_board;
+      DigToLevel(board, LEVEL::EXTREME, 81);
+      expect_hash_kept(board);
+      ClimbToLevel(board, final_board, LEVEL::SAMURAI, 40, LEVEL_CLIMB_STEPS);
+      expect_hash_kept(board);
+    }
   }
 }
 